@@ -0,0 +1,44 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+#include "LogicPublicTypes.h"
+#include "AnalyzerSettings.h"
+#include "AnalyzerResults.h"
+#include "SimulationChannelDescriptor.h"
+#include "AnalyzerChannelData.h"
+struct AnalyzerData;
+class ANALYZER_EXPORT Analyzer
+{
+public:
+	Analyzer();
+	virtual ~Analyzer() = 0;
+	virtual void WorkerThread() = 0;
+	virtual U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels ) = 0;
+	virtual U32 GetMinimumSampleRateHz() = 0;
+	virtual const char* GetAnalyzerName() const = 0;
+	virtual bool NeedsRerun() = 0;
+	virtual void SetupResults();
+	void SetAnalyzerSettings( AnalyzerSettings* settings );
+	void KillThread();
+	AnalyzerChannelData* GetAnalyzerChannelData( Channel& channel );
+	void ReportProgress( U64 sample_number );
+	void SetAnalyzerResults( AnalyzerResults* analyzer_results );
+	U32 GetSimulationSampleRate();
+	U32 GetSampleRate();
+	U64 GetTriggerSample();
+	void CheckIfThreadShouldExit();
+	double GetAnalyzerProgress();
+	void SetAnalyzerData( AnalyzerData* analyzer_data );
+	AnalyzerData* GetAnalyzerData();
+	void StartProcessing();
+	void StopWorkerThread();
+	virtual bool GetAnalyzerResults( AnalyzerResults** analyzer_results );
+protected:
+	struct AnalyzerData* mData;
+};
+class ANALYZER_EXPORT Analyzer2 : public Analyzer
+{
+public:
+	Analyzer2();
+	virtual void SetupResults();
+};
+#endif
@@ -0,0 +1,26 @@
+#ifndef ANALYZERCHANNELDATA
+#define ANALYZERCHANNELDATA
+#include "LogicPublicTypes.h"
+#include <vector>
+struct AnalyzerChannelDataData;
+class ChannelData;
+class AnalyzerChannelData
+{
+public:
+	AnalyzerChannelData( ChannelData* channel_data );
+	~AnalyzerChannelData();
+	U64 GetSampleNumber();
+	BitState GetBitState();
+	U32 Advance( U32 num_samples );
+	U32 AdvanceToAbsPosition( U64 sample_number );
+	void AdvanceToNextEdge();
+	U64 GetSampleOfNextEdge();
+	bool WouldAdvancingCauseTransition( U32 num_samples );
+	bool WouldAdvancingToAbsPositionCauseTransition( U64 sample_number );
+	void TrackMinimumPulseWidth();
+	U64 GetMinimumPulseWidthSoFar();
+	bool DoMoreTransitionsExistInCurrentData();
+protected:
+	struct AnalyzerChannelDataData* mData;
+};
+#endif
@@ -0,0 +1,61 @@
+#ifndef ANALYZER_RESULTS
+#define ANALYZER_RESULTS
+#include <LogicPublicTypes.h>
+#include "AnalyzerTypes.h"
+#include <string>
+#define DISPLAY_AS_ERROR_FLAG ( 1 << 7 )
+#define DISPLAY_AS_WARNING_FLAG ( 1 << 6 )
+#define INVALID_RESULT_INDEX 0xFFFFFFFFFFFFFFFFull
+class Frame
+{
+public:
+	Frame(); Frame( const Frame& frame ); ~Frame();
+	S64 mStartingSampleInclusive;
+	S64 mEndingSampleInclusive;
+	U64 mData1;
+	U64 mData2;
+	U8 mType;
+	U8 mFlags;
+	bool HasFlag( U8 flag );
+};
+struct AnalyzerResultsData;
+class AnalyzerResults
+{
+public:
+	enum MarkerType { Dot, ErrorDot, Square, ErrorSquare, UpArrow, DownArrow, X, ErrorX, Start, Stop, One, Zero };
+	AnalyzerResults();
+	virtual ~AnalyzerResults();
+	virtual void GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base ) = 0;
+	virtual void GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id ) = 0;
+	virtual void GenerateFrameTabularText( U64 frame_index, DisplayBase display_base ) = 0;
+	virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base ) = 0;
+	virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base ) = 0;
+	void AddMarker( U64 sample_number, MarkerType marker_type, Channel& channel );
+	U64 AddFrame( const Frame& frame );
+	U64 CommitPacketAndStartNewPacket();
+	void CancelPacketAndStartNewPacket();
+	void AddPacketToTransaction( U64 transaction_id, U64 packet_id );
+	void AddChannelBubblesWillAppearOn( const Channel& channel );
+	void CommitResults();
+	U64 GetNumFrames();
+	U64 GetNumPackets();
+	Frame GetFrame( U64 frame_id );
+	U64 GetPacketContainingFrame( U64 frame_id );
+	U64 GetPacketContainingFrameSequential( U64 frame_id );
+	void GetFramesContainedInPacket( U64 packet_id, U64* first_frame_id, U64* last_frame_id );
+	U32 GetTransactionContainingPacket( U64 packet_id );
+	void GetPacketsContainedInTransaction( U64 transaction_id, U64** packet_id_array, U64* packet_id_count );
+	void ClearTabularText();
+	void AddTabularText( const char* str1, const char* str2 = NULL, const char* str3 = NULL, const char* str4 = NULL, const char* str5 = NULL, const char* str6 = NULL );
+	void ClearResultStrings();
+	void AddResultString( const char* str1, const char* str2 = NULL, const char* str3 = NULL, const char* str4 = NULL, const char* str5 = NULL, const char* str6 = NULL );
+	bool UpdateExportProgressAndCheckForCancel( U64 completed_frames, U64 total_frames );
+	bool GetFramesInRange( S64 starting_sample_inclusive, S64 ending_sample_inclusive, U64* first_frame_index, U64* last_frame_index );
+	bool DoBubblesAppearOnChannel( Channel& channel );
+	bool DoMarkersAppearOnChannel( Channel& channel );
+	U64 GetNumMarkers( Channel& channel );
+	void GetMarker( Channel& channel, U64 marker_index, MarkerType* marker_type, U64* marker_sample );
+protected:
+	struct AnalyzerResultsData* mData;
+};
+#endif
@@ -0,0 +1,23 @@
+#ifndef LOGICPUBLICTYPES
+#define LOGICPUBLICTYPES
+#ifndef WIN32
+	#define __cdecl
+	#define __stdcall
+	#define __fastcall
+#endif
+#define ANALYZER_EXPORT __attribute__ ((visibility("default")))
+#define LOGICAPI
+typedef signed char S8;
+typedef signed short S16;
+typedef signed int S32;
+typedef signed long long int S64;
+typedef unsigned char U8;
+typedef unsigned short U16;
+typedef unsigned int U32;
+typedef unsigned long long int U64;
+enum DisplayBase { Binary, Decimal, Hexadecimal, ASCII, AsciiHex };
+enum BitState { BIT_LOW, BIT_HIGH };
+#define Toggle(x) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+#define Invert(x) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+#define UNDEFINED_CHANNEL Channel( 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFF )
+#endif
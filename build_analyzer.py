@@ -1,4 +1,4 @@
-import os, glob, platform
+import os, glob, platform, sys
 
 #find out if we're running on mac or linux and set the dynamic library extension
 dylib_ext = ""
@@ -45,6 +45,16 @@ link_dependencies = [ "-lAnalyzer" ] #refers to libAnalyzer.dylib or libAnalyzer
 debug_compile_flags = "-O0 -w -c -fpic -g"
 release_compile_flags = "-O3 -w -c -fpic"
 
+#--instrumented compiles in the decoder counters and phase timers (see RFFEInstrumentation.h)
+if "--instrumented" in sys.argv:
+    debug_compile_flags += " -DRFFE_INSTRUMENTATION"
+    release_compile_flags += " -DRFFE_INSTRUMENTATION"
+
+#--generic-decode reads fields through the runtime length bit loop instead of the per-width templates, to compare them
+if "--generic-decode" in sys.argv:
+    debug_compile_flags += " -DRFFE_GENERIC_DECODE"
+    release_compile_flags += " -DRFFE_GENERIC_DECODE"
+
 #loop through all the cpp files, build up the gcc command line, and attempt to compile each cpp file
 for cpp_file in cpp_files:
 
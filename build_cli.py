@@ -0,0 +1,77 @@
+import os, glob, platform, sys
+
+#builds release/rffe_decode, the command-line decoder (see "Command-line decoder" in README.md)
+#it is the analyzer from /source with the SDK runtime of /cli in place of libAnalyzer, so it runs without Logic
+print("Running on " + platform.system())
+
+if platform.system().lower() == "windows":
+    print("the command-line decoder needs a POSIX system (Linux or macOS)")
+    sys.exit( 1 )
+
+#make sure the release folder exists, and clean out the decoder's .o files if there are any
+if not os.path.exists( "release/cli" ):
+    os.makedirs( "release/cli" )
+
+os.chdir( "release/cli" )
+for o_file in glob.glob( "*.o" ):
+    os.remove( o_file )
+os.chdir( "../.." )
+
+#all the cpp files of the analyzer and of the decoder
+cpp_files = [ "source/" + cpp_file for cpp_file in sorted( os.listdir( "source" ) ) if cpp_file.endswith( ".cpp" ) ]
+cpp_files += [ "cli/" + cpp_file for cpp_file in sorted( os.listdir( "cli" ) ) if cpp_file.endswith( ".cpp" ) ]
+
+#specify the search paths/dependencies/options for gcc
+include_paths = [ "./AnalyzerSDK/include", "./source", "./cli" ]
+link_dependencies = [ "-lpthread" ]
+
+#sprintf_s is the MSVC name the analyzer sources use
+release_compile_flags = "-O3 -w -c -std=c++11 -Dsprintf_s=snprintf"
+
+#--instrumented compiles in the decoder counters and phase timers (see RFFEInstrumentation.h)
+if "--instrumented" in sys.argv:
+    release_compile_flags += " -DRFFE_INSTRUMENTATION"
+
+#--generic-decode reads fields through the runtime length bit loop instead of the per-width templates, to compare them
+if "--generic-decode" in sys.argv:
+    release_compile_flags += " -DRFFE_GENERIC_DECODE"
+
+o_files = []
+for cpp_file in cpp_files:
+
+    #g++
+    command = "g++ "
+
+    #include paths
+    for path in include_paths:
+        command += "-I\"" + path + "\" "
+
+    o_file = "release/cli/" + os.path.basename( cpp_file ).replace( ".cpp", ".o" )
+    o_files.append( o_file )
+
+    release_command = command
+    release_command += release_compile_flags
+    release_command += " -o\"" + o_file + "\" " #the output file
+    release_command += "\"" + cpp_file + "\"" #the cpp file to compile
+
+    #run the command from the command line
+    print(release_command)
+    if os.system( release_command ) != 0:
+        sys.exit( 1 )
+
+#lastly, link
+#g++
+command = "g++ -o release/rffe_decode "
+
+#add all the object files to link
+for o_file in o_files:
+    command += o_file + " "
+
+#add libraries to link against
+for link_dependency in link_dependencies:
+    command += link_dependency + " "
+
+#run the command from the command line
+print(command)
+if os.system( command ) != 0:
+    sys.exit( 1 )
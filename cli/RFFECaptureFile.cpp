@@ -0,0 +1,562 @@
+#include "RFFECaptureFile.h"
+#include <algorithm>
+#include <cmath>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// how far a channel reads before the pages behind all channels are dropped
+#define RFFE_CAPTURE_RELEASE_BYTES  ( 64ULL << 20 )
+
+static bool IsLineEnd( U8 c )
+{
+    return c == '\n' || c == '\r';
+}
+
+// decimal number with optional sign, fraction and exponent, as Logic writes
+// times; the mapped data has no terminating zero, so no strtod
+static bool ParseNumber( const U8* data, U64 size, U64* offset, double* value )
+{
+    U64 i = *offset;
+    bool negative = false;
+    double mantissa = 0;
+    int exponent = 0;
+    bool digits = false;
+
+    if ( i < size && ( data[i] == '-' || data[i] == '+' ) )
+    {
+        negative = data[i++] == '-';
+    }
+    for ( ; i < size && data[i] >= '0' && data[i] <= '9'; i++ )
+    {
+        mantissa = mantissa * 10 + ( data[i] - '0' );
+        digits = true;
+    }
+    if ( i < size && data[i] == '.' )
+    {
+        for ( i++; i < size && data[i] >= '0' && data[i] <= '9'; i++ )
+        {
+            mantissa = mantissa * 10 + ( data[i] - '0' );
+            exponent--;
+            digits = true;
+        }
+    }
+    if ( !digits )
+    {
+        return false;
+    }
+    if ( i < size && ( data[i] == 'e' || data[i] == 'E' ) )
+    {
+        U64 e = i + 1;
+        bool negative_exponent = false;
+        int value_exponent = 0;
+
+        if ( e < size && ( data[e] == '-' || data[e] == '+' ) )
+        {
+            negative_exponent = data[e++] == '-';
+        }
+        if ( e < size && data[e] >= '0' && data[e] <= '9' )
+        {
+            for ( ; e < size && data[e] >= '0' && data[e] <= '9'; e++ )
+            {
+                value_exponent = value_exponent * 10 + ( data[e] - '0' );
+            }
+            exponent += negative_exponent ? -value_exponent : value_exponent;
+            i = e;
+        }
+    }
+
+    *value = ( negative ? -mantissa : mantissa ) * std::pow( 10.0, exponent );
+    *offset = i;
+    return true;
+}
+
+RFFECaptureFile::RFFECaptureFile()
+:   mFormat( FormatCsv ),
+    mWordBytes( 0 ),
+    mRecordBytes( 0 ),
+    mSampleRate( 0 ),
+    mTriggerSample( 0 ),
+    mFirstSample( 0 ),
+    mLastSample( 0 ),
+    mDataOffset( 0 ),
+    mDataEnd( 0 ),
+    mCsvSeconds( false ),
+    mCsvOffset( 0 ),
+    mReleased( 0 ),
+    mFile( -1 ),
+    mData( NULL ),
+    mSize( 0 )
+{
+}
+
+RFFECaptureFile::~RFFECaptureFile()
+{
+    Close();
+}
+
+void RFFECaptureFile::Close()
+{
+    if ( mFile >= 0 )
+    {
+        if ( mData != NULL )
+        {
+            munmap( (void*)mData, size_t( mSize ) );
+        }
+        close( mFile );
+        mFile = -1;
+    }
+    mData = NULL;
+}
+
+void RFFECaptureFile::Reset( Format format, U32 word_bytes, U32 sample_rate, U64 trigger_sample )
+{
+    Close();
+    mFormat        = format;
+    mWordBytes     = word_bytes;
+    mSampleRate    = sample_rate;
+    mTriggerSample = trigger_sample;
+    mFirstSample   = 0;
+    mLastSample    = 0;
+    mDataOffset    = 0;
+    mDataEnd       = 0;
+    mCsvOffset     = 0;
+    mChannels.clear();
+    mEdges.clear();
+    mReaders.clear();
+    mReleased      = 0;
+    mSize          = 0;
+}
+
+bool RFFECaptureFile::Open( const char* file, Format format, U32 word_bytes, U32 sample_rate, U64 trigger_sample, std::string* error )
+{
+    struct stat st;
+
+    Reset( format, word_bytes, sample_rate, trigger_sample );
+    mFile = open( file, O_RDONLY );
+    if ( mFile < 0 || fstat( mFile, &st ) != 0 )
+    {
+        *error = std::string( "cannot open " ) + file + ": " + strerror( errno );
+        return false;
+    }
+    mSize = U64( st.st_size );
+    if ( mSize == 0 )
+    {
+        *error = std::string( file ) + " is empty";
+        return false;
+    }
+    void* data = mmap( NULL, size_t( mSize ), PROT_READ, MAP_SHARED, mFile, 0 );
+    if ( data == MAP_FAILED )
+    {
+        *error = std::string( "cannot map " ) + file + ": " + strerror( errno );
+        return false;
+    }
+    mData = (const U8*)data;
+    madvise( data, size_t( mSize ), MADV_SEQUENTIAL );
+
+    return ReadHeader( error );
+}
+
+bool RFFECaptureFile::OpenMemory( const void* data, U64 size, Format format, U32 word_bytes, U32 sample_rate, U64 trigger_sample, std::string* error )
+{
+    Reset( format, word_bytes, sample_rate, trigger_sample );
+    mData = (const U8*)data;
+    mSize = size;
+    if ( mSize == 0 )
+    {
+        *error = "the capture is empty";
+        return false;
+    }
+    return ReadHeader( error );
+}
+
+void RFFECaptureFile::OpenEdges( U32 sample_rate, U64 trigger_sample, U64 last_sample )
+{
+    Reset( FormatEdges, 0, sample_rate, trigger_sample );
+    mLastSample = last_sample;
+}
+
+void RFFECaptureFile::AddEdgeChannel( U32 channel_index, const U64* edges, U64 count, BitState initial_state )
+{
+    EdgeChannel channel;
+
+    channel.mEdges        = edges;
+    channel.mCount        = count;
+    channel.mInitialState = initial_state;
+    mChannels.push_back( channel_index );
+    mEdges.push_back( channel );
+    if ( count != 0 )
+    {
+        mLastSample = std::max( mLastSample, edges[count - 1] );
+    }
+}
+
+bool RFFECaptureFile::GetEdges( int bit, const U64** edges, U64* count, BitState* initial_state ) const
+{
+    if ( mFormat != FormatEdges )
+    {
+        return false;
+    }
+    *edges         = mEdges[bit].mEdges;
+    *count         = mEdges[bit].mCount;
+    *initial_state = mEdges[bit].mInitialState;
+    return true;
+}
+
+bool RFFECaptureFile::ReadHeader( std::string* error )
+{
+    if ( mFormat == FormatCsv )
+    {
+        return ReadCsvHeader( error );
+    }
+
+    if ( mWordBytes != 1 && mWordBytes != 2 && mWordBytes != 4 && mWordBytes != 8 )
+    {
+        *error = "the word size of a binary capture is 1, 2, 4 or 8 bytes";
+        return false;
+    }
+    mRecordBytes = mFormat == FormatBinaryOnChange ? 8 + mWordBytes : mWordBytes;
+    if ( mSize < mRecordBytes )
+    {
+        *error = "the capture holds no complete record";
+        return false;
+    }
+    for ( U32 i = 0; i < mWordBytes * 8; i++ )
+    {
+        mChannels.push_back( i );
+    }
+
+    // a partial record at the end (a capture still being written) is left out
+    mDataEnd = mSize / mRecordBytes * mRecordBytes;
+
+    U64 offset = 0;
+    U64 bits;
+    ReadRecord( &offset, &mFirstSample, &bits );
+    offset = mDataEnd - mRecordBytes;
+    ReadRecord( &offset, &mLastSample, &bits );
+    return true;
+}
+
+// "Time [s], Channel 0, Channel 1, ..."; the channel index is the number
+// at the end of a column name, its position for other names
+bool RFFECaptureFile::ReadCsvHeader( std::string* error )
+{
+    U64 end = 0;
+    while ( end < mSize && !IsLineEnd( mData[end] ) )
+    {
+        end++;
+    }
+
+    std::string header( (const char*)mData, size_t( end ) );
+    std::vector< std::string > columns;
+    size_t start = 0;
+    for ( ; ; )
+    {
+        size_t comma = header.find( ',', start );
+        columns.push_back( header.substr( start, comma == std::string::npos ? std::string::npos : comma - start ) );
+        if ( comma == std::string::npos )
+            break;
+        start = comma + 1;
+    }
+    if ( columns.size() < 2 || columns.size() > 65 )
+    {
+        *error = "a CSV export needs a time column and 1 to 64 channel columns";
+        return false;
+    }
+
+    std::string first = columns[0];
+    std::transform( first.begin(), first.end(), first.begin(), ::tolower );
+    mCsvSeconds = first.find( "time" ) != std::string::npos;
+    if ( mCsvSeconds && mSampleRate == 0 )
+    {
+        *error = "the sample rate of a CSV export with times is needed";
+        return false;
+    }
+
+    for ( size_t i = 1; i < columns.size(); i++ )
+    {
+        const std::string& name = columns[i];
+        size_t digits = name.find_last_not_of( " \t\"" );
+        size_t last = digits;
+        while ( digits != std::string::npos && digits > 0 && isdigit( (U8)name[digits] ) )
+        {
+            digits--;
+        }
+        if ( last != std::string::npos && isdigit( (U8)name[last] ) )
+        {
+            mChannels.push_back( U32( strtoul( name.substr( digits + 1, last - digits ).c_str(), NULL, 10 ) ) );
+        }
+        else
+        {
+            mChannels.push_back( U32( i - 1 ) );
+        }
+    }
+
+    while ( end < mSize && IsLineEnd( mData[end] ) )
+    {
+        end++;
+    }
+    mDataOffset = end;
+
+    // as is a partial row at the end
+    mDataEnd = mSize;
+    while ( mDataEnd > mDataOffset && !IsLineEnd( mData[mDataEnd - 1] ) )
+    {
+        mDataEnd--;
+    }
+
+    // times before the trigger are negative: the first row becomes sample 0
+    U64 offset = mDataOffset;
+    U64 sample;
+    U64 bits;
+    double first_time;
+    if ( !ParseNumber( mData, mDataEnd, &offset, &first_time ) )
+    {
+        *error = "the CSV export has no data rows";
+        return false;
+    }
+    double first_sample = mCsvSeconds ? first_time * mSampleRate : first_time;
+    if ( first_sample < 0 )
+    {
+        mCsvOffset = -first_sample;
+        if ( mCsvSeconds )
+        {
+            mTriggerSample = U64( std::floor( mCsvOffset + 0.5 ) );
+        }
+    }
+
+    offset = mDataOffset;
+    ReadCsvRecord( &offset, &mFirstSample, &bits );
+
+    // the last row gives the end of the capture
+    U64 last = mDataEnd;
+    while ( last > mDataOffset && IsLineEnd( mData[last - 1] ) )
+    {
+        last--;
+    }
+    while ( last > mDataOffset && !IsLineEnd( mData[last - 1] ) )
+    {
+        last--;
+    }
+    offset = last;
+    mLastSample = ReadCsvRecord( &offset, &sample, &bits ) ? sample : mFirstSample;
+    return true;
+}
+
+bool RFFECaptureFile::ReadCsvRecord( U64* offset, U64* sample, U64* bits ) const
+{
+    U64 i = *offset;
+    double time;
+
+    while ( i < mDataEnd && IsLineEnd( mData[i] ) )
+    {
+        i++;
+    }
+    if ( !ParseNumber( mData, mDataEnd, &i, &time ) )
+    {
+        return false;
+    }
+
+    double position = ( mCsvSeconds ? time * mSampleRate : time ) + mCsvOffset;
+    *sample = position > 0 ? U64( std::floor( position + 0.5 ) ) : 0;
+    *bits = 0;
+    for ( U32 bit = 0; bit < mChannels.size(); bit++ )
+    {
+        while ( i < mDataEnd && ( mData[i] == ',' || mData[i] == ' ' || mData[i] == '\t' ) )
+        {
+            i++;
+        }
+        if ( i < mDataEnd && mData[i] == '1' )
+        {
+            *bits |= U64( 1 ) << bit;
+        }
+        while ( i < mDataEnd && mData[i] != ',' && !IsLineEnd( mData[i] ) )
+        {
+            i++;
+        }
+    }
+    while ( i < mDataEnd && !IsLineEnd( mData[i] ) )
+    {
+        i++;
+    }
+    *offset = i;
+    return true;
+}
+
+int RFFECaptureFile::GetChannelBit( U32 channel_index ) const
+{
+    for ( U32 bit = 0; bit < mChannels.size(); bit++ )
+    {
+        if ( mChannels[bit] == channel_index )
+        {
+            return int( bit );
+        }
+    }
+    return -1;
+}
+
+bool RFFECaptureFile::ReadRecord( U64* offset, U64* sample, U64* bits ) const
+{
+    if ( mFormat == FormatCsv )
+    {
+        return ReadCsvRecord( offset, sample, bits );
+    }
+    if ( *offset + mRecordBytes > mDataEnd )
+    {
+        return false;
+    }
+
+    const U8* record = mData + *offset;
+    U64 word = 0;
+
+    if ( mFormat == FormatBinaryOnChange )
+    {
+        memcpy( sample, record, 8 );
+        record += 8;
+    }
+    else
+    {
+        *sample = *offset / mRecordBytes;
+    }
+    memcpy( &word, record, mWordBytes );     // little endian, as Logic writes it
+    *bits = word;
+    *offset += mRecordBytes;
+    return true;
+}
+
+void RFFECaptureFile::AddChannel( const RFFECaptureChannel* channel )
+{
+    mReaders.push_back( channel );
+}
+
+// the mapping stays, only the process gives up the pages; reading them
+// again would fault them back in from the page cache
+void RFFECaptureFile::ReleaseBehindChannels()
+{
+    U64 page = U64( sysconf( _SC_PAGESIZE ) );
+    U64 offset = mSize;
+
+    // memory of the caller stays as it is
+    if ( mFile < 0 )
+    {
+        return;
+    }
+
+    for ( size_t i = 0; i < mReaders.size(); i++ )
+    {
+        offset = std::min( offset, mReaders[i]->GetOffset() );
+    }
+    offset = offset / page * page;
+    if ( offset > mReleased )
+    {
+        madvise( (void*)mData, size_t( offset ), MADV_DONTNEED );
+        mReleased = offset;
+    }
+}
+
+RFFECaptureChannel::RFFECaptureChannel( RFFECaptureFile* capture, int bit )
+:   mCapture( capture ),
+    mMask( U64( 1 ) << bit ),
+    mOffset( capture->GetDataOffset() ),
+    mSample( 0 ),
+    mState( BIT_LOW ),
+    mHasNextEdge( false ),
+    mNextEdge( 0 ),
+    mNextRelease( RFFE_CAPTURE_RELEASE_BYTES ),
+    mEdgeList( false ),
+    mEdges( NULL ),
+    mEdgeCount( 0 )
+{
+    U64 bits = 0;
+
+    mCapture->AddChannel( this );
+    if ( mCapture->GetEdges( bit, &mEdges, &mEdgeCount, &mState ) )
+    {
+        mEdgeList = true;
+        mOffset = 0;
+        FindNextEdge();
+    }
+    else if ( mCapture->ReadRecord( &mOffset, &mSample, &bits ) )
+    {
+        mState = ( bits & mMask ) != 0 ? BIT_HIGH : BIT_LOW;
+        FindNextEdge();
+    }
+}
+
+// the capture may hold records of other channels changing, or a record per
+// sample; skip to the first one where this channel differs
+void RFFECaptureChannel::FindNextEdge()
+{
+    U64 high = mState == BIT_HIGH ? mMask : 0;
+    U64 sample;
+    U64 bits;
+
+    // an edge list: mOffset is the index of the next edge
+    if ( mEdgeList )
+    {
+        mHasNextEdge = mOffset < mEdgeCount;
+        if ( mHasNextEdge )
+        {
+            mNextEdge = mEdges[mOffset++];
+        }
+        return;
+    }
+    if ( mOffset >= mNextRelease )
+    {
+        mCapture->ReleaseBehindChannels();
+        mNextRelease = mOffset + RFFE_CAPTURE_RELEASE_BYTES;
+    }
+    while ( mCapture->ReadRecord( &mOffset, &sample, &bits ) )
+    {
+        if ( ( bits & mMask ) != high )
+        {
+            mHasNextEdge = true;
+            mNextEdge = sample;
+            return;
+        }
+    }
+    mHasNextEdge = false;
+}
+
+// The lines stay as they are past the last sample: a bus park or a pause
+// that reaches beyond the capture ends at its last sample instead of
+// dropping the packet. Only waiting for an edge that never comes throws.
+U32 RFFECaptureChannel::AdvanceToAbsPosition( U64 sample )
+{
+    U32 edges = 0;
+
+    sample = std::min( sample, mCapture->GetLastSample() );
+    while ( mHasNextEdge && mNextEdge <= sample )
+    {
+        mState = mState == BIT_HIGH ? BIT_LOW : BIT_HIGH;
+        edges++;
+        FindNextEdge();
+    }
+    mSample = std::max( mSample, sample );
+    return edges;
+}
+
+void RFFECaptureChannel::AdvanceToNextEdge()
+{
+    if ( !mHasNextEdge )
+    {
+        throw RFFECaptureEnd();
+    }
+    mSample = mNextEdge;
+    mState = mState == BIT_HIGH ? BIT_LOW : BIT_HIGH;
+    FindNextEdge();
+}
+
+U64 RFFECaptureChannel::GetSampleOfNextEdge() const
+{
+    if ( !mHasNextEdge )
+    {
+        throw RFFECaptureEnd();
+    }
+    return mNextEdge;
+}
@@ -0,0 +1,149 @@
+#ifndef RFFE_CAPTURE_FILE
+#define RFFE_CAPTURE_FILE
+
+#include <LogicPublicTypes.h>
+#include <string>
+#include <vector>
+
+class RFFECaptureChannel;
+
+// Thrown when the decoder waits for an edge past the end of the capture,
+// where Logic would wait for the capture to grow.
+struct RFFECaptureEnd
+{
+};
+
+// A digital export of Logic, mapped into memory read-only: pages are read
+// as the decoder gets to them, so captures of any size decode in little
+// memory. The same records can be handed over in memory (OpenMemory), or
+// a list of edges per channel (OpenEdges). Formats:
+//  - FormatCsv: "Time [s]" (or sample number) column and one 0/1 column
+//    per channel, a row per change
+//  - FormatBinaryOnChange: a U64 sample number and a word of channel bits
+//    (bit n: n-th channel) per change
+//  - FormatBinaryEachSample: a word of channel bits per sample
+//  - FormatEdges: per channel, its state at sample 0 and the increasing
+//    sample numbers it changes at
+// Sample numbers start at the first row; the trigger is at time 0 of a CSV
+// with times, otherwise at the given sample.
+class RFFECaptureFile
+{
+public:
+    enum Format
+    {
+        FormatCsv,
+        FormatBinaryOnChange,
+        FormatBinaryEachSample,
+        FormatEdges,
+    };
+
+    RFFECaptureFile();
+    ~RFFECaptureFile();
+
+    bool Open( const char* file, Format format, U32 word_bytes, U32 sample_rate, U64 trigger_sample, std::string* error );
+    // the data must stay until the capture is closed
+    bool OpenMemory( const void* data, U64 size, Format format, U32 word_bytes, U32 sample_rate, U64 trigger_sample, std::string* error );
+    void OpenEdges( U32 sample_rate, U64 trigger_sample, U64 last_sample );
+    void AddEdgeChannel( U32 channel_index, const U64* edges, U64 count, BitState initial_state );
+
+    U32 GetSampleRate() const           { return mSampleRate; }
+    U64 GetTriggerSample() const        { return mTriggerSample; }
+    U64 GetFirstSample() const          { return mFirstSample; }
+    U64 GetLastSample() const           { return mLastSample; }
+    U64 GetSize() const                 { return mSize; }
+    U64 GetDataOffset() const           { return mDataOffset; }
+
+    // bit of the channel in the records, -1 when it is not in the capture
+    int GetChannelBit( U32 channel_index ) const;
+
+    // record at offset (the first one at GetDataOffset()); advances offset
+    // past it, false at the end
+    bool ReadRecord( U64* offset, U64* sample, U64* bits ) const;
+
+    // edge list of the channel at bit, false unless FormatEdges
+    bool GetEdges( int bit, const U64** edges, U64* count, BitState* initial_state ) const;
+
+    // channels reading the capture; the pages all of them are past are
+    // dropped from memory
+    void AddChannel( const RFFECaptureChannel* channel );
+    void ReleaseBehindChannels();
+
+protected:
+    struct EdgeChannel
+    {
+        const U64* mEdges;
+        U64 mCount;
+        BitState mInitialState;
+    };
+
+    void Reset( Format format, U32 word_bytes, U32 sample_rate, U64 trigger_sample );
+    bool ReadHeader( std::string* error );
+    bool ReadCsvHeader( std::string* error );
+    bool ReadCsvRecord( U64* offset, U64* sample, U64* bits ) const;
+    void Close();
+
+    Format mFormat;
+    U32 mWordBytes;
+    U32 mRecordBytes;
+    U32 mSampleRate;
+    U64 mTriggerSample;
+    U64 mFirstSample;
+    U64 mLastSample;
+
+    // records from mDataOffset to mDataEnd; CSV: the times are seconds or
+    // sample numbers
+    U64 mDataOffset;
+    U64 mDataEnd;
+    bool mCsvSeconds;
+    double mCsvOffset;      // added to time * rate (or sample) to give the sample number
+
+    std::vector< U32 > mChannels;   // channel index of bit n
+    std::vector< EdgeChannel > mEdges;
+    std::vector< const RFFECaptureChannel* > mReaders;
+    U64 mReleased;                  // pages before this are dropped
+
+    int mFile;              // -1 for data in memory
+    const U8* mData;
+    U64 mSize;
+};
+
+// Edges of one channel of a capture, the way AnalyzerChannelData hands
+// them to the analyzer: a position, the state there, and the next edge
+// looked up ahead.
+class RFFECaptureChannel
+{
+public:
+    RFFECaptureChannel( RFFECaptureFile* capture, int bit );
+
+    U64 GetSampleNumber() const         { return mSample; }
+    BitState GetBitState() const        { return mState; }
+    U32 AdvanceToAbsPosition( U64 sample );
+    void AdvanceToNextEdge();
+    U64 GetSampleOfNextEdge() const;
+    U64 GetOffset() const               { return mOffset; }
+    bool WouldAdvancingToAbsPositionCauseTransition( U64 sample ) const
+    {
+        return mHasNextEdge && mNextEdge <= sample;
+    }
+    bool DoMoreTransitionsExistInCurrentData() const
+    {
+        return mHasNextEdge;
+    }
+
+protected:
+    void FindNextEdge();
+
+    RFFECaptureFile* mCapture;
+    U64 mMask;
+    U64 mOffset;            // record after the next edge, or index in mEdges
+    U64 mSample;
+    BitState mState;
+    bool mHasNextEdge;
+    U64 mNextEdge;
+    U64 mNextRelease;       // offset to drop the pages behind the channels at
+    bool mEdgeList;         // FormatEdges, mEdges may be NULL when empty
+    const U64* mEdges;
+    U64 mEdgeCount;
+};
+
+#endif //RFFE_CAPTURE_FILE
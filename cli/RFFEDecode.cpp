@@ -0,0 +1,615 @@
+// rffe_decode: decodes Logic digital exports with the RFFE analyzer and
+// writes its export files, without Logic. See "Command-line decoder" in
+// README.md.
+
+#include "RFFEHost.h"
+#include "RFFECaptureFile.h"
+#include "RFFEDiff.h"
+#include "RFFEAnalyzer.h"
+#include "RFFEAnalyzerResults.h"
+#include <AnalyzerSettings.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct DecodeOptions
+{
+    RFFECaptureFile::Format mFormat;
+    U32 mWordBytes;
+    U32 mSampleRate;
+    U64 mTriggerSample;
+    U32 mExportType;
+    std::string mOutputDir;
+    std::vector< std::pair< std::string, std::string > > mSettings;    // title, value
+};
+
+// what one capture gave, a row of the summary
+struct DecodeSummary
+{
+    std::string mCapture;
+    std::string mExport;
+    U64 mSamples;
+    U64 mPackets;
+    U64 mTypes[RFFE_COMMAND_TYPES];
+    U64 mParityErrors;
+    U64 mDecodeErrors;
+    U64 mTimingWarnings;
+    bool mTruncated;
+    double mDecodeSeconds;
+    double mExportSeconds;
+    std::string mError;
+};
+
+static void Usage()
+{
+    fprintf( stderr,
+        "usage: rffe_decode [options] capture...\n"
+        "       rffe_decode --diff [options] A B\n"
+        "       rffe_decode --self-check [-r HZ] [-s TITLE=VALUE...]\n"
+        "  -f csv|binary|binary-each-sample   format of the captures (csv)\n"
+        "  -w BYTES         word size of a binary capture: 1, 2, 4 or 8 (8)\n"
+        "  -r HZ            sample rate of the captures\n"
+        "  -t SAMPLE        trigger sample of a binary capture (0)\n"
+        "  -s TITLE=VALUE   analyzer setting, e.g. -s \"SCLK=2\" -s \"Command Type Filter=ExtRd\"\n"
+        "  -e TYPE          export: 0 csv, 1 csv with repeats collapsed, 2 ndjson, 3 pcapng (0)\n"
+        "  -o DIR           directory of the exports (next to each capture)\n"
+        "  -j N             captures decoded in parallel (one per core)\n"
+        "  --summary FILE   write the summary to FILE as well as to stdout\n"
+        "  --diff           compare the transactions of A and B, each a CSV export or a capture\n"
+        "  --diff-window N  packets that must match again to end a difference (8)\n"
+        "  --diff-lookahead N  packets read ahead to find the match (4096)\n"
+        "  --self-check     decode randomized simulation data and check it against what was generated\n" );
+}
+
+static double SecondsSince( std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+}
+
+// the settings of the command line on top of the analyzer defaults
+static std::vector< std::pair< std::string, std::string > > GetSettingValues( const DecodeOptions& options )
+{
+    std::vector< std::pair< std::string, std::string > > values;
+
+    values.push_back( std::make_pair( std::string( "SCLK" ), std::string( "0" ) ) );
+    values.push_back( std::make_pair( std::string( "SDATA" ), std::string( "1" ) ) );
+    values.insert( values.end(), options.mSettings.begin(), options.mSettings.end() );
+    return values;
+}
+
+static std::string GetExportFileName( AnalyzerSettings* settings, const std::string& capture, const DecodeOptions& options )
+{
+    std::string extension = "csv";
+
+    for ( U32 i = 0; i < settings->GetExportOptionsCount(); i++ )
+    {
+        U32 user_id;
+        const char* menu_text;
+        settings->GetExportOption( i, &user_id, &menu_text );
+        if ( user_id == options.mExportType && settings->GetFileExtensionCount( i ) != 0 )
+        {
+            const char* description;
+            const char* file_extension;
+            settings->GetFileExtension( i, 0, &description, &file_extension );
+            extension = file_extension;
+        }
+    }
+
+    size_t slash = capture.find_last_of( '/' );
+    std::string dir  = slash == std::string::npos ? std::string() : capture.substr( 0, slash + 1 );
+    std::string stem = slash == std::string::npos ? capture : capture.substr( slash + 1 );
+    size_t dot = stem.find_last_of( '.' );
+    if ( dot != std::string::npos && dot != 0 )
+    {
+        stem.erase( dot );
+    }
+    if ( !options.mOutputDir.empty() )
+    {
+        dir = options.mOutputDir + "/";
+    }
+    return dir + stem + ".rffe." + extension;
+}
+
+// Every packet goes to the export and the summary as soon as it is
+// committed; the results keep none of them.
+struct DecodeSink
+{
+    RFFEExporter* mExporter;
+    DecodeSummary* mSummary;
+    double mExportSeconds;      // spent in the exporter while decoding
+};
+
+static void AddPacket( AnalyzerResults* analyzer_results, U64 packet_id, void* context )
+{
+    DecodeSink* sink = (DecodeSink*)context;
+    RFFEAnalyzerResults* results = (RFFEAnalyzerResults*)analyzer_results;
+    RFFEPacket packet;
+    RFFEPacketExtras extras;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    sink->mExporter->Add( packet_id );
+    sink->mExportSeconds += SecondsSince( start );
+
+    results->ReadPacket( packet_id, &packet, &extras );
+    DecodeSummary* summary = sink->mSummary;
+    summary->mPackets++;
+    summary->mTypes[packet.mType] += 1 + extras.mRepeats;
+    if ( packet.mParityErrors != 0 )
+        summary->mParityErrors++;
+    if ( extras.mErrorFrames != 0 )
+        summary->mDecodeErrors++;
+    if ( packet.mTimingViolations != 0 )
+        summary->mTimingWarnings++;
+}
+
+static void DecodeCapture( const std::string& file, const DecodeOptions& options, DecodeSummary* summary )
+{
+    RFFECaptureFile capture;
+    std::string error;
+
+    summary->mCapture = file;
+    if ( !capture.Open( file.c_str(), options.mFormat, options.mWordBytes, options.mSampleRate, options.mTriggerSample, &error ) )
+    {
+        summary->mError = error;
+        return;
+    }
+    summary->mSamples = capture.GetLastSample() - capture.GetFirstSample() + 1;
+
+    Analyzer* analyzer = CreateAnalyzer();
+    AnalyzerSettings* settings = analyzer->GetAnalyzerData()->mSettings;
+    std::unique_ptr< RFFEExporter > exporter;
+    DecodeSink sink;
+    try
+    {
+        if ( !RFFEHostConfigure( settings, GetSettingValues( options ), &error ) )
+        {
+            throw std::runtime_error( error );
+        }
+        RFFEHostAttachCapture( analyzer, &capture );
+        RFFEHostSetPacketSink( analyzer, AddPacket, &sink );
+        analyzer->SetupResults();
+
+        AnalyzerResults* analyzer_results;
+        analyzer->GetAnalyzerResults( &analyzer_results );
+        RFFEAnalyzerResults* results = (RFFEAnalyzerResults*)analyzer_results;
+        summary->mExport = GetExportFileName( settings, file, options );
+        exporter.reset( results->CreateExporter( summary->mExport.c_str(), Hexadecimal, options.mExportType ) );
+        sink.mExporter      = exporter.get();
+        sink.mSummary       = summary;
+        sink.mExportSeconds = 0.0;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        try
+        {
+            analyzer->WorkerThread();
+        }
+        catch ( RFFECaptureEnd& )
+        {
+            // a packet ran past the end: what was committed before it stays
+            summary->mTruncated = true;
+        }
+        summary->mDecodeSeconds = SecondsSince( start ) - sink.mExportSeconds;
+
+        start = std::chrono::steady_clock::now();
+        exporter->Finish();
+        summary->mExportSeconds = sink.mExportSeconds + SecondsSince( start );
+    }
+    catch ( std::exception& e )
+    {
+        summary->mError = e.what();
+    }
+    exporter.reset();
+    DestroyAnalyzer( analyzer );
+}
+
+static void WriteSummary( FILE* out, const std::vector< DecodeSummary >& summaries )
+{
+    fprintf( out, "Capture,Export,Samples,Packets" );
+    for ( U32 type = 0; type < RFFE_COMMAND_TYPES; type++ )
+    {
+        fprintf( out, ",%s", RFFEAnalyzerResults::GetTypeString( type ) );
+    }
+    fprintf( out, ",Parity Errors,Decode Errors,Timing Warnings,Truncated,Decode [s],Export [s],Error\n" );
+
+    for ( size_t i = 0; i < summaries.size(); i++ )
+    {
+        const DecodeSummary& summary = summaries[i];
+        std::string error = summary.mError;
+        std::replace( error.begin(), error.end(), '"', '\'' );
+
+        fprintf( out, "%s,%s,%llu,%llu", summary.mCapture.c_str(), summary.mExport.c_str(),
+                 (unsigned long long)summary.mSamples, (unsigned long long)summary.mPackets );
+        for ( U32 type = 0; type < RFFE_COMMAND_TYPES; type++ )
+        {
+            fprintf( out, ",%llu", (unsigned long long)summary.mTypes[type] );
+        }
+        fprintf( out, ",%llu,%llu,%llu,%d,%.3f,%.3f,\"%s\"\n",
+                 (unsigned long long)summary.mParityErrors, (unsigned long long)summary.mDecodeErrors,
+                 (unsigned long long)summary.mTimingWarnings, summary.mTruncated ? 1 : 0,
+                 summary.mDecodeSeconds, summary.mExportSeconds, error.c_str() );
+    }
+}
+
+static RFFEDiffSource* OpenDiffSource( const std::string& file, const DecodeOptions& options, std::string* error )
+{
+    if ( RFFEDiffExport::IsExport( file.c_str() ) )
+    {
+        RFFEDiffExport* source = new RFFEDiffExport();
+        if ( !source->Open( file.c_str(), error ) )
+        {
+            delete source;
+            return NULL;
+        }
+        return source;
+    }
+    RFFEDiffCapture* source = new RFFEDiffCapture();
+    if ( !source->Open( file.c_str(), options.mFormat, options.mWordBytes, options.mSampleRate, options.mTriggerSample,
+                        GetSettingValues( options ), error ) )
+    {
+        delete source;
+        return NULL;
+    }
+    return source;
+}
+
+static void PrintDiffPacket( const char* side, bool present, U64 index, const RFFEDiffPacket& packet )
+{
+    if ( present )
+        printf( "  %s #%llu at %s: %s\n", side, (unsigned long long)index, packet.mTime, RFFEDiff::Describe( packet ).c_str() );
+    else
+        printf( "  %s ends after %llu packets\n", side, (unsigned long long)index );
+}
+
+// like diff(1): 0 when A and B are the same, 1 when they differ, 2 on trouble
+static int Diff( const std::vector< std::string >& files, const DecodeOptions& options, U32 window, U32 lookahead )
+{
+    std::string error;
+    std::unique_ptr< RFFEDiffSource > a( OpenDiffSource( files[0], options, &error ) );
+    if ( !a )
+    {
+        fprintf( stderr, "rffe_decode: %s: %s\n", files[0].c_str(), error.c_str() );
+        return 2;
+    }
+    std::unique_ptr< RFFEDiffSource > b( OpenDiffSource( files[1], options, &error ) );
+    if ( !b )
+    {
+        fprintf( stderr, "rffe_decode: %s: %s\n", files[1].c_str(), error.c_str() );
+        return 2;
+    }
+
+    RFFEDiff diff( window, lookahead );
+    RFFEDiffResult result;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool ok = diff.Run( a.get(), b.get(), &result, &error );
+    double seconds = SecondsSince( start );
+
+    printf( "A: %s\nB: %s\n", files[0].c_str(), files[1].c_str() );
+    if ( result.mDiverged )
+    {
+        printf( "first difference:\n" );
+        PrintDiffPacket( "A", result.mHasFirstA, result.mFirstA, result.mFirstPacketA );
+        PrintDiffPacket( "B", result.mHasFirstB, result.mFirstB, result.mFirstPacketB );
+    }
+    printf( "Packets A,Packets B,Matched,Changed,Deleted,Inserted,Blocks,Diff [s]\n" );
+    printf( "%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.3f\n",
+            (unsigned long long)result.mPacketsA, (unsigned long long)result.mPacketsB,
+            (unsigned long long)result.mMatched, (unsigned long long)result.mChanged,
+            (unsigned long long)result.mDeleted, (unsigned long long)result.mInserted,
+            (unsigned long long)result.mBlocks, seconds );
+
+    if ( !ok )
+    {
+        fprintf( stderr, "rffe_decode: %s\n", error.c_str() );
+        return 2;
+    }
+    return result.mDiverged ? 1 : 0;
+}
+
+// a self-check run: settings on top of those of the command line
+struct SelfCheckRun
+{
+    const char* mName;
+    std::vector< std::pair< std::string, std::string > > mSettings;
+};
+
+// a short run sizes the one that is timed, which generates at least
+// RFFE_SELF_CHECK_PACKETS whatever the sample rate and SCLK
+#define RFFE_SELF_CHECK_PILOT_SAMPLES   10000000
+#define RFFE_SELF_CHECK_PACKETS         1000000
+
+// the self-check compares the packets inside the analyzer, the results
+// need not keep them
+static void DropPacket( AnalyzerResults*, U64, void* )
+{
+}
+
+// One round trip over samples of simulation data; false with the reason
+// in error when the decode or the check fails.
+static bool RunSelfCheck( const DecodeOptions& options, const SelfCheckRun& run, U64 samples,
+                          U64* packets, double* seconds, std::string* error )
+{
+    std::vector< std::pair< std::string, std::string > > values = GetSettingValues( options );
+    values.push_back( std::make_pair( std::string( "Simulation Data" ), std::string( "Randomized (self-check)" ) ) );
+    values.insert( values.end(), run.mSettings.begin(), run.mSettings.end() );
+
+    RFFECaptureFile capture;
+    RFFEAnalyzer* analyzer = (RFFEAnalyzer*)CreateAnalyzer();
+    bool passed = false;
+    try
+    {
+        if ( !RFFEHostConfigure( analyzer->GetAnalyzerData()->mSettings, values, error ) )
+        {
+            throw std::runtime_error( *error );
+        }
+        RFFEHostSimulate( analyzer, options.mSampleRate, samples, &capture );
+        RFFEHostSetPacketSink( analyzer, DropPacket, NULL );
+        analyzer->SetupResults();
+        analyzer->WorkerThread();
+        passed = analyzer->GetSelfCheck().HasPassed();
+        *packets = analyzer->GetSelfCheck().GetPacketCount();
+        *seconds = analyzer->GetSelfCheck().GetSecondsPerMillionPackets();
+        if ( !passed )
+        {
+            *error = analyzer->GetSelfCheck().GetReport();
+        }
+    }
+    catch ( RFFECaptureEnd& )
+    {
+        *error = "the decode ran past the end of the simulation data";
+    }
+    catch ( std::exception& e )
+    {
+        *error = e.what();
+    }
+    DestroyAnalyzer( analyzer );
+    return passed;
+}
+
+// Round trip without Logic: every run generates randomized simulation data,
+// decodes it as a capture and compares each packet with what was generated.
+// One line per run with its packets and decode time; 0 when all pass, 1
+// otherwise.
+static int SelfCheck( const DecodeOptions& options )
+{
+    std::vector< SelfCheckRun > runs( 6 );
+    char sclk_khz[16];
+
+    runs[0].mName = "randomized";
+    runs[1].mName = "2 buses";
+    runs[1].mSettings.push_back( std::make_pair( std::string( "SCLK bus 1" ), std::string( "2" ) ) );
+    runs[1].mSettings.push_back( std::make_pair( std::string( "SDATA bus 1" ), std::string( "3" ) ) );
+    runs[2].mName = "pipelined";
+    runs[2].mSettings.push_back( std::make_pair( std::string( "Pipelined Decode?" ), std::string( "1" ) ) );
+    runs[3].mName = "filtered";
+    runs[3].mSettings.push_back( std::make_pair( std::string( "Slave Address Filter" ), std::string( "0x0-0x7" ) ) );
+    runs[3].mSettings.push_back( std::make_pair( std::string( "Command Type Filter" ), std::string( "ExtWr, ExtLngRd, Rd, Wr0" ) ) );
+    runs[4].mName = "v2.x masked write";
+    runs[4].mSettings.push_back( std::make_pair( std::string( "Protocol Version" ), std::string( "RFFE v2.x masked write" ) ) );
+    // SCLK at a fifth of the sample rate: half periods of 2 and 3 samples
+    snprintf( sclk_khz, sizeof( sclk_khz ), "%u", options.mSampleRate / 5000 );
+    runs[5].mName = "2.5 samples per half period";
+    runs[5].mSettings.push_back( std::make_pair( std::string( "Bus SCLK [kHz]" ), std::string( sclk_khz ) ) );
+
+    int status = 0;
+    for ( size_t i = 0; i < runs.size(); i++ )
+    {
+        U64 packets = 0;
+        double seconds = 0.0;
+        std::string error;
+        bool passed = RunSelfCheck( options, runs[i], RFFE_SELF_CHECK_PILOT_SAMPLES, &packets, &seconds, &error );
+        if ( passed )
+        {
+            // 5% over, the packets are random
+            U64 samples = U64( RFFE_SELF_CHECK_PILOT_SAMPLES ) * ( RFFE_SELF_CHECK_PACKETS * 21 / 20 ) / packets + 1;
+            passed = RunSelfCheck( options, runs[i], samples, &packets, &seconds, &error );
+        }
+
+        printf( "%-28s %s %8llu packets %7.3f s per 1M packets\n", runs[i].mName, passed ? "PASS" : "FAIL",
+                (unsigned long long)packets, seconds );
+        if ( !passed )
+        {
+            fprintf( stderr, "rffe_decode: self-check %s: %s\n", runs[i].mName, error.c_str() );
+            status = 1;
+        }
+    }
+    return status;
+}
+
+int main( int argc, char* argv[] )
+{
+    DecodeOptions options;
+    std::vector< std::string > files;
+    std::string summary_file;
+    bool diff = false;
+    bool self_check = false;
+    U32 diff_window = 8;
+    U32 diff_lookahead = 4096;
+    U32 jobs = std::max( 1U, std::thread::hardware_concurrency() );
+
+    options.mFormat        = RFFECaptureFile::FormatCsv;
+    options.mWordBytes     = 8;
+    options.mSampleRate    = 0;
+    options.mTriggerSample = 0;
+    options.mExportType    = 0;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if ( arg == "-h" || arg == "--help" )
+        {
+            Usage();
+            return 0;
+        }
+        else if ( arg[0] != '-' )
+        {
+            files.push_back( arg );
+            continue;
+        }
+        else if ( arg == "--diff" )
+        {
+            diff = true;
+            continue;
+        }
+        else if ( arg == "--self-check" )
+        {
+            self_check = true;
+            continue;
+        }
+        else if ( !has_value )
+        {
+            Usage();
+            return 2;
+        }
+
+        std::string value = argv[++i];
+        if ( arg == "-f" )
+        {
+            if ( value == "csv" )
+                options.mFormat = RFFECaptureFile::FormatCsv;
+            else if ( value == "binary" )
+                options.mFormat = RFFECaptureFile::FormatBinaryOnChange;
+            else if ( value == "binary-each-sample" )
+                options.mFormat = RFFECaptureFile::FormatBinaryEachSample;
+            else
+            {
+                Usage();
+                return 2;
+            }
+        }
+        else if ( arg == "-w" )
+            options.mWordBytes = U32( strtoul( value.c_str(), NULL, 10 ) );
+        else if ( arg == "-r" )
+            options.mSampleRate = U32( strtod( value.c_str(), NULL ) );
+        else if ( arg == "-t" )
+            options.mTriggerSample = strtoull( value.c_str(), NULL, 10 );
+        else if ( arg == "-e" )
+            options.mExportType = U32( strtoul( value.c_str(), NULL, 10 ) );
+        else if ( arg == "-o" )
+            options.mOutputDir = value;
+        else if ( arg == "-j" )
+            jobs = std::max( 1UL, strtoul( value.c_str(), NULL, 10 ) );
+        else if ( arg == "--summary" )
+            summary_file = value;
+        else if ( arg == "--diff-window" )
+            diff_window = U32( strtoul( value.c_str(), NULL, 10 ) );
+        else if ( arg == "--diff-lookahead" )
+            diff_lookahead = U32( strtoul( value.c_str(), NULL, 10 ) );
+        else if ( arg == "-s" )
+        {
+            size_t equals = value.find( '=' );
+            if ( equals == std::string::npos )
+            {
+                Usage();
+                return 2;
+            }
+            options.mSettings.push_back( std::make_pair( value.substr( 0, equals ), value.substr( equals + 1 ) ) );
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    if ( self_check )
+    {
+        if ( !files.empty() || diff )
+        {
+            Usage();
+            return 2;
+        }
+        if ( options.mSampleRate == 0 )
+        {
+            options.mSampleRate = 100000000;
+        }
+        return SelfCheck( options );
+    }
+    if ( files.empty() || ( diff && files.size() != 2 ) )
+    {
+        Usage();
+        return 2;
+    }
+    // the analyzer converts between samples and time throughout; exports
+    // are diffed as they are
+    bool decodes = !diff || !RFFEDiffExport::IsExport( files[0].c_str() ) || !RFFEDiffExport::IsExport( files[1].c_str() );
+    if ( decodes && options.mSampleRate == 0 )
+    {
+        fprintf( stderr, "rffe_decode: the sample rate (-r) is needed\n" );
+        return 2;
+    }
+    if ( diff )
+    {
+        return Diff( files, options, diff_window, diff_lookahead );
+    }
+
+    // every capture gets its own analyzer, the workers take the next one
+    // until none are left
+    std::vector< DecodeSummary > summaries( files.size() );
+    for ( size_t i = 0; i < summaries.size(); i++ )
+    {
+        DecodeSummary& summary = summaries[i];
+        summary.mSamples = 0;
+        summary.mPackets = 0;
+        memset( summary.mTypes, 0, sizeof( summary.mTypes ) );
+        summary.mParityErrors = 0;
+        summary.mDecodeErrors = 0;
+        summary.mTimingWarnings = 0;
+        summary.mTruncated = false;
+        summary.mDecodeSeconds = 0;
+        summary.mExportSeconds = 0;
+    }
+
+    std::atomic< size_t > next( 0 );
+    std::vector< std::thread > workers;
+    for ( U32 i = 0; i < std::min( size_t( jobs ), files.size() ); i++ )
+    {
+        workers.push_back( std::thread( [&]()
+        {
+            for ( size_t file = next++; file < files.size(); file = next++ )
+            {
+                DecodeCapture( files[file], options, &summaries[file] );
+            }
+        } ) );
+    }
+    for ( size_t i = 0; i < workers.size(); i++ )
+    {
+        workers[i].join();
+    }
+
+    WriteSummary( stdout, summaries );
+    if ( !summary_file.empty() )
+    {
+        FILE* out = fopen( summary_file.c_str(), "w" );
+        if ( out == NULL )
+        {
+            fprintf( stderr, "rffe_decode: cannot write %s\n", summary_file.c_str() );
+            return 1;
+        }
+        WriteSummary( out, summaries );
+        fclose( out );
+    }
+
+    for ( size_t i = 0; i < summaries.size(); i++ )
+    {
+        if ( !summaries[i].mError.empty() )
+        {
+            fprintf( stderr, "rffe_decode: %s: %s\n", summaries[i].mCapture.c_str(), summaries[i].mError.c_str() );
+        }
+    }
+    for ( size_t i = 0; i < summaries.size(); i++ )
+    {
+        if ( !summaries[i].mError.empty() )
+            return 1;
+    }
+    return 0;
+}
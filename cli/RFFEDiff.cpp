@@ -0,0 +1,779 @@
+#include "RFFEDiff.h"
+#include "RFFEHost.h"
+#include "RFFEAnalyzer.h"
+#include "RFFEAnalyzerResults.h"
+#include <AnalyzerHelpers.h>
+#include <algorithm>
+#include <exception>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// packets the decoder hands over at a time, and batches it may be ahead
+#define RFFE_DIFF_BATCH         4096
+#define RFFE_DIFF_BATCHES       4
+
+// odd multiplier of the rolling hash, and what ends the window of the last
+// packets of a stream
+#define RFFE_DIFF_HASH_BASE     0x9E3779B97F4A7C15ULL
+#define RFFE_DIFF_HASH_END      0xD6E8FEB86659FD93ULL
+
+// largest block (packets of A times packets of B) searched for packets
+// equal on both sides
+#define RFFE_DIFF_MAX_ALIGN     ( 1 << 16 )
+
+// thrown by the packet sink to stop a decode the diff no longer reads
+struct RFFEDiffStop
+{
+};
+
+// ---- CSV exports ----
+
+static U64 ParseNumber( const char* text )
+{
+    if ( text[0] == '0' && ( text[1] == 'b' || text[1] == 'B' ) )
+    {
+        return strtoull( text + 2, NULL, 2 );
+    }
+    return strtoull( text, NULL, 0 );
+}
+
+RFFEDiffExport::RFFEDiffExport()
+:   mFile( NULL ),
+    mLine( NULL ),
+    mLineSize( 0 ),
+    mLineNumber( 0 ),
+    mTimeColumn( 0 ),
+    mBusColumn( -1 ),
+    mSaColumn( -1 ),
+    mTypeColumn( -1 ),
+    mAddressColumn( -1 ),
+    mPayloadColumn( -1 ),
+    mCountColumn( -1 ),
+    mRepeats( 0 )
+{
+    memset( &mRow, 0, sizeof( mRow ) );
+}
+
+RFFEDiffExport::~RFFEDiffExport()
+{
+    if ( mFile != NULL )
+    {
+        fclose( mFile );
+    }
+    free( mLine );
+}
+
+bool RFFEDiffExport::IsExport( const char* file )
+{
+    char header[1024];
+    FILE* in = fopen( file, "r" );
+
+    if ( in == NULL )
+    {
+        return false;
+    }
+    bool is_export = fgets( header, sizeof( header ), in ) != NULL &&
+                     strncmp( header, "Time", 4 ) == 0 && strstr( header, ",Packet ID," ) != NULL;
+    fclose( in );
+    return is_export;
+}
+
+// the next line, split at the commas into mFields
+bool RFFEDiffExport::ReadLine()
+{
+    ssize_t length = getline( &mLine, &mLineSize, mFile );
+
+    if ( length <= 0 )
+    {
+        return false;
+    }
+    mLineNumber++;
+    while ( length > 0 && ( mLine[length - 1] == '\n' || mLine[length - 1] == '\r' ) )
+    {
+        mLine[--length] = '\0';
+    }
+
+    mFields.clear();
+    mFields.push_back( mLine );
+    for ( char* c = mLine; *c != '\0'; c++ )
+    {
+        if ( *c == ',' )
+        {
+            *c = '\0';
+            mFields.push_back( c + 1 );
+        }
+    }
+    return true;
+}
+
+bool RFFEDiffExport::Open( const char* file, std::string* error )
+{
+    mFile = fopen( file, "r" );
+    if ( mFile == NULL )
+    {
+        *error = std::string( "cannot read " ) + file;
+        return false;
+    }
+    if ( !ReadLine() )
+    {
+        *error = std::string( file ) + " is empty";
+        return false;
+    }
+
+    for ( size_t i = 0; i < mFields.size(); i++ )
+    {
+        std::string name = mFields[i];
+
+        if ( name == "Bus" )
+            mBusColumn = int( i );
+        else if ( name == "SA" )
+            mSaColumn = int( i );
+        else if ( name == "Type" )
+            mTypeColumn = int( i );
+        else if ( name == "Adr" )
+            mAddressColumn = int( i );
+        else if ( name == "Payload" )
+            mPayloadColumn = int( i );
+        else if ( name == "Count" )
+            mCountColumn = int( i );
+    }
+    if ( mSaColumn < 0 || mTypeColumn < 0 || mAddressColumn < 0 || mPayloadColumn < 0 )
+    {
+        *error = std::string( file ) + " is not a CSV export of the analyzer";
+        return false;
+    }
+    return true;
+}
+
+bool RFFEDiffExport::ParseRow()
+{
+    int columns = std::max( std::max( mBusColumn, mCountColumn ),
+                            std::max( std::max( mSaColumn, mTypeColumn ), std::max( mAddressColumn, mPayloadColumn ) ) );
+    if ( int( mFields.size() ) <= columns )
+    {
+        char text[64];
+        snprintf( text, sizeof( text ), "line %llu has too few columns", (unsigned long long)mLineNumber );
+        mError = text;
+        return false;
+    }
+
+    memset( &mRow, 0, sizeof( mRow ) );
+    snprintf( mRow.mTime, sizeof( mRow.mTime ), "%s", mFields[mTimeColumn] );
+    if ( mBusColumn >= 0 )
+    {
+        mRow.mBus = U8( ParseNumber( mFields[mBusColumn] ) );
+    }
+    mRow.mSlaveAddress = U8( ParseNumber( mFields[mSaColumn] ) );
+
+    mRow.mType = RFFE_DIFF_UNKNOWN_TYPE;
+    for ( U32 type = 0; type < RFFE_COMMAND_TYPES; type++ )
+    {
+        if ( strcmp( mFields[mTypeColumn], RFFEAnalyzerResults::GetTypeString( type ) ) == 0 )
+        {
+            mRow.mType = U8( type );
+        }
+    }
+
+    // the parity of the command frame may follow the address
+    if ( mFields[mAddressColumn][0] != '\0' )
+    {
+        mRow.mHasAddress = true;
+        mRow.mAddress = U16( ParseNumber( mFields[mAddressColumn] ) );
+    }
+
+    // bytes, "M:" before the mask of a masked write; parity bits and the bus
+    // park are skipped, an error ends the bytes
+    for ( char* token = strtok( mFields[mPayloadColumn], " " ); token != NULL; token = strtok( NULL, " " ) )
+    {
+        if ( strncmp( token, "E:", 2 ) == 0 )
+        {
+            mRow.mError = true;
+            break;
+        }
+        if ( strncmp( token, "M:", 2 ) == 0 )
+        {
+            token += 2;
+        }
+        if ( token[0] == 'P' || strcmp( token, "BP" ) == 0 )
+        {
+            continue;
+        }
+        if ( mRow.mByteCount < sizeof( mRow.mData ) )
+        {
+            mRow.mData[mRow.mByteCount++] = U8( ParseNumber( token ) );
+        }
+    }
+
+    mRepeats = 0;
+    if ( mCountColumn >= 0 && mFields[mCountColumn][0] != '\0' )
+    {
+        U64 count = strtoull( mFields[mCountColumn], NULL, 10 );
+        mRepeats = count > 1 ? count - 1 : 0;
+    }
+    return true;
+}
+
+bool RFFEDiffExport::Next( RFFEDiffPacket* packet )
+{
+    if ( mRepeats != 0 )
+    {
+        mRepeats--;
+        *packet = mRow;
+        return true;
+    }
+    if ( !mError.empty() )
+    {
+        return false;
+    }
+    while ( ReadLine() )
+    {
+        if ( mLine[0] == '\0' )
+        {
+            continue;
+        }
+        if ( !ParseRow() )
+        {
+            return false;
+        }
+        *packet = mRow;
+        return true;
+    }
+    return false;
+}
+
+// ---- decoded captures ----
+
+RFFEDiffCapture::RFFEDiffCapture()
+:   mAnalyzer( NULL ),
+    mDone( false ),
+    mStop( false ),
+    mTruncated( false ),
+    mPosition( 0 )
+{
+}
+
+RFFEDiffCapture::~RFFEDiffCapture()
+{
+    Stop();
+    if ( mAnalyzer != NULL )
+    {
+        DestroyAnalyzer( mAnalyzer );
+    }
+}
+
+bool RFFEDiffCapture::Open( const char* file, RFFECaptureFile::Format format, U32 word_bytes, U32 sample_rate, U64 trigger_sample,
+                            const std::vector< std::pair< std::string, std::string > >& settings, std::string* error )
+{
+    if ( !mCapture.Open( file, format, word_bytes, sample_rate, trigger_sample, error ) )
+    {
+        return false;
+    }
+    mAnalyzer = CreateAnalyzer();
+    if ( !RFFEHostConfigure( mAnalyzer->GetAnalyzerData()->mSettings, settings, error ) )
+    {
+        return false;
+    }
+    RFFEHostAttachCapture( mAnalyzer, &mCapture );
+    RFFEHostSetPacketSink( mAnalyzer, AddPacket, this );
+    mBatch.reserve( RFFE_DIFF_BATCH );
+    mThread = std::thread( &RFFEDiffCapture::Decode, this );
+    return true;
+}
+
+void RFFEDiffCapture::AddPacket( AnalyzerResults* results, U64 packet_id, void* context )
+{
+    ( (RFFEDiffCapture*)context )->Add( results, packet_id );
+}
+
+void RFFEDiffCapture::Add( AnalyzerResults* analyzer_results, U64 packet_id )
+{
+    RFFEAnalyzerResults* results = (RFFEAnalyzerResults*)analyzer_results;
+    RFFEPacket packet;
+    RFFEPacketExtras extras;
+    RFFEDiffPacket record;
+
+    if ( mStop )
+    {
+        throw RFFEDiffStop();
+    }
+    results->ReadPacket( packet_id, &packet, &extras );
+
+    memset( &record, 0, sizeof( record ) );
+    record.mBus          = packet.mBus;
+    record.mSlaveAddress = packet.mSlaveAddress;
+    record.mType         = packet.mType;
+    record.mByteCount    = packet.mByteCount;
+    record.mHasAddress   = extras.mHasAddress;
+    record.mError        = extras.mErrorFrames != 0;
+    record.mAddress      = extras.mHasAddress ? packet.mAddress : 0;
+    memcpy( record.mData, packet.mData, packet.mByteCount );
+    AnalyzerHelpers::GetTimeString( packet.mStartingSample, mCapture.GetTriggerSample(), mCapture.GetSampleRate(),
+                                    record.mTime, sizeof( record.mTime ) );
+
+    for ( U64 i = 0; i <= extras.mRepeats; i++ )
+    {
+        mBatch.push_back( record );
+        if ( mBatch.size() == RFFE_DIFF_BATCH )
+        {
+            HandOver();
+        }
+    }
+}
+
+void RFFEDiffCapture::HandOver()
+{
+    std::unique_lock< std::mutex > lock( mMutex );
+
+    while ( mBatches.size() >= RFFE_DIFF_BATCHES && !mStop )
+    {
+        mChanged.wait( lock );
+    }
+    mBatches.push_back( std::vector< RFFEDiffPacket >() );
+    mBatches.back().swap( mBatch );
+    mBatch.reserve( RFFE_DIFF_BATCH );
+    mChanged.notify_all();
+}
+
+void RFFEDiffCapture::Decode()
+{
+    std::string error;
+
+    try
+    {
+        mAnalyzer->SetupResults();
+        mAnalyzer->WorkerThread();
+    }
+    catch ( RFFECaptureEnd& )
+    {
+        // a packet ran past the end: the ones before it are in
+        mTruncated = true;
+    }
+    catch ( RFFEDiffStop& )
+    {
+    }
+    catch ( std::exception& e )
+    {
+        error = e.what();
+    }
+
+    if ( !mBatch.empty() )
+    {
+        HandOver();
+    }
+    std::lock_guard< std::mutex > lock( mMutex );
+    mError = error;
+    mDone = true;
+    mChanged.notify_all();
+}
+
+void RFFEDiffCapture::Stop()
+{
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mStop = true;
+        mChanged.notify_all();
+    }
+    if ( mThread.joinable() )
+    {
+        mThread.join();
+    }
+}
+
+bool RFFEDiffCapture::Next( RFFEDiffPacket* packet )
+{
+    while ( mPosition == mCurrent.size() )
+    {
+        std::unique_lock< std::mutex > lock( mMutex );
+
+        while ( mBatches.empty() && !mDone )
+        {
+            mChanged.wait( lock );
+        }
+        if ( mBatches.empty() )
+        {
+            return false;
+        }
+        mCurrent.swap( mBatches.front() );
+        mBatches.pop_front();
+        mPosition = 0;
+        mChanged.notify_all();
+    }
+    *packet = mCurrent[mPosition++];
+    return true;
+}
+
+std::string RFFEDiffCapture::GetError()
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mError;
+}
+
+// ---- diff ----
+
+static U64 Mix( U64 value )
+{
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+RFFEDiff::RFFEDiff( U32 window, U32 lookahead )
+:   mWindow( std::max( 1U, window ) ),
+    mLookahead( std::max( 1U, lookahead ) ),
+    mPower( 1 ),
+    mGeneration( 0 )
+{
+    for ( U32 i = 1; i < mWindow; i++ )
+    {
+        mPower *= RFFE_DIFF_HASH_BASE;
+    }
+
+    // a table per side holds a window per packet read ahead, at most half full
+    size_t size = 16;
+    while ( size < 2 * size_t( mLookahead ) )
+    {
+        size *= 2;
+    }
+    Slot empty = { 0, 0, 0 };
+    mTableA.assign( size, empty );
+    mTableB.assign( size, empty );
+}
+
+U64 RFFEDiff::GetKey( const RFFEDiffPacket& packet )
+{
+    U64 data[2] = { 0, 0 };
+    memcpy( data, packet.mData, packet.mByteCount );
+
+    U64 key = U64( packet.mBus ) | ( U64( packet.mSlaveAddress ) << 8 ) | ( U64( packet.mType ) << 16 ) |
+              ( U64( packet.mByteCount ) << 24 ) | ( U64( packet.mHasAddress ) << 32 ) | ( U64( packet.mError ) << 33 ) |
+              ( U64( packet.mAddress ) << 40 );
+    return Mix( Mix( Mix( key ) ^ data[0] ) ^ data[1] );
+}
+
+bool RFFEDiff::IsSame( const RFFEDiffPacket& a, const RFFEDiffPacket& b )
+{
+    return a.mBus == b.mBus && a.mSlaveAddress == b.mSlaveAddress && a.mType == b.mType &&
+           a.mByteCount == b.mByteCount && a.mHasAddress == b.mHasAddress && a.mError == b.mError &&
+           a.mAddress == b.mAddress && memcmp( a.mData, b.mData, a.mByteCount ) == 0;
+}
+
+std::string RFFEDiff::Describe( const RFFEDiffPacket& packet )
+{
+    char text[128];
+    int length = snprintf( text, sizeof( text ), "bus %u SA 0x%X %s", packet.mBus, packet.mSlaveAddress,
+                           packet.mType < RFFE_COMMAND_TYPES ? RFFEAnalyzerResults::GetTypeString( packet.mType ) : "?" );
+    std::string description( text, length );
+
+    if ( packet.mHasAddress )
+    {
+        snprintf( text, sizeof( text ), " Adr 0x%02X", packet.mAddress );
+        description += text;
+    }
+    if ( packet.mByteCount != 0 )
+    {
+        description += " Data";
+    }
+    for ( U32 i = 0; i < packet.mByteCount; i++ )
+    {
+        snprintf( text, sizeof( text ), " 0x%02X", packet.mData[i] );
+        description += text;
+    }
+    if ( packet.mError )
+    {
+        description += " error";
+    }
+    return description;
+}
+
+// at least count packets read ahead unless the stream ends first
+bool RFFEDiff::Fill( Side& side, U64 count )
+{
+    RFFEDiffPacket packet;
+
+    while ( side.mPending.size() < count && !side.mEnded )
+    {
+        if ( side.mSource->Next( &packet ) )
+        {
+            side.mPending.push_back( packet );
+            side.mKeys.push_back( GetKey( packet ) );
+        }
+        else
+        {
+            side.mEnded = true;
+        }
+    }
+    return side.mPending.size() >= count;
+}
+
+// hash of the window of packets at position of the read ahead ones, rolled
+// on from the window before; the last packets of a stream make a shorter
+// window, marked so that it only matches the end of the other stream
+bool RFFEDiff::GetWindowHash( Side& side, U64 position, U64* hash )
+{
+    Fill( side, position + mWindow );
+    U64 size = side.mPending.size();
+
+    if ( position >= size )
+    {
+        return false;
+    }
+    if ( position + mWindow > size )
+    {
+        U64 tail = 0;
+        for ( U64 i = position; i < size; i++ )
+        {
+            tail = tail * RFFE_DIFF_HASH_BASE + side.mKeys[i];
+        }
+        side.mRollPosition = U64( -1 );
+        *hash = Mix( tail ^ RFFE_DIFF_HASH_END ^ ( size - position ) );
+        return true;
+    }
+
+    if ( side.mRollPosition != U64( -1 ) && position == side.mRollPosition + 1 )
+    {
+        side.mRollHash = ( side.mRollHash - side.mKeys[position - 1] * mPower ) * RFFE_DIFF_HASH_BASE +
+                         side.mKeys[position + mWindow - 1];
+    }
+    else if ( position != side.mRollPosition )
+    {
+        side.mRollHash = 0;
+        for ( U64 i = position; i < position + mWindow; i++ )
+        {
+            side.mRollHash = side.mRollHash * RFFE_DIFF_HASH_BASE + side.mKeys[i];
+        }
+    }
+    side.mRollPosition = position;
+    *hash = side.mRollHash;
+    return true;
+}
+
+bool RFFEDiff::IsSameWindow( Side& a, U64 position_a, Side& b, U64 position_b )
+{
+    U64 length_a = std::min( U64( mWindow ), a.mPending.size() - position_a );
+    U64 length_b = std::min( U64( mWindow ), b.mPending.size() - position_b );
+
+    if ( length_a != length_b )
+    {
+        return false;
+    }
+    for ( U64 i = 0; i < length_a; i++ )
+    {
+        if ( !IsSame( a.mPending[position_a + i], b.mPending[position_b + i] ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the first position of a hash stays, the earliest place to resync at
+void RFFEDiff::Insert( std::vector< Slot >& table, U64 hash, U64 position )
+{
+    size_t mask = table.size() - 1;
+
+    for ( size_t i = size_t( hash ) & mask; ; i = ( i + 1 ) & mask )
+    {
+        Slot& slot = table[i];
+        if ( slot.mGeneration != mGeneration )
+        {
+            slot.mHash = hash;
+            slot.mPosition = position;
+            slot.mGeneration = mGeneration;
+            return;
+        }
+        if ( slot.mHash == hash )
+        {
+            return;
+        }
+    }
+}
+
+bool RFFEDiff::Find( const std::vector< Slot >& table, U64 hash, U64* position ) const
+{
+    size_t mask = table.size() - 1;
+
+    for ( size_t i = size_t( hash ) & mask; table[i].mGeneration == mGeneration; i = ( i + 1 ) & mask )
+    {
+        if ( table[i].mHash == hash )
+        {
+            *position = table[i].mPosition;
+            return true;
+        }
+    }
+    return false;
+}
+
+// packets to skip on each side to be back in step, the heads differing
+bool RFFEDiff::Resync( U64* skip_a, U64* skip_b )
+{
+    // a new generation empties the tables
+    if ( ++mGeneration == 0 )
+    {
+        Slot empty = { 0, 0, 0 };
+        std::fill( mTableA.begin(), mTableA.end(), empty );
+        std::fill( mTableB.begin(), mTableB.end(), empty );
+        mGeneration = 1;
+    }
+
+    for ( U64 position = 0; position < mLookahead; position++ )
+    {
+        bool found = false;
+        U64 hash;
+        U64 other;
+
+        if ( GetWindowHash( mA, position, &hash ) )
+        {
+            Insert( mTableA, hash, position );
+            if ( Find( mTableB, hash, &other ) && IsSameWindow( mA, position, mB, other ) )
+            {
+                *skip_a = position;
+                *skip_b = other;
+                found = true;
+            }
+        }
+        if ( GetWindowHash( mB, position, &hash ) )
+        {
+            Insert( mTableB, hash, position );
+            if ( Find( mTableA, hash, &other ) && IsSameWindow( mA, other, mB, position ) &&
+                 ( !found || other + position < *skip_a + *skip_b ) )
+            {
+                *skip_a = other;
+                *skip_b = position;
+                found = true;
+            }
+        }
+        if ( found )
+        {
+            return true;
+        }
+        if ( position >= mA.mPending.size() && position >= mB.mPending.size() )
+        {
+            break;
+        }
+    }
+
+    *skip_a = std::min( U64( mLookahead ), U64( mA.mPending.size() ) );
+    *skip_b = std::min( U64( mLookahead ), U64( mB.mPending.size() ) );
+    return false;
+}
+
+// packets equal on both sides in a block, in order: differences closer
+// than a window make one block, the packets between them still match
+U64 RFFEDiff::GetCommon( U64 count_a, U64 count_b )
+{
+    if ( count_a == 0 || count_b == 0 || count_a * count_b > RFFE_DIFF_MAX_ALIGN )
+    {
+        return 0;
+    }
+
+    // longest common subsequence, a row of B at a time
+    std::vector< U32 > previous( count_b + 1, 0 );
+    std::vector< U32 > row( count_b + 1, 0 );
+    for ( U64 i = 0; i < count_a; i++ )
+    {
+        for ( U64 j = 0; j < count_b; j++ )
+        {
+            if ( mA.mKeys[i] == mB.mKeys[j] && IsSame( mA.mPending[i], mB.mPending[j] ) )
+                row[j + 1] = previous[j] + 1;
+            else
+                row[j + 1] = std::max( previous[j + 1], row[j] );
+        }
+        previous.swap( row );
+    }
+    return previous[count_b];
+}
+
+void RFFEDiff::Consume( Side& side, U64 count )
+{
+    side.mPending.erase( side.mPending.begin(), side.mPending.begin() + count );
+    side.mKeys.erase( side.mKeys.begin(), side.mKeys.begin() + count );
+    side.mConsumed += count;
+    side.mRollPosition = U64( -1 );
+}
+
+bool RFFEDiff::Run( RFFEDiffSource* a, RFFEDiffSource* b, RFFEDiffResult* result, std::string* error )
+{
+    Side* sides[2] = { &mA, &mB };
+    RFFEDiffSource* sources[2] = { a, b };
+    bool in_block = false;
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        sides[i]->mSource = sources[i];
+        sides[i]->mPending.clear();
+        sides[i]->mKeys.clear();
+        sides[i]->mEnded = false;
+        sides[i]->mConsumed = 0;
+        sides[i]->mRollPosition = U64( -1 );
+        sides[i]->mRollHash = 0;
+    }
+    memset( result, 0, sizeof( *result ) );
+
+    for ( ;; )
+    {
+        Fill( mA, 1 );
+        Fill( mB, 1 );
+        if ( mA.mPending.empty() && mB.mPending.empty() )
+        {
+            break;
+        }
+        if ( !mA.mPending.empty() && !mB.mPending.empty() && mA.mKeys[0] == mB.mKeys[0] &&
+             IsSame( mA.mPending[0], mB.mPending[0] ) )
+        {
+            result->mMatched++;
+            Consume( mA, 1 );
+            Consume( mB, 1 );
+            in_block = false;
+            continue;
+        }
+
+        if ( !result->mDiverged )
+        {
+            result->mDiverged  = true;
+            result->mFirstA    = mA.mConsumed;
+            result->mFirstB    = mB.mConsumed;
+            result->mHasFirstA = !mA.mPending.empty();
+            result->mHasFirstB = !mB.mPending.empty();
+            if ( result->mHasFirstA )
+                result->mFirstPacketA = mA.mPending[0];
+            if ( result->mHasFirstB )
+                result->mFirstPacketB = mB.mPending[0];
+        }
+
+        U64 skip_a;
+        U64 skip_b;
+        Resync( &skip_a, &skip_b );
+
+        U64 common  = GetCommon( skip_a, skip_b );
+        U64 changed = std::min( skip_a, skip_b ) - common;
+        result->mMatched  += common;
+        result->mChanged  += changed;
+        result->mDeleted  += skip_a - common - changed;
+        result->mInserted += skip_b - common - changed;
+        if ( !in_block )
+        {
+            result->mBlocks++;
+        }
+        in_block = true;
+        Consume( mA, skip_a );
+        Consume( mB, skip_b );
+    }
+    result->mPacketsA = mA.mConsumed;
+    result->mPacketsB = mB.mConsumed;
+
+    const char* names[2] = { "A", "B" };
+    for ( int i = 0; i < 2; i++ )
+    {
+        std::string source_error = sources[i]->GetError();
+        if ( !source_error.empty() )
+        {
+            *error = std::string( names[i] ) + ": " + source_error;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,217 @@
+#ifndef RFFE_DIFF
+#define RFFE_DIFF
+
+#include <LogicPublicTypes.h>
+#include "RFFECaptureFile.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+class Analyzer;
+class AnalyzerResults;
+
+// The diff of rffe_decode: two streams of transactions, from CSV exports of
+// the analyzer or decoded from captures as they are read, are lined up by
+// their order. Only what was sent counts (bus, SA, command type, address,
+// payload, decode errors), not when: two decodes of the same traffic are
+// equal whatever their sample rate or trigger.
+
+// a transaction as the diff compares it, collapsed repeats each on their own
+struct RFFEDiffPacket
+{
+    U8   mBus;
+    U8   mSlaveAddress;
+    U8   mType;             // RffeTypeFieldType, RFFE_DIFF_UNKNOWN_TYPE if the export has another name
+    U8   mByteCount;
+    bool mHasAddress;
+    bool mError;            // RffeErrorCaseField frames, "E:" in an export
+    U16  mAddress;
+    U8   mData[16];
+    char mTime[32];         // as exported, or of the SSC; not compared
+};
+
+#define RFFE_DIFF_UNKNOWN_TYPE  0xFF
+
+class RFFEDiffSource
+{
+public:
+    virtual ~RFFEDiffSource() {}
+
+    // the next transaction, false at the end (or when the source failed)
+    virtual bool Next( RFFEDiffPacket* packet ) = 0;
+
+    // empty unless the source failed
+    virtual std::string GetError() = 0;
+};
+
+// A CSV export of the analyzer (csv or csv with repeats collapsed, any
+// export time, with or without deltas, bus or register columns), read a
+// line at a time
+class RFFEDiffExport : public RFFEDiffSource
+{
+public:
+    RFFEDiffExport();
+    virtual ~RFFEDiffExport();
+
+    // true when the file starts with the header of an export
+    static bool IsExport( const char* file );
+
+    bool Open( const char* file, std::string* error );
+
+    virtual bool Next( RFFEDiffPacket* packet );
+    virtual std::string GetError()      { return mError; }
+
+protected:
+    bool ReadLine();
+    bool ParseRow();
+
+    FILE* mFile;
+    char* mLine;
+    size_t mLineSize;
+    U64 mLineNumber;
+    std::vector< char* > mFields;
+    int mTimeColumn;
+    int mBusColumn;
+    int mSaColumn;
+    int mTypeColumn;
+    int mAddressColumn;
+    int mPayloadColumn;
+    int mCountColumn;       // -1 unless repeats were collapsed
+    RFFEDiffPacket mRow;
+    U64 mRepeats;           // copies of mRow still to hand out
+    std::string mError;
+};
+
+// A capture decoded by its own analyzer in a thread of its own, the
+// packets handed over in batches as they are committed; a few batches
+// ahead of the diff the decoder waits, so captures of any length diff in
+// little memory
+class RFFEDiffCapture : public RFFEDiffSource
+{
+public:
+    RFFEDiffCapture();
+    virtual ~RFFEDiffCapture();
+
+    bool Open( const char* file, RFFECaptureFile::Format format, U32 word_bytes, U32 sample_rate, U64 trigger_sample,
+               const std::vector< std::pair< std::string, std::string > >& settings, std::string* error );
+
+    virtual bool Next( RFFEDiffPacket* packet );
+    virtual std::string GetError();
+
+    // a packet ran past the end of the capture
+    bool IsTruncated() const            { return mTruncated; }
+
+protected:
+    static void AddPacket( AnalyzerResults* results, U64 packet_id, void* context );
+    void Add( AnalyzerResults* results, U64 packet_id );
+    void HandOver();
+    void Decode();
+    void Stop();
+
+    RFFECaptureFile mCapture;
+    Analyzer* mAnalyzer;
+    std::thread mThread;
+
+    std::mutex mMutex;
+    std::condition_variable mChanged;
+    std::deque< std::vector< RFFEDiffPacket > > mBatches;
+    bool mDone;
+    bool mStop;
+    bool mTruncated;
+    std::string mError;
+
+    std::vector< RFFEDiffPacket > mBatch;       // being filled by the decoder
+    std::vector< RFFEDiffPacket > mCurrent;     // being read by the diff
+    size_t mPosition;
+};
+
+// what a diff found; a block is where the streams went out of step, up to
+// where they are back in step (packets equal inside it count as matched)
+struct RFFEDiffResult
+{
+    U64 mPacketsA;
+    U64 mPacketsB;
+    U64 mMatched;
+    U64 mChanged;           // in A and B, but different
+    U64 mDeleted;           // only in A
+    U64 mInserted;          // only in B
+    U64 mBlocks;
+
+    // the first block: where it starts on each side, and the packets there
+    // (none where a side ended)
+    bool mDiverged;
+    U64 mFirstA;
+    U64 mFirstB;
+    bool mHasFirstA;
+    bool mHasFirstB;
+    RFFEDiffPacket mFirstPacketA;
+    RFFEDiffPacket mFirstPacketB;
+};
+
+// Lines up two streams in one pass. Equal transactions are matched as they
+// come; at a difference both sides are read ahead together, the rolling
+// hash of every window of packets going into a table per side, until a
+// window of one side is found in the table of the other: the streams are
+// back in step there, the packets skipped on both sides are one block, the
+// equal ones in it lined up as in a diff of two files.
+// Each packet is hashed once per block it is read ahead in, so the diff
+// is linear in the packets and keeps at most a lookahead of them; when no
+// window is found in the lookahead, it is taken as a block of changed
+// packets and the search starts over after it.
+class RFFEDiff
+{
+public:
+    RFFEDiff( U32 window, U32 lookahead );
+
+    // false when a source failed; the result goes up to there
+    bool Run( RFFEDiffSource* a, RFFEDiffSource* b, RFFEDiffResult* result, std::string* error );
+
+    // "bus 0 SA 0x5 ExtWr Adr 0x65 Data 0x01 0x02", the fields the diff compares
+    static std::string Describe( const RFFEDiffPacket& packet );
+
+protected:
+    struct Side
+    {
+        RFFEDiffSource* mSource;
+        std::deque< RFFEDiffPacket > mPending;
+        std::deque< U64 > mKeys;
+        bool mEnded;
+        U64 mConsumed;
+        U64 mRollPosition;  // window mRollHash is of, U64( -1 ) if none
+        U64 mRollHash;
+    };
+
+    struct Slot
+    {
+        U64 mHash;
+        U64 mPosition;
+        U32 mGeneration;
+    };
+
+    static U64 GetKey( const RFFEDiffPacket& packet );
+    static bool IsSame( const RFFEDiffPacket& a, const RFFEDiffPacket& b );
+
+    bool Fill( Side& side, U64 count );
+    bool GetWindowHash( Side& side, U64 position, U64* hash );
+    bool IsSameWindow( Side& a, U64 position_a, Side& b, U64 position_b );
+    void Insert( std::vector< Slot >& table, U64 hash, U64 position );
+    bool Find( const std::vector< Slot >& table, U64 hash, U64* position ) const;
+    bool Resync( U64* skip_a, U64* skip_b );
+    U64 GetCommon( U64 count_a, U64 count_b );
+    void Consume( Side& side, U64 count );
+
+    U32 mWindow;
+    U32 mLookahead;
+    U64 mPower;             // base to the power of mWindow - 1
+    Side mA;
+    Side mB;
+    std::vector< Slot > mTableA;
+    std::vector< Slot > mTableB;
+    U32 mGeneration;
+};
+
+#endif //RFFE_DIFF
@@ -0,0 +1,1467 @@
+#include "RFFEHost.h"
+#include <AnalyzerHelpers.h>
+#include <AnalyzerChannelData.h>
+#include <AnalyzerResults.h>
+#include <AnalyzerSettings.h>
+#include <SimulationChannelDescriptor.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// frames and packets only, the export needs nothing else; with a sink
+// only those of the packet being committed
+struct AnalyzerResultsData
+{
+    std::deque< Frame > mFrames;
+    std::vector< std::pair< U64, U64 > > mPackets;     // first and last frame
+    U64 mFrameBase;         // IDs of mFrames[0] and mPackets[0]
+    U64 mPacketBase;
+    U64 mPacketStart;
+    RFFEHostPacketSink mSink;
+    void* mSinkContext;
+    std::string mResultString;
+};
+
+// The data of every live results object. An analyzer is handed its results
+// by SetAnalyzerResults and passes them the packet sink through here, as
+// AnalyzerResults keeps its data to itself.
+static std::mutex gResultsDataMutex;
+static std::map< const AnalyzerResults*, AnalyzerResultsData* > gResultsData;
+
+static AnalyzerResultsData* GetResultsData( const AnalyzerResults* results )
+{
+    std::lock_guard< std::mutex > lock( gResultsDataMutex );
+    return gResultsData.at( results );
+}
+
+// ---- Analyzer ----
+
+AnalyzerData::AnalyzerData()
+:   mSettings( NULL ),
+    mResults( NULL ),
+    mCapture( NULL ),
+    mProgress( 0 ),
+    mSink( NULL ),
+    mSinkContext( NULL )
+{
+}
+
+AnalyzerData::~AnalyzerData()
+{
+    for ( size_t i = 0; i < mChannels.size(); i++ )
+    {
+        delete mChannels[i];
+        delete mChannelData[i];
+    }
+}
+
+void RFFEHostAttachCapture( Analyzer* analyzer, RFFECaptureFile* capture )
+{
+    analyzer->GetAnalyzerData()->mCapture = capture;
+}
+
+void RFFEHostSetPacketSink( Analyzer* analyzer, RFFEHostPacketSink sink, void* context )
+{
+    analyzer->GetAnalyzerData()->mSink = sink;
+    analyzer->GetAnalyzerData()->mSinkContext = context;
+}
+
+static AnalyzerSettingInterface* FindSetting( AnalyzerSettings* settings, const std::string& title )
+{
+    for ( U32 i = 0; i < settings->GetSettingsInterfacesCount(); i++ )
+    {
+        if ( strcasecmp( settings->GetSettingsInterface( i )->GetTitle(), title.c_str() ) == 0 )
+        {
+            return settings->GetSettingsInterface( i );
+        }
+    }
+    return NULL;
+}
+
+static bool ApplySetting( AnalyzerSettingInterface* setting, const std::string& value )
+{
+    char* end;
+
+    switch ( setting->GetType() )
+    {
+    case INTERFACE_CHANNEL:
+    {
+        AnalyzerSettingInterfaceChannel* channel = (AnalyzerSettingInterfaceChannel*)setting;
+        if ( value.empty() || strcasecmp( value.c_str(), "none" ) == 0 )
+        {
+            channel->SetChannel( UNDEFINED_CHANNEL );
+            return true;
+        }
+        U32 index = U32( strtoul( value.c_str(), &end, 10 ) );
+        if ( *end != 0 )
+            return false;
+        channel->SetChannel( Channel( 0, index ) );
+        return true;
+    }
+    case INTERFACE_NUMBER_LIST:
+    {
+        AnalyzerSettingInterfaceNumberList* list = (AnalyzerSettingInterfaceNumberList*)setting;
+        for ( U32 i = 0; i < list->GetListboxStringsCount(); i++ )
+        {
+            if ( strcasecmp( value.c_str(), list->GetListboxString( i ) ) == 0 )
+            {
+                list->SetNumber( list->GetListboxNumber( i ) );
+                return true;
+            }
+        }
+        double number = strtod( value.c_str(), &end );
+        if ( value.empty() || *end != 0 )
+            return false;
+        list->SetNumber( number );
+        return true;
+    }
+    case INTERFACE_INTEGER:
+    {
+        long integer = strtol( value.c_str(), &end, 0 );
+        if ( value.empty() || *end != 0 )
+            return false;
+        ( (AnalyzerSettingInterfaceInteger*)setting )->SetInteger( int( integer ) );
+        return true;
+    }
+    case INTERFACE_TEXT:
+        ( (AnalyzerSettingInterfaceText*)setting )->SetText( value.c_str() );
+        return true;
+    case INTERFACE_BOOL:
+    {
+        const char* on[]  = { "1", "true", "yes", "on" };
+        const char* off[] = { "0", "false", "no", "off" };
+        for ( U32 i = 0; i < 4; i++ )
+        {
+            if ( strcasecmp( value.c_str(), on[i] ) == 0 || strcasecmp( value.c_str(), off[i] ) == 0 )
+            {
+                ( (AnalyzerSettingInterfaceBool*)setting )->SetValue( strcasecmp( value.c_str(), on[i] ) == 0 );
+                return true;
+            }
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+bool RFFEHostApplySetting( AnalyzerSettings* settings, const std::string& title, const std::string& value, std::string* error )
+{
+    AnalyzerSettingInterface* setting = FindSetting( settings, title );
+
+    if ( setting == NULL )
+    {
+        *error = "no setting \"" + title + "\"";
+        return false;
+    }
+    if ( !ApplySetting( setting, value ) )
+    {
+        *error = "bad value \"" + value + "\" for \"" + title + "\"";
+        return false;
+    }
+    return true;
+}
+
+bool RFFEHostConfigure( AnalyzerSettings* settings, const std::vector< std::pair< std::string, std::string > >& values,
+                        std::string* error )
+{
+    for ( size_t i = 0; i < values.size(); i++ )
+    {
+        if ( !RFFEHostApplySetting( settings, values[i].first, values[i].second, error ) )
+        {
+            return false;
+        }
+    }
+    // the data is complete, there is nothing to wait for
+    RFFEHostApplySetting( settings, "Streaming Decode?", "0", error );
+    if ( !settings->SetSettingsFromInterfaces() )
+    {
+        *error = settings->GetSaveErrorMessage();
+        return false;
+    }
+    return true;
+}
+
+Analyzer::Analyzer()
+:   mData( new AnalyzerData() )
+{
+}
+
+Analyzer::~Analyzer()
+{
+    delete mData;
+}
+
+void Analyzer::SetupResults()
+{
+}
+
+void Analyzer::SetAnalyzerSettings( AnalyzerSettings* settings )
+{
+    mData->mSettings = settings;
+}
+
+void Analyzer::SetAnalyzerResults( AnalyzerResults* analyzer_results )
+{
+    mData->mResults = analyzer_results;
+    if ( analyzer_results != NULL )
+    {
+        AnalyzerResultsData* results_data = GetResultsData( analyzer_results );
+        results_data->mSink = mData->mSink;
+        results_data->mSinkContext = mData->mSinkContext;
+    }
+}
+
+bool Analyzer::GetAnalyzerResults( AnalyzerResults** analyzer_results )
+{
+    *analyzer_results = mData->mResults;
+    return mData->mResults != NULL;
+}
+
+// one AnalyzerChannelData per channel for the life of the analyzer, as in Logic
+AnalyzerChannelData* Analyzer::GetAnalyzerChannelData( Channel& channel )
+{
+    for ( size_t i = 0; i < mData->mChannels.size(); i++ )
+    {
+        if ( mData->mChannelIndex[i] == channel.mChannelIndex )
+        {
+            return mData->mChannels[i];
+        }
+    }
+
+    int bit = mData->mCapture->GetChannelBit( channel.mChannelIndex );
+    if ( bit < 0 )
+    {
+        std::ostringstream error;
+        error << "channel " << channel.mChannelIndex << " is not in the capture";
+        throw std::runtime_error( error.str() );
+    }
+    mData->mChannelIndex.push_back( channel.mChannelIndex );
+    mData->mChannelData.push_back( new ChannelData( mData->mCapture, bit ) );
+    mData->mChannels.push_back( new AnalyzerChannelData( mData->mChannelData.back() ) );
+    return mData->mChannels.back();
+}
+
+U32 Analyzer::GetSampleRate()
+{
+    return mData->mCapture->GetSampleRate();
+}
+
+U32 Analyzer::GetSimulationSampleRate()
+{
+    return mData->mCapture->GetSampleRate();
+}
+
+U64 Analyzer::GetTriggerSample()
+{
+    return mData->mCapture->GetTriggerSample();
+}
+
+void Analyzer::ReportProgress( U64 sample_number )
+{
+    mData->mProgress = sample_number;
+}
+
+// the decode runs to the end of the capture, nobody stops it halfway
+void Analyzer::CheckIfThreadShouldExit()
+{
+}
+
+void Analyzer::KillThread()
+{
+}
+
+double Analyzer::GetAnalyzerProgress()
+{
+    U64 last = mData->mCapture != NULL ? mData->mCapture->GetLastSample() : 0;
+    return last != 0 ? double( mData->mProgress ) / double( last ) : 0;
+}
+
+void Analyzer::SetAnalyzerData( AnalyzerData* analyzer_data )
+{
+    mData = analyzer_data;
+}
+
+AnalyzerData* Analyzer::GetAnalyzerData()
+{
+    return mData;
+}
+
+Analyzer2::Analyzer2()
+{
+}
+
+void Analyzer2::SetupResults()
+{
+}
+
+// ---- AnalyzerChannelData ----
+
+struct AnalyzerChannelDataData
+{
+    ChannelData* mChannel;
+};
+
+AnalyzerChannelData::AnalyzerChannelData( ChannelData* channel_data )
+:   mData( new AnalyzerChannelDataData() )
+{
+    mData->mChannel = channel_data;
+}
+
+AnalyzerChannelData::~AnalyzerChannelData()
+{
+    delete mData;
+}
+
+U64 AnalyzerChannelData::GetSampleNumber()
+{
+    return mData->mChannel->GetSampleNumber();
+}
+
+BitState AnalyzerChannelData::GetBitState()
+{
+    return mData->mChannel->GetBitState();
+}
+
+U32 AnalyzerChannelData::Advance( U32 num_samples )
+{
+    return mData->mChannel->AdvanceToAbsPosition( mData->mChannel->GetSampleNumber() + num_samples );
+}
+
+U32 AnalyzerChannelData::AdvanceToAbsPosition( U64 sample_number )
+{
+    return mData->mChannel->AdvanceToAbsPosition( sample_number );
+}
+
+void AnalyzerChannelData::AdvanceToNextEdge()
+{
+    mData->mChannel->AdvanceToNextEdge();
+}
+
+U64 AnalyzerChannelData::GetSampleOfNextEdge()
+{
+    return mData->mChannel->GetSampleOfNextEdge();
+}
+
+bool AnalyzerChannelData::WouldAdvancingCauseTransition( U32 num_samples )
+{
+    return mData->mChannel->WouldAdvancingToAbsPositionCauseTransition( mData->mChannel->GetSampleNumber() + num_samples );
+}
+
+bool AnalyzerChannelData::WouldAdvancingToAbsPositionCauseTransition( U64 sample_number )
+{
+    return mData->mChannel->WouldAdvancingToAbsPositionCauseTransition( sample_number );
+}
+
+bool AnalyzerChannelData::DoMoreTransitionsExistInCurrentData()
+{
+    return mData->mChannel->DoMoreTransitionsExistInCurrentData();
+}
+
+// ---- AnalyzerResults ----
+
+Frame::Frame()
+:   mStartingSampleInclusive( 0 ),
+    mEndingSampleInclusive( 0 ),
+    mData1( 0 ),
+    mData2( 0 ),
+    mType( 0 ),
+    mFlags( 0 )
+{
+}
+
+Frame::Frame( const Frame& frame )
+:   mStartingSampleInclusive( frame.mStartingSampleInclusive ),
+    mEndingSampleInclusive( frame.mEndingSampleInclusive ),
+    mData1( frame.mData1 ),
+    mData2( frame.mData2 ),
+    mType( frame.mType ),
+    mFlags( frame.mFlags )
+{
+}
+
+Frame::~Frame()
+{
+}
+
+bool Frame::HasFlag( U8 flag )
+{
+    return ( mFlags & flag ) != 0;
+}
+
+AnalyzerResults::AnalyzerResults()
+:   mData( new AnalyzerResultsData() )
+{
+    mData->mFrameBase = 0;
+    mData->mPacketBase = 0;
+    mData->mPacketStart = 0;
+    mData->mSink = NULL;
+    mData->mSinkContext = NULL;
+
+    std::lock_guard< std::mutex > lock( gResultsDataMutex );
+    gResultsData[this] = mData;
+}
+
+AnalyzerResults::~AnalyzerResults()
+{
+    {
+        std::lock_guard< std::mutex > lock( gResultsDataMutex );
+        gResultsData.erase( this );
+    }
+    delete mData;
+}
+
+void AnalyzerResults::AddMarker( U64, MarkerType, Channel& )
+{
+}
+
+U64 AnalyzerResults::AddFrame( const Frame& frame )
+{
+    mData->mFrames.push_back( frame );
+    return mData->mFrameBase + mData->mFrames.size() - 1;
+}
+
+U64 AnalyzerResults::CommitPacketAndStartNewPacket()
+{
+    U64 end = mData->mFrameBase + mData->mFrames.size();
+
+    if ( end == mData->mPacketStart )
+    {
+        return INVALID_RESULT_INDEX;
+    }
+    mData->mPackets.push_back( std::make_pair( mData->mPacketStart, end - 1 ) );
+    mData->mPacketStart = end;
+
+    U64 packet_id = mData->mPacketBase + mData->mPackets.size() - 1;
+    if ( mData->mSink != NULL )
+    {
+        mData->mSink( this, packet_id, mData->mSinkContext );
+        mData->mFrameBase = end;
+        mData->mFrames.clear();
+        mData->mPacketBase = packet_id + 1;
+        mData->mPackets.clear();
+    }
+    return packet_id;
+}
+
+void AnalyzerResults::CancelPacketAndStartNewPacket()
+{
+    mData->mPacketStart = mData->mFrameBase + mData->mFrames.size();
+}
+
+void AnalyzerResults::AddChannelBubblesWillAppearOn( const Channel& )
+{
+}
+
+void AnalyzerResults::CommitResults()
+{
+}
+
+U64 AnalyzerResults::GetNumFrames()
+{
+    return mData->mFrameBase + mData->mFrames.size();
+}
+
+U64 AnalyzerResults::GetNumPackets()
+{
+    return mData->mPacketBase + mData->mPackets.size();
+}
+
+Frame AnalyzerResults::GetFrame( U64 frame_id )
+{
+    return mData->mFrames[size_t( frame_id - mData->mFrameBase )];
+}
+
+void AnalyzerResults::GetFramesContainedInPacket( U64 packet_id, U64* first_frame_id, U64* last_frame_id )
+{
+    *first_frame_id = mData->mPackets[size_t( packet_id - mData->mPacketBase )].first;
+    *last_frame_id  = mData->mPackets[size_t( packet_id - mData->mPacketBase )].second;
+}
+
+void AnalyzerResults::ClearResultStrings()
+{
+    mData->mResultString.clear();
+}
+
+void AnalyzerResults::AddResultString( const char* str1, const char* str2, const char* str3, const char* str4, const char* str5, const char* str6 )
+{
+    const char* strings[] = { str1, str2, str3, str4, str5, str6 };
+
+    mData->mResultString.clear();
+    for ( U32 i = 0; i < 6 && strings[i] != NULL; i++ )
+    {
+        mData->mResultString += strings[i];
+    }
+}
+
+void AnalyzerResults::ClearTabularText()
+{
+}
+
+void AnalyzerResults::AddTabularText( const char*, const char*, const char*, const char*, const char*, const char* )
+{
+}
+
+bool AnalyzerResults::UpdateExportProgressAndCheckForCancel( U64, U64 )
+{
+    return false;
+}
+
+// ---- AnalyzerSettings ----
+
+struct AnalyzerSettingsData
+{
+    struct ExportOption
+    {
+        U32 mUserId;
+        std::string mMenuText;
+        std::vector< std::pair< std::string, std::string > > mExtensions;
+    };
+
+    std::vector< AnalyzerSettingInterface* > mInterfaces;
+    std::vector< Channel > mChannels;
+    std::vector< std::string > mChannelLabels;
+    std::vector< bool > mChannelsUsed;
+    std::vector< ExportOption > mExportOptions;
+    std::string mErrorText;
+    std::string mReturnString;
+};
+
+AnalyzerSettings::AnalyzerSettings()
+:   mData( new AnalyzerSettingsData() )
+{
+}
+
+AnalyzerSettings::~AnalyzerSettings()
+{
+    delete mData;
+}
+
+void AnalyzerSettings::ClearChannels()
+{
+    mData->mChannels.clear();
+    mData->mChannelLabels.clear();
+    mData->mChannelsUsed.clear();
+}
+
+void AnalyzerSettings::AddChannel( Channel& channel, const char* channel_label, bool is_used )
+{
+    mData->mChannels.push_back( channel );
+    mData->mChannelLabels.push_back( channel_label );
+    mData->mChannelsUsed.push_back( is_used );
+}
+
+void AnalyzerSettings::SetErrorText( const char* error_text )
+{
+    mData->mErrorText = error_text;
+}
+
+void AnalyzerSettings::AddInterface( AnalyzerSettingInterface* analyzer_setting_interface )
+{
+    mData->mInterfaces.push_back( analyzer_setting_interface );
+}
+
+void AnalyzerSettings::AddExportOption( U32 user_id, const char* menu_text )
+{
+    AnalyzerSettingsData::ExportOption option;
+
+    option.mUserId   = user_id;
+    option.mMenuText = menu_text;
+    mData->mExportOptions.push_back( option );
+}
+
+void AnalyzerSettings::AddExportExtension( U32 user_id, const char* extension_description, const char* extension )
+{
+    for ( size_t i = 0; i < mData->mExportOptions.size(); i++ )
+    {
+        if ( mData->mExportOptions[i].mUserId == user_id )
+        {
+            mData->mExportOptions[i].mExtensions.push_back( std::make_pair( std::string( extension_description ), std::string( extension ) ) );
+        }
+    }
+}
+
+const char* AnalyzerSettings::SetReturnString( const char* str )
+{
+    mData->mReturnString = str;
+    return mData->mReturnString.c_str();
+}
+
+U32 AnalyzerSettings::GetSettingsInterfacesCount()
+{
+    return U32( mData->mInterfaces.size() );
+}
+
+AnalyzerSettingInterface* AnalyzerSettings::GetSettingsInterface( U32 index )
+{
+    return mData->mInterfaces[index];
+}
+
+U32 AnalyzerSettings::GetFileExtensionCount( U32 index_id )
+{
+    return U32( mData->mExportOptions[index_id].mExtensions.size() );
+}
+
+void AnalyzerSettings::GetFileExtension( U32 index_id, U32 extension_id, char const ** extension_description, char const ** extension )
+{
+    *extension_description = mData->mExportOptions[index_id].mExtensions[extension_id].first.c_str();
+    *extension             = mData->mExportOptions[index_id].mExtensions[extension_id].second.c_str();
+}
+
+U32 AnalyzerSettings::GetExportOptionsCount()
+{
+    return U32( mData->mExportOptions.size() );
+}
+
+void AnalyzerSettings::GetExportOption( U32 index, U32* user_id, char const ** menu_text )
+{
+    *user_id   = mData->mExportOptions[index].mUserId;
+    *menu_text = mData->mExportOptions[index].mMenuText.c_str();
+}
+
+const char* AnalyzerSettings::GetSaveErrorMessage()
+{
+    return mData->mErrorText.c_str();
+}
+
+// ---- AnalyzerSettingInterface ----
+
+struct AnalyzerSettingInterfaceData
+{
+    std::string mTitle;
+    std::string mToolTip;
+};
+
+AnalyzerSettingInterface::AnalyzerSettingInterface()
+:   mData( new AnalyzerSettingInterfaceData() )
+{
+}
+
+AnalyzerSettingInterface::~AnalyzerSettingInterface()
+{
+    delete mData;
+}
+
+void AnalyzerSettingInterface::operator delete( void* p )
+{
+    ::operator delete( p );
+}
+
+void* AnalyzerSettingInterface::operator new( size_t size )
+{
+    return ::operator new( size );
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterface::GetType()
+{
+    return INTERFACE_BASE;
+}
+
+const char* AnalyzerSettingInterface::GetToolTip()
+{
+    return mData->mToolTip.c_str();
+}
+
+const char* AnalyzerSettingInterface::GetTitle()
+{
+    return mData->mTitle.c_str();
+}
+
+bool AnalyzerSettingInterface::IsDisabled()
+{
+    return false;
+}
+
+void AnalyzerSettingInterface::SetTitleAndTooltip( const char* title, const char* tooltip )
+{
+    mData->mTitle   = title;
+    mData->mToolTip = tooltip;
+}
+
+struct AnalyzerSettingInterfaceChannelData
+{
+    Channel mChannel;
+    bool mSelectionOfNoneIsAllowed;
+};
+
+AnalyzerSettingInterfaceChannel::AnalyzerSettingInterfaceChannel()
+:   mChannelData( new AnalyzerSettingInterfaceChannelData() )
+{
+    mChannelData->mChannel = UNDEFINED_CHANNEL;
+    mChannelData->mSelectionOfNoneIsAllowed = false;
+}
+
+AnalyzerSettingInterfaceChannel::~AnalyzerSettingInterfaceChannel()
+{
+    delete mChannelData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceChannel::GetType()
+{
+    return INTERFACE_CHANNEL;
+}
+
+Channel AnalyzerSettingInterfaceChannel::GetChannel()
+{
+    return mChannelData->mChannel;
+}
+
+void AnalyzerSettingInterfaceChannel::SetChannel( const Channel& channel )
+{
+    mChannelData->mChannel = channel;
+}
+
+bool AnalyzerSettingInterfaceChannel::GetSelectionOfNoneIsAllowed()
+{
+    return mChannelData->mSelectionOfNoneIsAllowed;
+}
+
+void AnalyzerSettingInterfaceChannel::SetSelectionOfNoneIsAllowed( bool is_allowed )
+{
+    mChannelData->mSelectionOfNoneIsAllowed = is_allowed;
+}
+
+struct AnalyzerSettingInterfaceNumberListData
+{
+    double mNumber;
+    std::vector< double > mNumbers;
+    std::vector< std::string > mStrings;
+    std::vector< std::string > mToolTips;
+};
+
+AnalyzerSettingInterfaceNumberList::AnalyzerSettingInterfaceNumberList()
+:   mNumberListData( new AnalyzerSettingInterfaceNumberListData() )
+{
+    mNumberListData->mNumber = 0;
+}
+
+AnalyzerSettingInterfaceNumberList::~AnalyzerSettingInterfaceNumberList()
+{
+    delete mNumberListData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceNumberList::GetType()
+{
+    return INTERFACE_NUMBER_LIST;
+}
+
+double AnalyzerSettingInterfaceNumberList::GetNumber()
+{
+    return mNumberListData->mNumber;
+}
+
+void AnalyzerSettingInterfaceNumberList::SetNumber( double number )
+{
+    mNumberListData->mNumber = number;
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxNumbersCount()
+{
+    return U32( mNumberListData->mNumbers.size() );
+}
+
+double AnalyzerSettingInterfaceNumberList::GetListboxNumber( U32 index )
+{
+    return mNumberListData->mNumbers[index];
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxStringsCount()
+{
+    return U32( mNumberListData->mStrings.size() );
+}
+
+const char* AnalyzerSettingInterfaceNumberList::GetListboxString( U32 index )
+{
+    return mNumberListData->mStrings[index].c_str();
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxTooltipsCount()
+{
+    return U32( mNumberListData->mToolTips.size() );
+}
+
+const char* AnalyzerSettingInterfaceNumberList::GetListboxTooltip( U32 index )
+{
+    return mNumberListData->mToolTips[index].c_str();
+}
+
+void AnalyzerSettingInterfaceNumberList::AddNumber( double number, const char* str, const char* tooltip )
+{
+    mNumberListData->mNumbers.push_back( number );
+    mNumberListData->mStrings.push_back( str );
+    mNumberListData->mToolTips.push_back( tooltip );
+}
+
+void AnalyzerSettingInterfaceNumberList::ClearNumbers()
+{
+    mNumberListData->mNumbers.clear();
+    mNumberListData->mStrings.clear();
+    mNumberListData->mToolTips.clear();
+}
+
+struct AnalyzerSettingInterfaceIntegerData
+{
+    int mInteger;
+    int mMax;
+    int mMin;
+};
+
+AnalyzerSettingInterfaceInteger::AnalyzerSettingInterfaceInteger()
+:   mIntegerData( new AnalyzerSettingInterfaceIntegerData() )
+{
+    mIntegerData->mInteger = 0;
+    mIntegerData->mMax = 0x7FFFFFFF;
+    mIntegerData->mMin = -0x7FFFFFFF;
+}
+
+AnalyzerSettingInterfaceInteger::~AnalyzerSettingInterfaceInteger()
+{
+    delete mIntegerData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceInteger::GetType()
+{
+    return INTERFACE_INTEGER;
+}
+
+int AnalyzerSettingInterfaceInteger::GetInteger()
+{
+    return mIntegerData->mInteger;
+}
+
+void AnalyzerSettingInterfaceInteger::SetInteger( int integer )
+{
+    mIntegerData->mInteger = integer;
+}
+
+int AnalyzerSettingInterfaceInteger::GetMax()
+{
+    return mIntegerData->mMax;
+}
+
+int AnalyzerSettingInterfaceInteger::GetMin()
+{
+    return mIntegerData->mMin;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMax( int max )
+{
+    mIntegerData->mMax = max;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMin( int min )
+{
+    mIntegerData->mMin = min;
+}
+
+struct AnalyzerSettingInterfaceTextData
+{
+    std::string mText;
+    AnalyzerSettingInterfaceText::TextType mTextType;
+};
+
+AnalyzerSettingInterfaceText::AnalyzerSettingInterfaceText()
+:   mTextData( new AnalyzerSettingInterfaceTextData() )
+{
+    mTextData->mTextType = NormalText;
+}
+
+AnalyzerSettingInterfaceText::~AnalyzerSettingInterfaceText()
+{
+    delete mTextData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceText::GetType()
+{
+    return INTERFACE_TEXT;
+}
+
+const char* AnalyzerSettingInterfaceText::GetText()
+{
+    return mTextData->mText.c_str();
+}
+
+void AnalyzerSettingInterfaceText::SetText( const char* text )
+{
+    mTextData->mText = text;
+}
+
+AnalyzerSettingInterfaceText::TextType AnalyzerSettingInterfaceText::GetTextType()
+{
+    return mTextData->mTextType;
+}
+
+void AnalyzerSettingInterfaceText::SetTextType( TextType text_type )
+{
+    mTextData->mTextType = text_type;
+}
+
+struct AnalyzerSettingInterfaceBoolData
+{
+    bool mValue;
+    std::string mCheckBoxText;
+};
+
+AnalyzerSettingInterfaceBool::AnalyzerSettingInterfaceBool()
+:   mBoolData( new AnalyzerSettingInterfaceBoolData() )
+{
+    mBoolData->mValue = false;
+}
+
+AnalyzerSettingInterfaceBool::~AnalyzerSettingInterfaceBool()
+{
+    delete mBoolData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceBool::GetType()
+{
+    return INTERFACE_BOOL;
+}
+
+bool AnalyzerSettingInterfaceBool::GetValue()
+{
+    return mBoolData->mValue;
+}
+
+void AnalyzerSettingInterfaceBool::SetValue( bool value )
+{
+    mBoolData->mValue = value;
+}
+
+const char* AnalyzerSettingInterfaceBool::GetCheckBoxText()
+{
+    return mBoolData->mCheckBoxText.c_str();
+}
+
+void AnalyzerSettingInterfaceBool::SetCheckBoxText( const char* text )
+{
+    mBoolData->mCheckBoxText = text;
+}
+
+// ---- AnalyzerTypes ----
+
+Channel::Channel()
+:   mDeviceId( 0 ),
+    mChannelIndex( 0 )
+{
+}
+
+Channel::Channel( const Channel& channel )
+:   mDeviceId( channel.mDeviceId ),
+    mChannelIndex( channel.mChannelIndex )
+{
+}
+
+Channel::Channel( U64 device_id, U32 channel_index )
+:   mDeviceId( device_id ),
+    mChannelIndex( channel_index )
+{
+}
+
+Channel::~Channel()
+{
+}
+
+Channel& Channel::operator=( const Channel& channel )
+{
+    mDeviceId     = channel.mDeviceId;
+    mChannelIndex = channel.mChannelIndex;
+    return *this;
+}
+
+bool Channel::operator==( const Channel& channel ) const
+{
+    return mDeviceId == channel.mDeviceId && mChannelIndex == channel.mChannelIndex;
+}
+
+bool Channel::operator!=( const Channel& channel ) const
+{
+    return !( *this == channel );
+}
+
+bool Channel::operator>( const Channel& channel ) const
+{
+    return channel < *this;
+}
+
+bool Channel::operator<( const Channel& channel ) const
+{
+    return mDeviceId != channel.mDeviceId ? mDeviceId < channel.mDeviceId : mChannelIndex < channel.mChannelIndex;
+}
+
+// ---- AnalyzerHelpers ----
+
+bool AnalyzerHelpers::IsEven( U64 value )
+{
+    return ( value & 1 ) == 0;
+}
+
+bool AnalyzerHelpers::IsOdd( U64 value )
+{
+    return ( value & 1 ) != 0;
+}
+
+void AnalyzerHelpers::GetNumberString( U64 number, DisplayBase display_base, U32 num_data_bits, char* result_string, U32 result_string_max_length )
+{
+    U32 digits = num_data_bits == 0 ? 1 : ( num_data_bits + 3 ) / 4;
+
+    switch ( display_base )
+    {
+    case Binary:
+    {
+        std::string bits = "0b";
+        for ( U32 i = num_data_bits == 0 ? 1 : num_data_bits; i != 0; i-- )
+        {
+            bits += ( number >> ( i - 1 ) ) & 1 ? '1' : '0';
+        }
+        snprintf( result_string, result_string_max_length, "%s", bits.c_str() );
+        break;
+    }
+    case Decimal:
+        snprintf( result_string, result_string_max_length, "%llu", (unsigned long long)number );
+        break;
+    case ASCII:
+        if ( number >= 0x20 && number < 0x7F )
+            snprintf( result_string, result_string_max_length, "%c", char( number ) );
+        else
+            snprintf( result_string, result_string_max_length, "'%llu'", (unsigned long long)number );
+        break;
+    case AsciiHex:
+        if ( number >= 0x20 && number < 0x7F )
+            snprintf( result_string, result_string_max_length, "'%c' (0x%0*llX)", char( number ), int( digits ), (unsigned long long)number );
+        else
+            snprintf( result_string, result_string_max_length, "0x%0*llX", int( digits ), (unsigned long long)number );
+        break;
+    default:
+        snprintf( result_string, result_string_max_length, "0x%0*llX", int( digits ), (unsigned long long)number );
+        break;
+    }
+}
+
+// seconds from the trigger, to one sample period
+void AnalyzerHelpers::GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length )
+{
+    S64 samples = S64( sample - trigger_sample );
+    int decimals = 0;
+
+    for ( U64 resolution = 1; resolution < sample_rate_hz && decimals < 12; resolution *= 10 )
+    {
+        decimals++;
+    }
+    snprintf( result_string, result_string_max_length, "%.*f", decimals, double( samples ) / double( sample_rate_hz ) );
+}
+
+void AnalyzerHelpers::Assert( const char* message )
+{
+    fprintf( stderr, "assertion failed: %s\n", message );
+    abort();
+}
+
+U64 AnalyzerHelpers::AdjustSimulationTargetSample( U64 target_sample, U32 sample_rate, U32 simulation_sample_rate )
+{
+    return U64( double( target_sample ) * double( simulation_sample_rate ) / double( sample_rate ) );
+}
+
+void* AnalyzerHelpers::StartFile( const char* file_name, bool is_binary )
+{
+    FILE* file = fopen( file_name, is_binary ? "wb" : "w" );
+    if ( file == NULL )
+    {
+        throw std::runtime_error( std::string( "cannot write " ) + file_name );
+    }
+    return file;
+}
+
+void AnalyzerHelpers::AppendToFile( const U8* data, U32 data_length, void* file )
+{
+    if ( fwrite( data, 1, data_length, (FILE*)file ) != data_length )
+    {
+        throw std::runtime_error( "write error" );
+    }
+}
+
+void AnalyzerHelpers::EndFile( void* file )
+{
+    fclose( (FILE*)file );
+}
+
+// ---- ClockGenerator, BitExtractor, DataBuilder ----
+
+struct ClockGeneratorData
+{
+    double mSamplesPerHalfPeriod;
+    U32 mSampleRate;
+    double mError;          // fraction of a sample carried to the next step
+};
+
+ClockGenerator::ClockGenerator()
+:   mData( new ClockGeneratorData() )
+{
+    mData->mSamplesPerHalfPeriod = 1;
+    mData->mSampleRate = 0;
+    mData->mError = 0;
+}
+
+ClockGenerator::~ClockGenerator()
+{
+    delete mData;
+}
+
+void ClockGenerator::Init( double target_frequency, U32 sample_rate_hz )
+{
+    mData->mSamplesPerHalfPeriod = double( sample_rate_hz ) / target_frequency / 2.0;
+    mData->mSampleRate = sample_rate_hz;
+    mData->mError = 0;
+}
+
+U32 ClockGenerator::AdvanceByHalfPeriod( double multiple )
+{
+    double samples = mData->mSamplesPerHalfPeriod * multiple + mData->mError;
+    U32 whole = U32( std::floor( samples + 0.5 ) );
+
+    mData->mError = samples - whole;
+    return whole;
+}
+
+U32 ClockGenerator::AdvanceByTimeS( double time_s )
+{
+    double samples = time_s * mData->mSampleRate + mData->mError;
+    U32 whole = U32( std::floor( samples + 0.5 ) );
+
+    mData->mError = samples - whole;
+    return whole;
+}
+
+struct BitExtractorData
+{
+    U64 mData;
+    U64 mMask;
+    AnalyzerEnums::ShiftOrder mShiftOrder;
+};
+
+BitExtractor::BitExtractor( U64 data, AnalyzerEnums::ShiftOrder shift_order, U32 num_bits )
+:   mData( new BitExtractorData() )
+{
+    mData->mData = data;
+    mData->mShiftOrder = shift_order;
+    mData->mMask = shift_order == AnalyzerEnums::MsbFirst ? U64( 1 ) << ( num_bits - 1 ) : 1;
+}
+
+BitExtractor::~BitExtractor()
+{
+    delete mData;
+}
+
+BitState BitExtractor::GetNextBit()
+{
+    BitState bit = ( mData->mData & mData->mMask ) != 0 ? BIT_HIGH : BIT_LOW;
+
+    mData->mMask = mData->mShiftOrder == AnalyzerEnums::MsbFirst ? mData->mMask >> 1 : mData->mMask << 1;
+    return bit;
+}
+
+struct DataBuilderData
+{
+    U64* mData;
+    U64 mMask;
+    AnalyzerEnums::ShiftOrder mShiftOrder;
+};
+
+DataBuilder::DataBuilder()
+:   mData( new DataBuilderData() )
+{
+    mData->mData = NULL;
+    mData->mMask = 0;
+    mData->mShiftOrder = AnalyzerEnums::MsbFirst;
+}
+
+DataBuilder::~DataBuilder()
+{
+    delete mData;
+}
+
+void DataBuilder::Reset( U64* data, AnalyzerEnums::ShiftOrder shift_order, U32 num_bits )
+{
+    mData->mData = data;
+    mData->mShiftOrder = shift_order;
+    mData->mMask = shift_order == AnalyzerEnums::MsbFirst ? U64( 1 ) << ( num_bits - 1 ) : 1;
+    *data = 0;
+}
+
+void DataBuilder::AddBit( BitState bit )
+{
+    if ( bit == BIT_HIGH )
+    {
+        *mData->mData |= mData->mMask;
+    }
+    mData->mMask = mData->mShiftOrder == AnalyzerEnums::MsbFirst ? mData->mMask >> 1 : mData->mMask << 1;
+}
+
+// ---- SimpleArchive ----
+
+// values separated by spaces, strings as their length, a colon and the text
+struct SimpleArchiveData
+{
+    std::ostringstream mOut;
+    std::istringstream mIn;
+    std::string mString;
+    std::deque< std::string > mStrings;     // handed out by operator>>
+};
+
+SimpleArchive::SimpleArchive()
+:   mData( new SimpleArchiveData() )
+{
+    mData->mOut.precision( 17 );
+}
+
+SimpleArchive::~SimpleArchive()
+{
+    delete mData;
+}
+
+void SimpleArchive::SetString( const char* archive_string )
+{
+    mData->mIn.clear();
+    mData->mIn.str( archive_string );
+}
+
+const char* SimpleArchive::GetString()
+{
+    mData->mString = mData->mOut.str();
+    return mData->mString.c_str();
+}
+
+bool SimpleArchive::operator<<( U64 data )          { mData->mOut << data << ' '; return true; }
+bool SimpleArchive::operator<<( U32 data )          { mData->mOut << data << ' '; return true; }
+bool SimpleArchive::operator<<( S64 data )          { mData->mOut << data << ' '; return true; }
+bool SimpleArchive::operator<<( S32 data )          { mData->mOut << data << ' '; return true; }
+bool SimpleArchive::operator<<( double data )       { mData->mOut << data << ' '; return true; }
+bool SimpleArchive::operator<<( bool data )         { mData->mOut << data << ' '; return true; }
+
+bool SimpleArchive::operator<<( const char* data )
+{
+    mData->mOut << strlen( data ) << ':' << data << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator<<( Channel& data )
+{
+    mData->mOut << data.mDeviceId << ' ' << data.mChannelIndex << ' ';
+    return true;
+}
+
+bool SimpleArchive::operator>>( U64& data )         { return bool( mData->mIn >> data ); }
+bool SimpleArchive::operator>>( U32& data )         { return bool( mData->mIn >> data ); }
+bool SimpleArchive::operator>>( S64& data )         { return bool( mData->mIn >> data ); }
+bool SimpleArchive::operator>>( S32& data )         { return bool( mData->mIn >> data ); }
+bool SimpleArchive::operator>>( double& data )      { return bool( mData->mIn >> data ); }
+bool SimpleArchive::operator>>( bool& data )        { return bool( mData->mIn >> data ); }
+
+bool SimpleArchive::operator>>( char const ** data )
+{
+    size_t length;
+    char colon;
+
+    if ( !( mData->mIn >> length >> colon ) || colon != ':' )
+    {
+        return false;
+    }
+    mData->mStrings.push_back( std::string( length, ' ' ) );
+    if ( length != 0 && !mData->mIn.read( &mData->mStrings.back()[0], std::streamsize( length ) ) )
+    {
+        return false;
+    }
+    *data = mData->mStrings.back().c_str();
+    return true;
+}
+
+bool SimpleArchive::operator>>( Channel& data )
+{
+    return bool( mData->mIn >> data.mDeviceId >> data.mChannelIndex );
+}
+
+// ---- Simulation ----
+
+// transitions are kept for RFFEHostSimulate to decode
+struct SimulationChannelDescriptorData
+{
+    Channel mChannel;
+    U32 mSampleRate;
+    BitState mInitialBitState;
+    BitState mBitState;
+    U64 mSample;
+    std::vector< U64 > mTransitions;
+};
+
+SimulationChannelDescriptor::SimulationChannelDescriptor()
+:   mData( new SimulationChannelDescriptorData() )
+{
+    mData->mSampleRate = 0;
+    mData->mInitialBitState = BIT_LOW;
+    mData->mBitState = BIT_LOW;
+    mData->mSample = 0;
+}
+
+SimulationChannelDescriptor::SimulationChannelDescriptor( const SimulationChannelDescriptor& other )
+:   mData( new SimulationChannelDescriptorData( *other.mData ) )
+{
+}
+
+SimulationChannelDescriptor::~SimulationChannelDescriptor()
+{
+    delete mData;
+}
+
+SimulationChannelDescriptor& SimulationChannelDescriptor::operator=( const SimulationChannelDescriptor& other )
+{
+    *mData = *other.mData;
+    return *this;
+}
+
+void SimulationChannelDescriptor::Transition()
+{
+    mData->mTransitions.push_back( mData->mSample );
+    mData->mBitState = mData->mBitState == BIT_HIGH ? BIT_LOW : BIT_HIGH;
+}
+
+void SimulationChannelDescriptor::TransitionIfNeeded( BitState bit_state )
+{
+    if ( bit_state != mData->mBitState )
+    {
+        Transition();
+    }
+}
+
+void SimulationChannelDescriptor::Advance( U32 num_samples_to_advance )
+{
+    mData->mSample += num_samples_to_advance;
+}
+
+BitState SimulationChannelDescriptor::GetCurrentBitState()
+{
+    return mData->mBitState;
+}
+
+U64 SimulationChannelDescriptor::GetCurrentSampleNumber()
+{
+    return mData->mSample;
+}
+
+void SimulationChannelDescriptor::SetChannel( Channel& channel )
+{
+    mData->mChannel = channel;
+}
+
+void SimulationChannelDescriptor::SetSampleRate( U32 sample_rate_hz )
+{
+    mData->mSampleRate = sample_rate_hz;
+}
+
+void SimulationChannelDescriptor::SetInitialBitState( BitState intial_bit_state )
+{
+    mData->mInitialBitState = intial_bit_state;
+    mData->mBitState = intial_bit_state;
+}
+
+Channel SimulationChannelDescriptor::GetChannel()
+{
+    return mData->mChannel;
+}
+
+U32 SimulationChannelDescriptor::GetSampleRate()
+{
+    return mData->mSampleRate;
+}
+
+BitState SimulationChannelDescriptor::GetInitialBitState()
+{
+    return mData->mInitialBitState;
+}
+
+void* SimulationChannelDescriptor::GetData()
+{
+    return mData;
+}
+
+#define RFFE_HOST_MAX_SIMULATION_CHANNELS   64
+
+struct SimulationChannelDescriptorGroupData
+{
+    std::vector< SimulationChannelDescriptor > mChannels;
+};
+
+SimulationChannelDescriptorGroup::SimulationChannelDescriptorGroup()
+:   mData( new SimulationChannelDescriptorGroupData() )
+{
+    // Add hands out pointers into the array, it must not move
+    mData->mChannels.reserve( RFFE_HOST_MAX_SIMULATION_CHANNELS );
+}
+
+SimulationChannelDescriptorGroup::~SimulationChannelDescriptorGroup()
+{
+    delete mData;
+}
+
+SimulationChannelDescriptor* SimulationChannelDescriptorGroup::Add( Channel& channel, U32 sample_rate, BitState intial_bit_state )
+{
+    if ( mData->mChannels.size() == RFFE_HOST_MAX_SIMULATION_CHANNELS )
+    {
+        AnalyzerHelpers::Assert( "too many simulation channels" );
+    }
+    mData->mChannels.push_back( SimulationChannelDescriptor() );
+    mData->mChannels.back().SetChannel( channel );
+    mData->mChannels.back().SetSampleRate( sample_rate );
+    mData->mChannels.back().SetInitialBitState( intial_bit_state );
+    return &mData->mChannels.back();
+}
+
+void SimulationChannelDescriptorGroup::AdvanceAll( U32 num_samples_to_advance )
+{
+    for ( size_t i = 0; i < mData->mChannels.size(); i++ )
+    {
+        mData->mChannels[i].Advance( num_samples_to_advance );
+    }
+}
+
+SimulationChannelDescriptor* SimulationChannelDescriptorGroup::GetArray()
+{
+    return mData->mChannels.empty() ? NULL : &mData->mChannels[0];
+}
+
+U32 SimulationChannelDescriptorGroup::GetCount()
+{
+    return U32( mData->mChannels.size() );
+}
+
+void RFFEHostSimulate( Analyzer* analyzer, U32 sample_rate, U64 samples, RFFECaptureFile* capture )
+{
+    SimulationChannelDescriptor* channels;
+
+    // the simulation runs at the rate of the capture it is generated into
+    capture->OpenEdges( sample_rate, 0, 0 );
+    RFFEHostAttachCapture( analyzer, capture );
+    U32 count = analyzer->GenerateSimulationData( samples, sample_rate, &channels );
+
+    // the edges stay with the analyzer's generator; every bus ran on to the
+    // end of its last packet, the capture ends where the last one did
+    U64 last_sample = 0;
+    for ( U32 i = 0; i < count; i++ )
+    {
+        last_sample = std::max( last_sample, channels[i].GetCurrentSampleNumber() );
+    }
+    capture->OpenEdges( sample_rate, 0, last_sample );
+    for ( U32 i = 0; i < count; i++ )
+    {
+        const SimulationChannelDescriptorData* data = (const SimulationChannelDescriptorData*)channels[i].GetData();
+        capture->AddEdgeChannel( data->mChannel.mChannelIndex, data->mTransitions.empty() ? NULL : &data->mTransitions[0],
+                                 data->mTransitions.size(), data->mInitialBitState );
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef RFFE_HOST
+#define RFFE_HOST
+
+#include <Analyzer.h>
+#include <string>
+#include <vector>
+#include "RFFECaptureFile.h"
+
+// The command-line decoder runs the analyzer without Logic. RFFEHost.cpp
+// implements, in place of libAnalyzer, the part of the Analyzer SDK that
+// the analyzer uses: channel data comes from a capture file, frames and
+// packets are kept in memory (or handed to a packet sink and dropped),
+// markers and bubbles are dropped.
+
+// what the SDK hands to AnalyzerChannelData: one channel of the capture
+class ChannelData : public RFFECaptureChannel
+{
+public:
+    ChannelData( RFFECaptureFile* capture, int bit )
+    :   RFFECaptureChannel( capture, bit )
+    {
+    }
+};
+
+// called for every packet the analyzer commits; its frames are dropped when
+// the sink returns, so a decode of any length keeps no results
+typedef void ( *RFFEHostPacketSink )( AnalyzerResults* results, U64 packet_id, void* context );
+
+struct AnalyzerData
+{
+    AnalyzerData();
+    ~AnalyzerData();
+
+    AnalyzerSettings* mSettings;
+    AnalyzerResults* mResults;
+    RFFECaptureFile* mCapture;
+    U64 mProgress;              // last sample reported by the analyzer
+    RFFEHostPacketSink mSink;
+    void* mSinkContext;
+    std::vector< U32 > mChannelIndex;
+    std::vector< ChannelData* > mChannelData;
+    std::vector< AnalyzerChannelData* > mChannels;
+};
+
+// the analyzer's channels are read from capture from now on
+void RFFEHostAttachCapture( Analyzer* analyzer, RFFECaptureFile* capture );
+
+// packets of the next decode go to sink instead of the results (NULL: back
+// to the results)
+void RFFEHostSetPacketSink( Analyzer* analyzer, RFFEHostPacketSink sink, void* context );
+
+// the capture becomes the analyzer's simulation data, generated at
+// sample_rate up to at least samples; with randomized data the next decode
+// checks what it decodes against what was generated
+void RFFEHostSimulate( Analyzer* analyzer, U32 sample_rate, U64 samples, RFFECaptureFile* capture );
+
+// sets the setting with the title as Logic would: a channel number (or
+// "none"), a list entry by number or name, an integer, text, or a check box
+// (1/0, true/false, yes/no, on/off)
+bool RFFEHostApplySetting( AnalyzerSettings* settings, const std::string& title, const std::string& value, std::string* error );
+
+// applies the (title, value) settings in order, then checks them as Logic
+// does when they are saved; streaming is off, the data is all there
+bool RFFEHostConfigure( AnalyzerSettings* settings, const std::vector< std::pair< std::string, std::string > >& values,
+                        std::string* error );
+
+#endif //RFFE_HOST
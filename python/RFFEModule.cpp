@@ -0,0 +1,471 @@
+// rffe._rffe: decodes SCLK/SDATA held in Python buffers (NumPy arrays)
+// with the RFFE analyzer, through the SDK runtime of the command-line
+// decoder. See "Python module" in README.md; python/rffe/__init__.py is the
+// interface to use.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "RFFEHost.h"
+#include "RFFECaptureFile.h"
+#include "RFFEAnalyzer.h"
+#include "RFFEAnalyzerResults.h"
+#include <AnalyzerSettings.h>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <string.h>
+
+// A decoded packet, the record of rffe.PACKET_DTYPE (aligned like a NumPy
+// dtype with align=True); its payload is payload[mPayloadOffset:][:mByteCount]
+struct RFFEPythonPacket
+{
+    U64 mSample;            // SSC
+    U64 mEndSample;         // end of the bus park
+    U64 mPayloadOffset;
+    U32 mParity;            // parity bit of frame i in bit i, command frame first
+    U32 mParityErrors;
+    U32 mSclkFrequency;     // Hz, 0 if not measured
+    U32 mCount;             // packets of a collapsed run, 1 otherwise
+    U16 mAddress;
+    U8  mBus;
+    U8  mSlaveAddress;
+    U8  mType;              // RFFEAnalyzerResults::RffeTypeFieldType
+    U8  mCommand;
+    U8  mByteCount;
+    U8  mParityCount;
+    U8  mHasAddress;
+    U8  mDecodeError;
+    U8  mTimingViolations;
+};
+
+// Takes the packets of a decode straight from the analyzer, without frames:
+// into the caller's arrays when given (decode fails once they are full),
+// into mPackets and mPayload otherwise
+class RFFEPythonDecode : public RFFEPacketOutput
+{
+public:
+    RFFEPythonDecode();
+
+    void SetArrays( Py_buffer* packets, Py_buffer* payload );
+    virtual void AddPacket( const RFFEPacket& packet, const RFFEPacketExtras& extras );
+
+    std::vector< U8 > mPackets;
+    std::vector< U8 > mPayload;
+    U8* mPacketArray;       // NULL: the vectors
+    U8* mPayloadArray;
+    U64 mPacketCapacity;    // in records
+    U64 mPayloadCapacity;
+    U64 mPacketCount;
+    U64 mPayloadSize;
+    bool mTruncated;
+    std::string mError;
+};
+
+// ---- output buffers ----
+
+// A std::vector exported through the buffer protocol, so NumPy wraps the
+// decoded records without copying them
+struct RFFEBufferObject
+{
+    PyObject_HEAD
+    std::vector< U8 >* mData;
+};
+
+static void RFFEBuffer_dealloc( RFFEBufferObject* self )
+{
+    delete self->mData;
+    Py_TYPE( self )->tp_free( (PyObject*)self );
+}
+
+static int RFFEBuffer_getbuffer( RFFEBufferObject* self, Py_buffer* view, int flags )
+{
+    return PyBuffer_FillInfo( view, (PyObject*)self, self->mData->empty() ? NULL : &( *self->mData )[0],
+                              Py_ssize_t( self->mData->size() ), 0, flags );
+}
+
+static PyBufferProcs RFFEBuffer_as_buffer = {
+    (getbufferproc)RFFEBuffer_getbuffer,
+    NULL,
+};
+
+// the rest of the slots are set in PyInit__rffe or stay 0
+#if defined( __GNUC__ )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+static PyTypeObject RFFEBufferType = {
+    PyVarObject_HEAD_INIT( NULL, 0 )
+    "rffe._rffe.Buffer",                    // tp_name
+    sizeof( RFFEBufferObject ),             // tp_basicsize
+};
+#if defined( __GNUC__ )
+#pragma GCC diagnostic pop
+#endif
+
+// takes the contents of data
+static PyObject* NewBuffer( std::vector< U8 >* data )
+{
+    RFFEBufferObject* buffer = PyObject_New( RFFEBufferObject, &RFFEBufferType );
+
+    if ( buffer == NULL )
+    {
+        return NULL;
+    }
+    buffer->mData = new std::vector< U8 >();
+    buffer->mData->swap( *data );
+    return (PyObject*)buffer;
+}
+
+// ---- decode ----
+
+RFFEPythonDecode::RFFEPythonDecode()
+:   mPacketArray( NULL ),
+    mPayloadArray( NULL ),
+    mPacketCapacity( 0 ),
+    mPayloadCapacity( 0 ),
+    mPacketCount( 0 ),
+    mPayloadSize( 0 ),
+    mTruncated( false )
+{
+}
+
+void RFFEPythonDecode::SetArrays( Py_buffer* packets, Py_buffer* payload )
+{
+    mPacketArray     = (U8*)packets->buf;
+    mPacketCapacity  = U64( packets->len ) / sizeof( RFFEPythonPacket );
+    mPayloadArray    = (U8*)payload->buf;
+    mPayloadCapacity = U64( payload->len );
+}
+
+void RFFEPythonDecode::AddPacket( const RFFEPacket& packet, const RFFEPacketExtras& extras )
+{
+    RFFEPythonPacket record;
+
+    memset( &record, 0, sizeof( record ) );
+    record.mSample           = packet.mStartingSample;
+    record.mEndSample        = packet.mEndingSample;
+    record.mPayloadOffset    = mPayloadSize;
+    record.mParity           = packet.mParity;
+    record.mParityErrors     = packet.mParityErrors;
+    record.mSclkFrequency    = packet.mSclkFrequency;
+    record.mCount            = 1 + extras.mRepeats;
+    record.mAddress          = packet.mAddress;
+    record.mBus              = packet.mBus;
+    record.mSlaveAddress     = packet.mSlaveAddress;
+    record.mType             = packet.mType;
+    record.mCommand          = packet.mCommand;
+    record.mByteCount        = packet.mByteCount;
+    record.mParityCount      = packet.mParityCount;
+    record.mHasAddress       = extras.mHasAddress;
+    record.mDecodeError      = extras.mErrorFrames != 0;
+    record.mTimingViolations = packet.mTimingViolations;
+
+    if ( mPacketArray == NULL )
+    {
+        const U8* bytes = (const U8*)&record;
+        mPackets.insert( mPackets.end(), bytes, bytes + sizeof( record ) );
+        mPayload.insert( mPayload.end(), packet.mData, packet.mData + packet.mByteCount );
+    }
+    else if ( mPacketCount == mPacketCapacity || mPayloadSize + packet.mByteCount > mPayloadCapacity )
+    {
+        // ends the decode, the packets so far are not handed back
+        throw std::length_error( "the out arrays are full, more packets were decoded" );
+    }
+    else
+    {
+        memcpy( mPacketArray + mPacketCount * sizeof( record ), &record, sizeof( record ) );
+        memcpy( mPayloadArray + mPayloadSize, packet.mData, packet.mByteCount );
+    }
+    mPacketCount++;
+    mPayloadSize += packet.mByteCount;
+}
+
+// runs without the GIL: nothing in here touches Python objects
+static void Decode( RFFECaptureFile* capture, const std::vector< std::pair< std::string, std::string > >& settings_values,
+                    RFFEPythonDecode* decode )
+{
+    Analyzer* analyzer = CreateAnalyzer();
+
+    decode->mTruncated = false;
+    if ( RFFEHostConfigure( analyzer->GetAnalyzerData()->mSettings, settings_values, &decode->mError ) )
+    {
+        RFFEHostAttachCapture( analyzer, capture );
+        ( (RFFEAnalyzer*)analyzer )->SetPacketOutput( decode );
+        try
+        {
+            analyzer->SetupResults();
+            analyzer->WorkerThread();
+        }
+        catch ( RFFECaptureEnd& )
+        {
+            // a packet ran past the end: the ones before it are in
+            decode->mTruncated = true;
+        }
+        catch ( std::exception& e )
+        {
+            decode->mError = e.what();
+        }
+    }
+    DestroyAnalyzer( analyzer );
+}
+
+// ---- arguments ----
+
+static bool GetSettings( PyObject* object, std::vector< std::pair< std::string, std::string > >* values )
+{
+    PyObject* items = PySequence_Fast( object, "settings must be a sequence of (title, value) pairs" );
+
+    if ( items == NULL )
+    {
+        return false;
+    }
+    for ( Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE( items ); i++ )
+    {
+        const char* title;
+        const char* value;
+
+        if ( !PyArg_ParseTuple( PySequence_Fast_GET_ITEM( items, i ), "ss", &title, &value ) )
+        {
+            Py_DECREF( items );
+            return false;
+        }
+        values->push_back( std::make_pair( std::string( title ), std::string( value ) ) );
+    }
+    Py_DECREF( items );
+    return true;
+}
+
+static bool IsIntegerFormat( const char* format )
+{
+    size_t length = format == NULL ? 1 : strlen( format );
+    return format == NULL || ( length != 0 && strchr( "bBhHiIlLqQnN?", format[length - 1] ) != NULL );
+}
+
+// out: None, or (packets, payload) writable arrays the decode fills
+static bool GetOut( PyObject* out, Py_buffer* views, RFFEPythonDecode* decode )
+{
+    if ( out == NULL || out == Py_None )
+    {
+        return true;
+    }
+
+    PyObject* packets;
+    PyObject* payload;
+    if ( !PyArg_ParseTuple( out, "OO", &packets, &payload ) ||
+         PyObject_GetBuffer( packets, &views[0], PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE ) != 0 )
+    {
+        return false;
+    }
+    if ( PyObject_GetBuffer( payload, &views[1], PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE ) != 0 )
+    {
+        PyBuffer_Release( &views[0] );
+        return false;
+    }
+    decode->SetArrays( &views[0], &views[1] );
+    return true;
+}
+
+static void ReleaseOut( Py_buffer* views, RFFEPythonDecode* decode )
+{
+    if ( decode->mPacketArray != NULL )
+    {
+        PyBuffer_Release( &views[0] );
+        PyBuffer_Release( &views[1] );
+    }
+}
+
+// (packets, payload, truncated), with the numbers of records and payload
+// bytes in place of the buffers when they went to out arrays
+static PyObject* MakeResult( RFFEPythonDecode* decode )
+{
+    if ( !decode->mError.empty() )
+    {
+        PyErr_SetString( PyExc_ValueError, decode->mError.c_str() );
+        return NULL;
+    }
+    if ( decode->mPacketArray != NULL )
+    {
+        return Py_BuildValue( "(KKO)", (unsigned long long)decode->mPacketCount, (unsigned long long)decode->mPayloadSize,
+                              decode->mTruncated ? Py_True : Py_False );
+    }
+
+    PyObject* packets = NewBuffer( &decode->mPackets );
+    PyObject* payload = NewBuffer( &decode->mPayload );
+    if ( packets == NULL || payload == NULL )
+    {
+        Py_XDECREF( packets );
+        Py_XDECREF( payload );
+        return NULL;
+    }
+    return Py_BuildValue( "(NNO)", packets, payload, decode->mTruncated ? Py_True : Py_False );
+}
+
+// decode_edges(channels, sample_rate, trigger_sample, last_sample, settings, out=None)
+// channels: sequence of (channel index, int64 edge array, initial state)
+static PyObject* rffe_decode_edges( PyObject*, PyObject* args )
+{
+    PyObject* channels;
+    unsigned int sample_rate;
+    unsigned long long trigger_sample;
+    unsigned long long last_sample;
+    PyObject* settings;
+    PyObject* out = NULL;
+    std::vector< std::pair< std::string, std::string > > settings_values;
+    RFFEPythonDecode decode;
+    Py_buffer out_views[2];
+
+    if ( !PyArg_ParseTuple( args, "OIKKO|O", &channels, &sample_rate, &trigger_sample, &last_sample, &settings, &out ) ||
+         !GetSettings( settings, &settings_values ) ||
+         !GetOut( out, out_views, &decode ) )
+    {
+        return NULL;
+    }
+
+    PyObject* items = PySequence_Fast( channels, "channels must be a sequence" );
+    if ( items == NULL )
+    {
+        ReleaseOut( out_views, &decode );
+        return NULL;
+    }
+
+    Py_ssize_t count = PySequence_Fast_GET_SIZE( items );
+    std::vector< Py_buffer > views( (size_t)count );
+    Py_ssize_t held = 0;
+    RFFECaptureFile capture;
+    bool ok = true;
+
+    capture.OpenEdges( sample_rate, trigger_sample, last_sample );
+    for ( ; held < count; held++ )
+    {
+        unsigned int channel_index;
+        PyObject* edges;
+        int initial_state;
+
+        if ( !PyArg_ParseTuple( PySequence_Fast_GET_ITEM( items, held ), "IOp", &channel_index, &edges, &initial_state ) ||
+             PyObject_GetBuffer( edges, &views[held], PyBUF_C_CONTIGUOUS | PyBUF_FORMAT ) != 0 )
+        {
+            ok = false;
+            break;
+        }
+        if ( views[held].itemsize != 8 || !IsIntegerFormat( views[held].format ) )
+        {
+            PyBuffer_Release( &views[held] );
+            PyErr_SetString( PyExc_TypeError, "edges must be an array of 64 bit integers" );
+            ok = false;
+            break;
+        }
+        capture.AddEdgeChannel( channel_index, (const U64*)views[held].buf, U64( views[held].len / 8 ),
+                                initial_state ? BIT_HIGH : BIT_LOW );
+    }
+
+    if ( ok )
+    {
+        Py_BEGIN_ALLOW_THREADS
+        Decode( &capture, settings_values, &decode );
+        Py_END_ALLOW_THREADS
+    }
+    for ( Py_ssize_t i = 0; i < held; i++ )
+    {
+        PyBuffer_Release( &views[i] );
+    }
+    Py_DECREF( items );
+    ReleaseOut( out_views, &decode );
+    return ok ? MakeResult( &decode ) : NULL;
+}
+
+// decode_samples(samples, sample_rate, trigger_sample, settings, out=None)
+// samples: integer array with a word of channel bits (bit n: channel n) per sample
+static PyObject* rffe_decode_samples( PyObject*, PyObject* args )
+{
+    PyObject* samples;
+    unsigned int sample_rate;
+    unsigned long long trigger_sample;
+    PyObject* settings;
+    PyObject* out = NULL;
+    std::vector< std::pair< std::string, std::string > > settings_values;
+    RFFEPythonDecode decode;
+    Py_buffer out_views[2];
+    Py_buffer view;
+
+    if ( !PyArg_ParseTuple( args, "OIKO|O", &samples, &sample_rate, &trigger_sample, &settings, &out ) ||
+         !GetSettings( settings, &settings_values ) ||
+         !GetOut( out, out_views, &decode ) )
+    {
+        return NULL;
+    }
+    if ( PyObject_GetBuffer( samples, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT ) != 0 )
+    {
+        ReleaseOut( out_views, &decode );
+        return NULL;
+    }
+    if ( !IsIntegerFormat( view.format ) )
+    {
+        PyBuffer_Release( &view );
+        ReleaseOut( out_views, &decode );
+        PyErr_SetString( PyExc_TypeError, "samples must be an array of integers" );
+        return NULL;
+    }
+
+    RFFECaptureFile capture;
+    if ( capture.OpenMemory( view.buf, U64( view.len ), RFFECaptureFile::FormatBinaryEachSample, U32( view.itemsize ),
+                             sample_rate, trigger_sample, &decode.mError ) )
+    {
+        Py_BEGIN_ALLOW_THREADS
+        Decode( &capture, settings_values, &decode );
+        Py_END_ALLOW_THREADS
+    }
+
+    PyBuffer_Release( &view );
+    ReleaseOut( out_views, &decode );
+    return MakeResult( &decode );
+}
+
+static PyMethodDef RFFEMethods[] = {
+    { "decode_edges", rffe_decode_edges, METH_VARARGS,
+      "decode_edges(channels, sample_rate, trigger_sample, last_sample, settings, out=None) -> (packets, payload, truncated)" },
+    { "decode_samples", rffe_decode_samples, METH_VARARGS,
+      "decode_samples(samples, sample_rate, trigger_sample, settings, out=None) -> (packets, payload, truncated)" },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef RFFEModule = {
+    PyModuleDef_HEAD_INIT,
+    "_rffe",
+    "RFFE decoder over NumPy arrays, see the rffe package",
+    -1,
+    RFFEMethods,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+
+PyMODINIT_FUNC PyInit__rffe( void )
+{
+    RFFEBufferType.tp_dealloc   = (destructor)RFFEBuffer_dealloc;
+    RFFEBufferType.tp_as_buffer = &RFFEBuffer_as_buffer;
+    RFFEBufferType.tp_flags     = Py_TPFLAGS_DEFAULT;
+    RFFEBufferType.tp_doc       = "decoded records, wrapped by numpy.frombuffer";
+    if ( PyType_Ready( &RFFEBufferType ) < 0 )
+    {
+        return NULL;
+    }
+
+    PyObject* module = PyModule_Create( &RFFEModule );
+    if ( module == NULL )
+    {
+        return NULL;
+    }
+
+    PyObject* types = PyList_New( 0 );
+    for ( U32 type = 0; type < RFFE_COMMAND_TYPES; type++ )
+    {
+        PyObject* name = PyUnicode_FromString( RFFEAnalyzerResults::GetTypeString( type ) );
+        PyList_Append( types, name );
+        Py_DECREF( name );
+    }
+    PyModule_AddObject( module, "TYPE_NAMES", types );
+    PyModule_AddIntConstant( module, "PACKET_SIZE", long( sizeof( RFFEPythonPacket ) ) );
+    return module;
+}
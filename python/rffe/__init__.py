@@ -0,0 +1,138 @@
+"""RFFE decoder for NumPy arrays.
+
+Runs the decoder of the Logic analyzer plug-in over SCLK/SDATA given as edge
+arrays or as packed samples, without copying them, and returns the packets
+as a structured array plus one array with the payload bytes of all packets:
+
+    import rffe
+    d = rffe.decode_edges(sclk_edges, sdata_edges, sample_rate=100e6)
+    writes = d.packets[d.packets["type"] == rffe.TYPES.index("ExtWr")]
+    rffe.payload_of(d, 0)       # payload bytes of packet 0
+
+Settings of the analyzer are passed by their title in Logic, e.g.
+settings={"Slave Address Filter": "0x5", "Collapse Repeats?": True}.
+
+The packets are written straight into the arrays, no frames are kept. With
+out=rffe.empty(n) they go into preallocated arrays, reused from decode to
+decode; the decode raises ValueError if they fill up.
+"""
+
+import collections
+import numpy as np
+
+from . import _rffe
+
+# command type names, indexed by the "type" field
+TYPES = list(_rffe.TYPE_NAMES)
+
+# one record per packet; the payload of packet i is
+# payload[payload_offset[i]:payload_offset[i] + byte_count[i]]
+PACKET_DTYPE = np.dtype([
+    ("sample", np.uint64),              # SSC
+    ("end_sample", np.uint64),          # end of the bus park
+    ("payload_offset", np.uint64),
+    ("parity", np.uint32),              # parity bit of frame i in bit i, command frame first
+    ("parity_errors", np.uint32),       # bit i set when the parity of frame i is wrong
+    ("sclk_hz", np.uint32),             # measured SCLK, 0 unless "Measure Timing?"
+    ("count", np.uint32),               # packets of a collapsed run, 1 otherwise
+    ("address", np.uint16),
+    ("bus", np.uint8),
+    ("sa", np.uint8),
+    ("type", np.uint8),
+    ("command", np.uint8),              # lower 8 bits of the command frame
+    ("byte_count", np.uint8),
+    ("parity_count", np.uint8),
+    ("has_address", np.bool_),
+    ("decode_error", np.bool_),
+    ("timing_violations", np.uint8),
+], align=True)
+
+assert PACKET_DTYPE.itemsize == _rffe.PACKET_SIZE
+
+Decode = collections.namedtuple("Decode", ["packets", "payload", "truncated"])
+
+
+def empty(packets, payload_bytes=None):
+    """Arrays for the out argument of the decodes: room for the given number
+    of packets and payload bytes (by default 16 per packet)."""
+    if payload_bytes is None:
+        payload_bytes = 16 * packets
+    return np.empty(packets, dtype=PACKET_DTYPE), np.empty(payload_bytes, dtype=np.uint8)
+
+
+def _settings(channels, settings):
+    values = dict(channels)
+    values.update(settings or {})
+    result = []
+    for title, value in values.items():
+        if value is None:
+            value = "none"
+        elif isinstance(value, bool):
+            value = "1" if value else "0"
+        result.append((str(title), str(value)))
+    return result
+
+
+def _out(out):
+    if out is None:
+        return None
+    packets, payload = out
+    if packets.dtype != PACKET_DTYPE or payload.dtype != np.uint8:
+        raise TypeError("out must be arrays of rffe.PACKET_DTYPE and uint8, see rffe.empty")
+    return packets, payload
+
+
+def _result(out, packets, payload, truncated):
+    if out is not None:
+        return Decode(out[0][:packets], out[1][:payload], truncated)
+    return Decode(np.frombuffer(packets, dtype=PACKET_DTYPE),
+                  np.frombuffer(payload, dtype=np.uint8),
+                  truncated)
+
+
+def _edges(edges):
+    edges = np.asarray(edges)
+    if edges.dtype.kind not in "iu" or edges.dtype.itemsize != 8:
+        edges = edges.astype(np.int64)
+    return np.ascontiguousarray(edges)
+
+
+def decode_edges(sclk, sdata, sample_rate, sclk_initial=0, sdata_initial=0,
+                 end_sample=0, trigger_sample=0, buses=(), settings=None, out=None):
+    """Decodes SCLK and SDATA given as the increasing sample numbers they
+    change at, starting from their states at sample 0.
+
+    buses: more SCLK/SDATA pairs, as (sclk, sdata, sclk_initial,
+    sdata_initial) tuples, for "SCLK bus 1"/"SDATA bus 1" and so on.
+    end_sample: end of the data when it goes on past the last edge.
+    out: arrays from rffe.empty to decode into; the result holds views of
+    their first packets and payload bytes."""
+    channels = [(0, _edges(sclk), bool(sclk_initial)), (1, _edges(sdata), bool(sdata_initial))]
+    names = {"SCLK": 0, "SDATA": 1}
+    for bus, (bus_sclk, bus_sdata, bus_sclk_initial, bus_sdata_initial) in enumerate(buses, 1):
+        channels.append((2 * bus, _edges(bus_sclk), bool(bus_sclk_initial)))
+        channels.append((2 * bus + 1, _edges(bus_sdata), bool(bus_sdata_initial)))
+        names["SCLK bus %d" % bus] = 2 * bus
+        names["SDATA bus %d" % bus] = 2 * bus + 1
+    out = _out(out)
+    return _result(out, *_rffe.decode_edges(channels, int(sample_rate), int(trigger_sample),
+                                            int(end_sample), _settings(names, settings), out))
+
+
+def decode_samples(samples, sample_rate, sclk_bit=0, sdata_bit=1,
+                   trigger_sample=0, settings=None, out=None):
+    """Decodes an integer array with a word of channel bits per sample, e.g.
+    a binary export of Logic read with numpy.fromfile; SCLK and SDATA are
+    the bits sclk_bit and sdata_bit (further buses via settings, e.g.
+    {"SCLK bus 1": 4, "SDATA bus 1": 5}). out as for decode_edges."""
+    samples = np.ascontiguousarray(samples)
+    out = _out(out)
+    return _result(out, *_rffe.decode_samples(samples, int(sample_rate), int(trigger_sample),
+                                              _settings({"SCLK": sclk_bit, "SDATA": sdata_bit}, settings), out))
+
+
+def payload_of(decode, i):
+    """The payload bytes of packet i of a decode."""
+    packet = decode.packets[i]
+    start = int(packet["payload_offset"])
+    return decode.payload[start:start + int(packet["byte_count"])]
@@ -0,0 +1,25 @@
+#builds the rffe Python module (see "Python module" in README.md): pip install .
+#it is the analyzer from /source with the SDK runtime of /cli in place of libAnalyzer, so it runs without Logic
+import glob
+from setuptools import setup, Extension
+
+sources = sorted( glob.glob( "source/*.cpp" ) )
+sources += [ "cli/RFFEHost.cpp", "cli/RFFECaptureFile.cpp", "python/RFFEModule.cpp" ]
+
+setup(
+    name = "rffe",
+    version = "1.0",
+    description = "MIPI-RFFE decoder for NumPy arrays",
+    packages = [ "rffe" ],
+    package_dir = { "rffe": "python/rffe" },
+    install_requires = [ "numpy" ],
+    ext_modules = [
+        Extension(
+            "rffe._rffe",
+            sources = sources,
+            include_dirs = [ "AnalyzerSDK/include", "source", "cli" ],
+            extra_compile_args = [ "-O3", "-w", "-std=c++11", "-Dsprintf_s=snprintf" ],
+            language = "c++",
+        )
+    ],
+)
@@ -2,12 +2,28 @@
 #include "RFFEAnalyzerSettings.h"
 #include "RFFEUtil.h"
 #include <AnalyzerChannelData.h>
+#include <algorithm>
+#include <sstream>
+#include <string.h>
+
+// unwinds the extraction thread when it is stopped while waiting for data
+struct RFFEExtractionStopped
+{
+};
 
 
 RFFEAnalyzer::RFFEAnalyzer()
 :	Analyzer2(),  
 	mSettings( new RFFEAnalyzerSettings() ),
-	mSimulationInitilized( false )
+	mSimulationInitilized( false ),
+    mEventLatency( false ),
+    mLastEventMarker( 0 ),
+	mStopExtraction( false ),
+	mExtractionIdle( false ),
+    mExtractionWait( NULL ),
+    mPacketOutput( NULL ),
+    mResultsSerial( 0 ),
+    mResultsKept( false )
 {
 	SetAnalyzerSettings( mSettings.get() );
 }
@@ -15,108 +31,754 @@ RFFEAnalyzer::RFFEAnalyzer()
 RFFEAnalyzer::~RFFEAnalyzer()
 {
 	KillThread();
+	StopExtraction();
 }
 
+// Only presentation settings changed since the last finished decode: its
+// results stay, WorkerThread checks that they still fit the capture. A
+// decode into a packet output leaves no results to keep.
 void RFFEAnalyzer::SetupResults()
+{
+    mResultsKept = mResults.get() != NULL && mCheckpoints.IsFinished() &&
+                   mCheckpoints.GetResults() == mResultsSerial &&
+                   mCheckpoints.GetDecode() == mSettings->GetDecodeKey() &&
+                   mPacketOutput == NULL;
+    if ( mResultsKept )
+    {
+        SetAnalyzerResults( mResults.get() );
+        return;
+    }
+    NewResults();
+}
+
+void RFFEAnalyzer::NewResults()
 {
 	mResults.reset( new RFFEAnalyzerResults( this, mSettings.get() ) );
 	SetAnalyzerResults( mResults.get() );
-	mResults->AddChannelBubblesWillAppearOn( mSettings->mSdataChannel );
+    mResultsSerial++;
+    for ( U8 bus = 0; bus < RFFE_MAX_BUSES; bus++ )
+    {
+        if ( mSettings->IsBusUsed( bus ) )
+        {
+            mResults->AddChannelBubblesWillAppearOn( mSettings->GetSdataChannel( bus ) );
+        }
+    }
 }
 
 void RFFEAnalyzer::WorkerThread()
 {
-    S32 count;
+    U64 range_start;
+    std::ostringstream capture;
+    RFFECheckpoint resume;
+    bool resuming = false;
+
 	mSampleRateHz = GetSampleRate();
+    mSettings->GetDecodeRange( GetTriggerSample(), mSampleRateHz, &range_start, &mDecodeEnd );
+    mTimingAnalysis = mSettings->mTimingAnalysis;
+    mEventLatency = mSettings->mEventChannel != UNDEFINED_CHANNEL;
+    mPipelined = mSettings->mPipelined;
+#ifdef RFFE_INSTRUMENTATION
+    mPipelined = false;     // the phase timers follow a single thread
+#endif
+    mStreaming = mSettings->mStreaming;
+    mMaxLatency = std::chrono::milliseconds( mSettings->mMaxLatencyMs );
+    mSummaryFrames = mSettings->mSummaryFrames;
+    mCollapseRepeats = mSettings->mCollapseRepeats;
+    mRepeats.mOpen = false;
+    mPacketsSinceReport = 0;
+    mCommitFrom = range_start;
+    StopExtraction();
+
+    // randomized simulation: compare what we decode with what was generated
+    mSelfCheckActive = mSimulationInitilized && mSimulationDataGenerator.IsRecordingGroundTruth();
+    if ( mSelfCheckActive )
+    {
+        mSelfCheck.Start( &mSimulationDataGenerator,
+                          double( mSampleRateHz ) / double( GetSimulationSampleRate() ),
+                          range_start );
+    }
+
+#ifdef RFFE_INSTRUMENTATION
+    mInstrumentation.Reset();
+#endif
+
+    capture << mSampleRateHz << ' ' << GetTriggerSample();
+    mBusCount = 0;
+    for ( U8 id = 0; id < RFFE_MAX_BUSES; id++ )
+    {
+        if ( !mSettings->IsBusUsed( id ) )
+        {
+            continue;
+        }
+
+        RFFEBus& bus = mBuses[mBusCount++];
+        bus.mId           = id;
+        bus.mSclkChannel  = mSettings->GetSclkChannel( id );
+        bus.mSdataChannel = mSettings->GetSdataChannel( id );
+#ifdef RFFE_INSTRUMENTATION
+        bus.mSdataProbe.Attach( GetAnalyzerChannelData( bus.mSdataChannel ), &mInstrumentation );
+        bus.mSclkProbe.Attach( GetAnalyzerChannelData( bus.mSclkChannel ), &mInstrumentation );
+        bus.mSdata = &bus.mSdataProbe;
+        bus.mSclk  = &bus.mSclkProbe;
+#else
+        bus.mSdata = GetAnalyzerChannelData( bus.mSdataChannel );
+        bus.mSclk  = GetAnalyzerChannelData( bus.mSclkChannel );
+#endif
+
+        // the first SDATA edge tells a new capture from the last one
+        capture << ' ' << bus.mSclkChannel.mChannelIndex << ' ' << bus.mSdataChannel.mChannelIndex << ' '
+                << ( bus.mSdata->DoMoreTransitionsExistInCurrentData() ? bus.mSdata->GetSampleOfNextEdge() : 0 );
+    }
+
+    // Kept results end where the last decode stopped; it goes on from there
+    // if the range only grew at the end and the capture still holds the last
+    // SSCs of that decode. Otherwise decoding starts afresh, still at the last
+    // packet boundary before the range when one is known.
+    // NeedsRerun is false, so a rerun is Logic's call, and the SDK does not
+    // promise that Logic leaves the results of SetAnalyzerResults as they were
+    // between two runs: SetupResults only kept the object the decode ended in,
+    // and its packets and frames must still be the ones counted at the end,
+    // or the whole range is decoded again into new results.
+    bool other_data = false;
+    if ( mResultsKept )
+    {
+        bool extends = mCheckpoints.GetCapture() == capture.str() &&
+                       !mSelfCheckActive &&
+                       range_start == mCheckpoints.GetRangeStart() &&
+                       mDecodeEnd >= mCheckpoints.GetRangeEnd() &&
+                       mResults->GetNumPackets() == mCheckpoints.GetEnd().mPackets &&
+                       mResults->GetNumFrames() == mCheckpoints.GetEnd().mFrames;
+        if ( extends && IsCheckpointInData( mCheckpoints.GetEnd() ) )
+        {
+            resume   = mCheckpoints.GetEnd();
+            resuming = true;
+            mCheckpoints.Resume();
+        }
+        else
+        {
+            // the check walked the channels up to the last SSCs, they cannot
+            // go back: another capture is decoded from there in this run
+            // and from the start in the next one
+            other_data   = extends;
+            mResultsKept = false;
+            NewResults();
+        }
+    }
+    if ( !mResultsKept )
+    {
+        const RFFECheckpoint* checkpoint = NULL;
+        if ( mCheckpoints.GetCapture() == capture.str() && !other_data )
+        {
+            checkpoint = mCheckpoints.FindBefore( range_start, mBusCount );
+        }
+        if ( checkpoint != NULL && IsCheckpointInData( *checkpoint ) )
+        {
+            resume   = *checkpoint;
+            resuming = true;
+        }
+        mCheckpoints.Start( capture.str(), mSettings->GetDecodeKey(), range_start, mDecodeEnd );
+        if ( mTimingAnalysis )
+        {
+            mTiming.Start( mSettings.get(), mSampleRateHz );
+        }
+        if ( mEventLatency )
+        {
+            mLatency.Start( mSettings.get(), mSampleRateHz );
+            mLastEventMarker = 0;
+        }
+    }
+    // the rate of these channels is kept with the settings; a resumed
+    // decode has it from the run before
+    mSclkDetector.Reset();
+    if ( resuming && mSettings->mDetectedSclkHz.load( std::memory_order_relaxed ) != 0 )
+    {
+        mSclkDetector.Skip();
+    }
+    mPacketsHandedOn = mResultsKept ? resume.mPackets : 0;
+    mFramesHandedOn  = mResultsKept ? resume.mFrames : 0;
+    mNextCheckpoint  = mPacketsHandedOn + RFFE_CHECKPOINT_INTERVAL;
+
+    U64 first_position = U64( -1 );
+    for ( U32 i = 0; i < mBusCount; i++ )
+    {
+        RFFEBus& bus = mBuses[i];
+        U64 position = resuming ? resume.mSample[i] : range_start;
 
-	mSdata = GetAnalyzerChannelData( mSettings->mSdataChannel );
-	mSclk  = GetAnalyzerChannelData( mSettings->mSclkChannel );
+        first_position = std::min( first_position, position );
+        bus.mSsc      = resuming ? resume.mSsc[i] : RFFE_NO_SSC;
+        bus.mSscFall  = resuming ? resume.mSscFall[i] : RFFE_NO_SSC;
+        bus.mSscClock = resuming ? resume.mSscClock[i] : RFFE_NO_SSC;
 
+        if ( position > bus.mSdata->GetSampleNumber() )
+        {
+            // seek straight into the window, decoding starts at its first SSC
+            bus.mSdata->AdvanceToAbsPosition( position );
+            bus.mSclk->AdvanceToAbsPosition( position );
+            if ( !resuming && bus.mSdata->GetBitState() == BIT_HIGH )
+            {
+                bus.mSdata->AdvanceToNextEdge();
+            }
+        }
+    }
+
+    if ( mEventLatency )
+    {
+        mLatency.Attach( GetAnalyzerChannelData( mSettings->mEventChannel ), first_position );
+    }
+
+    mResults->CancelPacketAndStartNewPacket();
+
+    if ( mPipelined )
+    {
+        RunPipelined();
+    }
+    else
+    {
+        DecodeBuses();
+    }
+
+    EndRepeatRun();
     mResults->CancelPacketAndStartNewPacket();
+    GetCheckpoint( &resume );
+    resume.mPackets = mResults->GetNumPackets();
+    resume.mFrames  = mResults->GetNumFrames();
+    if ( other_data )
+    {
+        mCheckpoints.Invalidate();
+    }
+    else
+    {
+        mCheckpoints.Finish( resume, mDecodeEnd, mResultsSerial );
+    }
+    WriteReports();
+#ifdef RFFE_INSTRUMENTATION
+    mInstrumentation.Dump( RFFE_INSTRUMENTATION_LOG );
+#endif
+}
+
+// Decodes all buses and hands their packets on in the order of their SSC:
+// straight to the results, or to the ring in pipelined mode. In streaming
+// mode a bus without a packet is only out of data for now; the loop waits
+// for the capture to grow instead of returning.
+void RFFEAnalyzer::DecodeBuses()
+{
+    for ( U32 i = 0; i < mBusCount; i++ )
+    {
+        SelectBus( &mBuses[i] );
+        mBus->mPending = DecodePacket();
+    }
+
+    // commit the earliest decoded packet, then decode the next one of its bus
+	for( ; ; )
+	{
+        if ( mPipelined && mStopExtraction.load( std::memory_order_relaxed ) )
+        {
+            return;
+        }
+
+        RFFEBus* bus = HandOnNextPacket();
+        if ( bus != NULL )
+        {
+            // between two packets of every bus
+            if ( mPacketsHandedOn >= mNextCheckpoint )
+            {
+                RFFECheckpoint checkpoint;
+                GetCheckpoint( &checkpoint );
+                mCheckpoints.Add( checkpoint );
+                mNextCheckpoint = mPacketsHandedOn + RFFE_CHECKPOINT_INTERVAL;
+            }
+            SelectBus( bus );
+            mBus->mPending = DecodePacket();
+            continue;
+        }
+        if ( !mStreaming )
+        {
+            break;
+        }
+
+        // see whether the buses without a packet got one in the meantime
+        bool decoded = false;
+        for ( U32 i = 0; i < mBusCount; i++ )
+        {
+            if ( !mBuses[i].mPending )
+            {
+                SelectBus( &mBuses[i] );
+                mBus->mPending = DecodePacket();
+                decoded |= mBus->mPending;
+            }
+        }
+        if ( !decoded )
+        {
+            Idle();
+        }
+	}
+}
+
+// Commits the earliest pending packet (pushes it to the ring in pipelined
+// mode) and returns its bus, or NULL when no packet is due yet.
+RFFEBus* RFFEAnalyzer::HandOnNextPacket()
+{
+    RFFEBus* next = NULL;
+
+    for ( U32 i = 0; i < mBusCount; i++ )
+    {
+        if ( mBuses[i].mPending &&
+             ( next == NULL || mBuses[i].mPacket.mStartingSample < next->mPacket.mStartingSample ) )
+        {
+            next = &mBuses[i];
+        }
+    }
+    if ( next == NULL || !IsCommitDue( next ) )
+    {
+        return NULL;
+    }
+
+    if ( mPipelined )
+    {
+        while ( !mRing.TryPush( next->mPacket, next->mTrace ) )
+        {
+            if ( mStopExtraction.load( std::memory_order_relaxed ) )
+            {
+                throw RFFEExtractionStopped();
+            }
+            std::this_thread::yield();
+        }
+    }
+    else
+    {
+        CommitPacket( next->mPacket, next->mTrace );
+        CheckIfThreadShouldExit();
+    }
+    next->mPending = false;
+    mPacketsHandedOn++;
+    mFramesHandedOn += next->mTrace.mFrameCount;
+    return next;
+}
+
+// The extraction thread decodes into the ring while this thread turns its
+// packets into frames and markers. Errors of the extraction thread (e.g.
+// running out of data) are raised here once the ring is drained.
+void RFFEAnalyzer::RunPipelined()
+{
+    mRing.Reset();
+    mStopExtraction = false;
+    mExtractionWait = NULL;
+    mExtractionError = std::exception_ptr();
+    mExtractionThread = std::thread( &RFFEAnalyzer::ExtractionThread, this );
+
+    try
+    {
+        for ( ; ; )
+        {
+            const RFFEPacketRing::Entry* entry = mRing.Front();
+            if ( entry != NULL )
+            {
+                CommitPacket( entry->mPacket, entry->mTrace );
+                mRing.Pop();
+                CheckIfThreadShouldExit();
+                continue;
+            }
+
+            // the extraction thread ran out of data inside a packet: wait
+            // for its next SCLK edge here, where Logic can stop the decode
+            RFFEChannel* sclk = mExtractionWait.load( std::memory_order_acquire );
+            if ( sclk != NULL )
+            {
+                sclk->AdvanceToNextEdge();
+                mExtractionWait.store( NULL, std::memory_order_release );
+                continue;
+            }
+
+            // closed before the last look at the ring: nothing more to come
+            if ( mRing.IsClosed() && mRing.Front() == NULL )
+            {
+                break;
+            }
+            // an idle extraction thread sleeps as well, nothing comes before it wakes
+            if ( mStreaming && mExtractionIdle.load( std::memory_order_relaxed ) )
+            {
+                EndRepeatRun();
+                CheckIfThreadShouldExit();
+                std::this_thread::sleep_for( mMaxLatency / 4 );
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+    catch ( ... )
+    {
+        StopExtraction();
+        throw;
+    }
+
+    StopExtraction();
+    if ( mExtractionError )
+    {
+        std::rethrow_exception( mExtractionError );
+    }
+}
+
+void RFFEAnalyzer::ExtractionThread()
+{
+    try
+    {
+        DecodeBuses();
+    }
+    catch ( ... )
+    {
+        mExtractionError = std::current_exception();
+    }
+    mRing.Close();
+}
+
+// the extraction thread stops at its next packet boundary, or where it
+// waits for data: it never blocks in the SDK, so the join cannot hang
+void RFFEAnalyzer::StopExtraction()
+{
+    if ( mExtractionThread.joinable() )
+    {
+        mStopExtraction = true;
+        mExtractionThread.join();
+    }
+}
+
+// In streaming mode a packet of one bus is held back until no other bus can
+// still come up with an earlier one, but not longer than the latency bound.
+// The capture already holds this packet, so a bus whose SDATA has no edge
+// left in the current data cannot start an earlier packet any more.
+bool RFFEAnalyzer::IsCommitDue( const RFFEBus* bus )
+{
+    if ( !mStreaming ||
+         std::chrono::steady_clock::now() - bus->mDecodedAt >= mMaxLatency )
+    {
+        return true;
+    }
+
+    for ( U32 i = 0; i < mBusCount; i++ )
+    {
+        if ( !mBuses[i].mPending &&
+             mBuses[i].mSdata->GetSampleNumber() < bus->mPacket.mStartingSample &&
+             mBuses[i].mSdata->DoMoreTransitionsExistInCurrentData() )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Streaming decode: the packet being decoded is still arriving. Rather than
+// blocking in the SDK until the capture holds its next SCLK edge, wait here,
+// where the thread can still be stopped.
+void RFFEAnalyzer::AdvanceSclkToNextEdge()
+{
+    while ( mStreaming && !mSclk->DoMoreTransitionsExistInCurrentData() )
+    {
+        Idle();
+    }
+    if ( mPipelined && !mSclk->DoMoreTransitionsExistInCurrentData() )
+    {
+        WaitForSclkEdge();
+        return;
+    }
+    mSclk->AdvanceToNextEdge();
+}
+
+// Pipelined decode past the data captured so far: the worker thread makes
+// the blocking SDK call for the extraction thread, which meanwhile only
+// polls, so StopExtraction gets through. Errors of the call (the end of a
+// capture file) are raised in the worker.
+void RFFEAnalyzer::WaitForSclkEdge()
+{
+    mExtractionWait.store( mSclk, std::memory_order_release );
+    while ( mExtractionWait.load( std::memory_order_acquire ) != NULL )
+    {
+        if ( mStopExtraction.load( std::memory_order_relaxed ) )
+        {
+            throw RFFEExtractionStopped();
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+}
+
+// Streaming decode caught up with the capture: hand on what other buses
+// decoded meanwhile, bring the reports and the progress up to date, then
+// sleep a fraction of the latency bound.
+void RFFEAnalyzer::Idle()
+{
+    while ( HandOnNextPacket() != NULL )
+    {
+    }
+
+    if ( mPacketsSinceReport != 0 )
+    {
+        WriteReports();
+    }
+
+    if ( mPipelined )
+    {
+        if ( mStopExtraction.load( std::memory_order_relaxed ) )
+        {
+            throw RFFEExtractionStopped();
+        }
+        mExtractionIdle = true;
+        std::this_thread::sleep_for( mMaxLatency / 4 );
+        mExtractionIdle = false;
+    }
+    else
+    {
+        U64 sample = 0;
+        for ( U32 i = 0; i < mBusCount; i++ )
+        {
+            sample = std::max( sample, mBuses[i].mSdata->GetSampleNumber() );
+        }
+        // a run still growing shows up now rather than when it ends
+        EndRepeatRun();
+        ReportProgress( sample );
+        CheckIfThreadShouldExit();
+        std::this_thread::sleep_for( mMaxLatency / 4 );
+    }
+}
+
+void RFFEAnalyzer::WriteReports()
+{
+    if ( mSelfCheckActive )
+    {
+        mSelfCheck.Finish( mSettings->mSelfCheckReportFile.c_str() );
+    }
+    if ( mTimingAnalysis )
+    {
+        mTiming.Finish( mSettings->mTimingReportFile.c_str(), mSettings->mDetectedSclkHz.load( std::memory_order_relaxed ) );
+    }
+    if ( mEventLatency )
+    {
+        mLatency.Finish( mSettings->mLatencyReportFile.c_str() );
+    }
+    mPacketsSinceReport = 0;
+}
+
+// A bus with a decoded packet goes on at its SSC, any other one where its
+// SSC search stands.
+void RFFEAnalyzer::GetCheckpoint( RFFECheckpoint* checkpoint )
+{
+    for ( U32 i = 0; i < mBusCount; i++ )
+    {
+        checkpoint->mSample[i] = mBuses[i].mPending ? mBuses[i].mPacket.mStartingSample :
+                                                      mBuses[i].mSdata->GetSampleNumber();
+        checkpoint->mSsc[i]      = mBuses[i].mSsc;
+        checkpoint->mSscFall[i]  = mBuses[i].mSscFall;
+        checkpoint->mSscClock[i] = mBuses[i].mSscClock;
+    }
+    checkpoint->mPackets = mPacketsHandedOn;
+    checkpoint->mFrames  = mFramesHandedOn;
+}
+
+// The capture has the SSC edges of the checkpoint: SDATA high and SCLK low
+// at mSsc, their next edges at mSscFall and mSscClock. Walks the channels of
+// every bus up to its SSC, never past the checkpoint.
+bool RFFEAnalyzer::IsCheckpointInData( const RFFECheckpoint& checkpoint )
+{
+    for ( U32 i = 0; i < mBusCount; i++ )
+    {
+        RFFEBus& bus = mBuses[i];
+        U64 ssc = checkpoint.mSsc[i];
+
+        if ( ssc == RFFE_NO_SSC )
+        {
+            continue;
+        }
+        if ( ssc < bus.mSdata->GetSampleNumber() || ssc < bus.mSclk->GetSampleNumber() )
+        {
+            return false;
+        }
+        bus.mSdata->AdvanceToAbsPosition( ssc );
+        bus.mSclk->AdvanceToAbsPosition( ssc );
+        if ( bus.mSdata->GetBitState() != BIT_HIGH || bus.mSclk->GetBitState() != BIT_LOW ||
+             !bus.mSdata->DoMoreTransitionsExistInCurrentData() ||
+             bus.mSdata->GetSampleOfNextEdge() != checkpoint.mSscFall[i] ||
+             !bus.mSclk->DoMoreTransitionsExistInCurrentData() ||
+             bus.mSclk->GetSampleOfNextEdge() != checkpoint.mSscClock[i] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RFFEAnalyzer::SelectBus( RFFEBus* bus )
+{
+    mBus   = bus;
+    mSclk  = bus->mSclk;
+    mSdata = bus->mSdata;
+}
+
+// Decodes the next packet of the selected bus into its trace. Returns false
+// once the bus has no more packets in the capture or the decode range.
+bool RFFEAnalyzer::DecodePacket()
+{
+    S32 count;
+
+    mBus->mPending = false;
 
 	for( ; ; )
 	{
         count = FindStartSeqCondition();
         if ( count == -1 )
         {
-            mResults->CancelPacketAndStartNewPacket();
-            break;
+            return false;
         }
         //continue; // for debugging only
 
         count = FindSlaveAddrAndCommand();
         if ( count == -1 )
         {
-            mResults->CancelPacketAndStartNewPacket();
+            // filtered out, nothing of it went to the results
+            if ( mSelfCheckActive && mBus->mPacket.mStartingSample >= mCommitFrom )
+            {
+                mSelfCheck.Skip( mBus->mPacket );
+            }
             continue;
         }
-        FindParity(true);
+        FindParity< true >( ( U64( mBus->mPacket.mSlaveAddress ) << 8 ) | mBus->mPacket.mCommand );
         //continue; // for debugging only
 
-        switch ( mRffeType )
+        // one routine per command type, with the field layout fixed at
+        // compile time
+        switch ( mBus->mRffeType )
         {
         case RFFEAnalyzerResults::RffeTypeExtWrite:
-            FindAddressFrame( RFFEAnalyzerResults::RffeAddressNormalField );
-            for( U32 i = count ; i != 0; i-- )
-            {
-                FindDataFrame();
-            }
-            FindBusParkLastSimbol();
+            DecodeFields< RFFEAnalyzerResults::RffeTypeExtWrite >( count );
             break;
-
         case RFFEAnalyzerResults::RffeTypeReserved:
+            DecodeFields< RFFEAnalyzerResults::RffeTypeReserved >( count );
             break;
-
         case RFFEAnalyzerResults::RffeTypeExtRead:
-            FindAddressFrame( RFFEAnalyzerResults::RffeAddressNormalField );
-            FindBusParkAdditionalSimbols();
-            for( U32 i = count ; i != 0; i-- )
-            {
-                FindDataFrame();
-            }
-            FindBusParkLastSimbol();
+            DecodeFields< RFFEAnalyzerResults::RffeTypeExtRead >( count );
             break;
-
         case RFFEAnalyzerResults::RffeTypeExtLongWrite:
-            FindAddressFrame( RFFEAnalyzerResults::RffeAddressHiField );
-            FindAddressFrame( RFFEAnalyzerResults::RffeAddressLoField );
-            for( U32 i = count ; i != 0; i-- )
-            {
-                FindDataFrame();
-            }
-            FindBusParkLastSimbol();
+            DecodeFields< RFFEAnalyzerResults::RffeTypeExtLongWrite >( count );
             break;
-
         case RFFEAnalyzerResults::RffeTypeExtLongRead:
-            FindAddressFrame( RFFEAnalyzerResults::RffeAddressHiField );
-            FindAddressFrame( RFFEAnalyzerResults::RffeAddressLoField );
-            FindBusParkAdditionalSimbols();
-            for( U32 i = count ; i != 0; i-- )
-            {
-                FindDataFrame();
-            }
-            FindBusParkLastSimbol();
+            DecodeFields< RFFEAnalyzerResults::RffeTypeExtLongRead >( count );
             break;
-
         case RFFEAnalyzerResults::RffeTypeNormalWrite:
+            DecodeFields< RFFEAnalyzerResults::RffeTypeNormalWrite >( count );
+            break;
+        case RFFEAnalyzerResults::RffeTypeNormalRead:
+            DecodeFields< RFFEAnalyzerResults::RffeTypeNormalRead >( count );
+            break;
+        case RFFEAnalyzerResults::RffeTypeShortWrite:
+            DecodeFields< RFFEAnalyzerResults::RffeTypeShortWrite >( count );
+            break;
+        case RFFEAnalyzerResults::RffeTypeMaskedWrite:
+            DecodeFields< RFFEAnalyzerResults::RffeTypeMaskedWrite >( count );
+            break;
+        }
+        FinishPacket();
+        return true;
+	}
+}
+
+// Frames after the command parity: address frames, the mask of a masked
+// write, the bus park before the data of a read, data frames and the
+// closing bus park. Type is a
+// template argument so every branch on it folds away and the 8 bit frame
+// reads unroll; count is the number of data frames of an extended access.
+template< U32 Type >
+void RFFEAnalyzer::DecodeFields( U32 count )
+{
+    const bool extended = Type == RFFEAnalyzerResults::RffeTypeExtWrite ||
+                          Type == RFFEAnalyzerResults::RffeTypeExtRead;
+    const bool extended_long = Type == RFFEAnalyzerResults::RffeTypeExtLongWrite ||
+                               Type == RFFEAnalyzerResults::RffeTypeExtLongRead;
+    const bool read = Type == RFFEAnalyzerResults::RffeTypeExtRead ||
+                      Type == RFFEAnalyzerResults::RffeTypeExtLongRead ||
+                      Type == RFFEAnalyzerResults::RffeTypeNormalRead;
+    const bool normal = Type == RFFEAnalyzerResults::RffeTypeNormalWrite ||
+                        Type == RFFEAnalyzerResults::RffeTypeNormalRead;
+    const bool masked = Type == RFFEAnalyzerResults::RffeTypeMaskedWrite;
+
+    if ( Type == RFFEAnalyzerResults::RffeTypeReserved )
+    {
+        if ( IsProtocolV2() )
+        {
+            FindEndOfUnknownCommand();
+        }
+        return;
+    }
+    if ( extended || masked )
+    {
+        FindAddressFrame( RFFEAnalyzerResults::RffeAddressNormalField );
+    }
+    if ( masked )
+    {
+        FindMaskFrame();
+    }
+    if ( extended_long )
+    {
+        FindAddressFrame( RFFEAnalyzerResults::RffeAddressHiField );
+        FindAddressFrame( RFFEAnalyzerResults::RffeAddressLoField );
+    }
+    if ( read )
+    {
+        FindBusParkAdditionalSimbols();
+    }
+    if ( normal || masked )
+    {
+        FindDataFrame();
+    }
+    if ( extended || extended_long )
+    {
+        for( U32 i = count ; i != 0; i-- )
+        {
             FindDataFrame();
-            FindBusParkLastSimbol();
-            break;
+        }
+    }
+    FindBusParkLastSimbol();
+}
 
-        case RFFEAnalyzerResults::RffeTypeNormalRead:
-            FindBusParkAdditionalSimbols();
-            FindDataFrame();
-            FindBusParkLastSimbol();
-            break;
+// Everything about a decoded packet that does not depend on when it is
+// committed: its timing, the event latency, the SCLK estimate and the
+// self-check.
+void RFFEAnalyzer::FinishPacket()
+{
+    RFFEPacketTrace& trace = mBus->mTrace;
 
-        case RFFEAnalyzerResults::RffeTypeShortWrite:
-            FindBusParkLastSimbol();
-            break;
+    mBus->mPacket.mEventDelay = mEventLatency ? mLatency.Measure( mBus->mPacket ) : RFFE_NO_EVENT_DELAY;
 
+    // the SSC frame carries the timing of the whole packet
+    if ( mTimingAnalysis )
+    {
+        mTiming.EndPacket( mBus->mPacket );
+        trace.mFrames[0].mData1 = mBus->mPacket.mSclkFrequency;
+        trace.mFrames[0].mData2 = mBus->mPacket.mTimingViolations;
+        if ( mBus->mPacket.mTimingViolations != 0 )
+        {
+            trace.mFrames[0].mFlags |= DISPLAY_AS_WARNING_FLAG;
         }
-        mResults->CommitPacketAndStartNewPacket();
-        CheckIfThreadShouldExit();
-	}
+    }
+    else
+    {
+        mBus->mPacket.mSclkFrequency    = 0;
+        mBus->mPacket.mTimingViolations = 0;
+    }
+
+    if ( !mSclkDetector.IsDone() && mSclkDetector.EndPacket( mSampleRateHz ) )
+    {
+        mSettings->mDetectedSclkHz.store( mSclkDetector.GetSclkHz(), std::memory_order_relaxed );
+        if ( mTimingAnalysis )
+        {
+            mTiming.SetBusSclkHz( mSettings->GetBusSclkHz() );
+        }
+    }
+    RFFE_COUNT( mPackets[mBus->mRffeType] );
+    if ( mSelfCheckActive )
+    {
+        mSelfCheck.Check( mBus->mPacket );
+    }
+    mBus->mDecodedAt = std::chrono::steady_clock::now();
+    mPacketsSinceReport++;
 }
 
 bool RFFEAnalyzer::FindStartSeqCondition_MoreTransitions()
@@ -152,9 +814,12 @@ S32 RFFEAnalyzer::FindStartSeqCondition()
     U64 sampleAtRisingEdgeOfStartBit;
     U64 sampleAtFallingEdgeOfStartBit;
  
+    RFFE_PHASE( PhaseStartSearch );
+
     for ( ; ; )
     {
-        if ( ! FindStartSeqCondition_MoreTransitions() )
+        if ( ! FindStartSeqCondition_MoreTransitions() ||
+             mSdata->GetSampleNumber() > mDecodeEnd )
         {
             return -1;
         }
@@ -173,6 +838,7 @@ S32 RFFEAnalyzer::FindStartSeqCondition()
 
         if( mSclk->WouldAdvancingToAbsPositionCauseTransition(sampleAtFallingEdgeOfStartBit) )
         {
+            RFFE_COUNT( mResyncs );
             continue; // Keep searching: found clk toggling
         }
         else
@@ -181,26 +847,40 @@ S32 RFFEAnalyzer::FindStartSeqCondition()
         }
 
         // move data to the rising-edge of clk
-        mSclk->AdvanceToNextEdge();
+        AdvanceSclkToNextEdge();
         sample = mSclk->GetSampleNumber();
         mSdata->AdvanceToAbsPosition( sample );
 
-		Frame frame;
-        frame.mType                    = RFFEAnalyzerResults::RffeSSCField;
-		frame.mStartingSampleInclusive = sampleAtRisingEdgeOfStartBit;
-		frame.mEndingSampleInclusive   = sample;
-
-        mResults->AddMarker( sampleAtRisingEdgeOfStartBit,
-                             AnalyzerResults::Start,
-                             mSettings->mSdataChannel );
-		mResults->AddFrame( frame );
-		mResults->CommitResults();
+        mBus->mSsc      = sampleAtRisingEdgeOfStartBit;
+        mBus->mSscFall  = sampleAtFallingEdgeOfStartBit;
+        mBus->mSscClock = sample;
+        mBus->mPacket.mBus            = mBus->mId;
+        mBus->mPacket.mStartingSample = sampleAtRisingEdgeOfStartBit;
+        mBus->mPacket.mEndingSample   = sample;
+        mBus->mPacket.mAddress        = 0;
+        mBus->mPacket.mByteCount      = 0;
+        mBus->mPacket.mParityCount    = 0;
+        mBus->mPacket.mParity         = 0;
+        mBus->mPacket.mParityErrors   = 0;
+
+        mBus->mTrace.mBitCount   = 0;
+        mBus->mTrace.mFrameCount = 0;
+        mBus->mClockLowSum       = 0;
+        mBus->mClockLowCount     = 0;
+        mBus->mMeasureTiming     = mTimingAnalysis && sampleAtRisingEdgeOfStartBit >= mCommitFrom;
+        if ( mTimingAnalysis )
+        {
+            mTiming.StartPacket();
+        }
 
-		ReportProgress( frame.mEndingSampleInclusive );
+        FillInFrame( RFFEAnalyzerResults::RffeSSCField,
+                     0,
+                     0,
+                     sampleAtRisingEdgeOfStartBit, sample,
+                     0, 0 );
         break;
     }
 
-    gSampleCount = 0;
     return 1;
 }
 
@@ -209,294 +889,436 @@ S32 RFFEAnalyzer::FindSlaveAddrAndCommand()
     S32 count = 0;
     U64 SAdr;
     U64 cmd;
-    AnalyzerResults::MarkerType sampleDataState[16];
-
-    // normalize samples for debugging
-    gSampleNormalized = mSclk->GetSampleNumber();
+    U32 b = mBus->mTrace.mBitCount;
+    U64 *clk = &mBus->mTrace.mBitClk[b];
 
     // starting at rising edge of clk
-    cmd = GetBitStream( 12, sampleDataState);
+    cmd = GetBits< 12 >();
 
     SAdr = ( cmd & 0xF00 ) >> 8;
+
+	// decode type
+    mBus->mRffeType = RFFEUtil::decodeRFFECmdFrame( (U8)(cmd & 0xFF), IsProtocolV2() );
+    mBus->mPacket.mSlaveAddress = (U8)SAdr;
+    mBus->mPacket.mCommand      = (U8)(cmd & 0xFF);
+    mBus->mPacket.mType         = (U8)mBus->mRffeType;
+
+    // a decode resumed at a checkpoint steps up to the range like a filter
+    if ( mBus->mPacket.mStartingSample < mCommitFrom ||
+         !mSettings->IsPacketSelected( mBus->mPacket.mSlaveAddress, mBus->mPacket.mType ) )
+    {
+        SkipPacket();
+        return -1;
+    }
+
     FillInFrame( RFFEAnalyzerResults::RffeSAField,
                  SAdr,
                  0,
-                 sampleClkOffsets[0], sampleClkOffsets[4],
-                 0, 4,
-                 sampleDataState );
+                 clk[0], clk[4],
+                 b + 0, 4 );
 
-	// decode type
-    mRffeType = RFFEUtil::decodeRFFECmdFrame( (U8)(cmd & 0xFF) );
-    switch ( mRffeType )
+    switch ( mBus->mRffeType )
     {
     case RFFEAnalyzerResults::RffeTypeExtWrite:
         FillInFrame( RFFEAnalyzerResults::RffeTypeField,
-                     mRffeType,
-                     0,
-                     sampleClkOffsets[4], sampleClkOffsets[8],
-                     4, 4,
-                     sampleDataState );
+                     mBus->mRffeType,
+                     cmd & 0xFF,
+                     clk[4], clk[8],
+                     b + 4, 4 );
         FillInFrame( RFFEAnalyzerResults::RffeExByteCountField,
                      ( cmd & 0x0F ),
                      0,
-                     sampleClkOffsets[8], sampleClkOffsets[12],
-                     8, 4,
-                     sampleDataState );
+                     clk[8], clk[12],
+                     b + 8, 4 );
         count = RFFEUtil::byteCount( (U8)cmd );
         break;
     case RFFEAnalyzerResults::RffeTypeReserved: 
+    case RFFEAnalyzerResults::RffeTypeMaskedWrite:
         FillInFrame( RFFEAnalyzerResults::RffeTypeField,
-                     mRffeType,
-                     0,
-                     sampleClkOffsets[4], sampleClkOffsets[12],
-                     4, 8,
-                     sampleDataState );
+                     mBus->mRffeType,
+                     cmd & 0xFF,
+                     clk[4], clk[12],
+                     b + 4, 8 );
         break;
     case RFFEAnalyzerResults::RffeTypeExtRead:
         FillInFrame( RFFEAnalyzerResults::RffeTypeField,
-                     mRffeType,
-                     0,
-                     sampleClkOffsets[4], sampleClkOffsets[8],
-                     4, 4,
-                     sampleDataState );
+                     mBus->mRffeType,
+                     cmd & 0xFF,
+                     clk[4], clk[8],
+                     b + 4, 4 );
         FillInFrame( RFFEAnalyzerResults::RffeExByteCountField,
                      ( cmd & 0x0F ),
                      0,
-                     sampleClkOffsets[8], sampleClkOffsets[12],
-                     8, 4,
-                     sampleDataState );
+                     clk[8], clk[12],
+                     b + 8, 4 );
         count = RFFEUtil::byteCount( (U8)cmd );
         break;
     case RFFEAnalyzerResults::RffeTypeExtLongWrite:
         FillInFrame( RFFEAnalyzerResults::RffeTypeField,
-                     mRffeType,
-                     0,
-                     sampleClkOffsets[4], sampleClkOffsets[9],
-                     4, 5,
-                     sampleDataState );
+                     mBus->mRffeType,
+                     cmd & 0xFF,
+                     clk[4], clk[9],
+                     b + 4, 5 );
         FillInFrame( RFFEAnalyzerResults::RffeExLongByteCountField,
                      ( cmd & 0x07 ),
                      0,
-                     sampleClkOffsets[9], sampleClkOffsets[12],
-                     9, 3,
-                     sampleDataState );
+                     clk[9], clk[12],
+                     b + 9, 3 );
         count = RFFEUtil::byteCount( (U8)cmd );
         break;
     case RFFEAnalyzerResults::RffeTypeExtLongRead:
         FillInFrame( RFFEAnalyzerResults::RffeTypeField,
-                     mRffeType,
-                     0,
-                     sampleClkOffsets[4], sampleClkOffsets[9],
-                     4, 5,
-                     sampleDataState );
+                     mBus->mRffeType,
+                     cmd & 0xFF,
+                     clk[4], clk[9],
+                     b + 4, 5 );
         FillInFrame( RFFEAnalyzerResults::RffeExLongByteCountField,
                      ( cmd & 0x07 ),
                      0,
-                     sampleClkOffsets[9], sampleClkOffsets[12],
-                     9, 3,
-                     sampleDataState );
+                     clk[9], clk[12],
+                     b + 9, 3 );
         count = RFFEUtil::byteCount( (U8)cmd );
         break;
     case RFFEAnalyzerResults::RffeTypeNormalWrite:
         FillInFrame( RFFEAnalyzerResults::RffeTypeField,
-                     mRffeType,
-                     0,
-                     sampleClkOffsets[4], sampleClkOffsets[7],
-                     4, 3,
-                     sampleDataState );
+                     mBus->mRffeType,
+                     cmd & 0xFF,
+                     clk[4], clk[7],
+                     b + 4, 3 );
         FillInFrame( RFFEAnalyzerResults::RffeShortAddressField,
                      ( cmd & 0x1F ),
                      0,
-                     sampleClkOffsets[7], sampleClkOffsets[12],
-                     7, 5,
-                     sampleDataState );
+                     clk[7], clk[12],
+                     b + 7, 5 );
+        mBus->mPacket.mAddress = (U16)( cmd & 0x1F );
         break;
     case RFFEAnalyzerResults::RffeTypeNormalRead:
         FillInFrame( RFFEAnalyzerResults::RffeTypeField,
-                     mRffeType,
-                     0,
-                     sampleClkOffsets[4], sampleClkOffsets[7],
-                     4, 3,
-                     sampleDataState );
+                     mBus->mRffeType,
+                     cmd & 0xFF,
+                     clk[4], clk[7],
+                     b + 4, 3 );
         FillInFrame( RFFEAnalyzerResults::RffeShortAddressField,
                      ( cmd & 0x1F ),
                      0,
-                     sampleClkOffsets[7], sampleClkOffsets[12],
-                     7, 5,
-                     sampleDataState );
+                     clk[7], clk[12],
+                     b + 7, 5 );
+        mBus->mPacket.mAddress = (U16)( cmd & 0x1F );
         break;
     case RFFEAnalyzerResults::RffeTypeShortWrite:
         FillInFrame( RFFEAnalyzerResults::RffeTypeField,
-                     mRffeType,
-                     0,
-                     sampleClkOffsets[4], sampleClkOffsets[5],
-                     4, 1,
-                     sampleDataState );
+                     mBus->mRffeType,
+                     cmd & 0xFF,
+                     clk[4], clk[5],
+                     b + 4, 1 );
         FillInFrame( RFFEAnalyzerResults::RffeShortDataField,
                      (cmd & 0x7F),
                      0,
-                     sampleClkOffsets[5], sampleClkOffsets[12],
-                     5, 7,
-                     sampleDataState );
+                     clk[5], clk[12],
+                     b + 5, 7 );
+        mBus->mPacket.mData[mBus->mPacket.mByteCount++] = (U8)( cmd & 0x7F );
         break;
     }
 
     return count+1;
 }
 
-void RFFEAnalyzer::FindParity(bool fromCommandFrame)
+void RFFEAnalyzer::SkipPacket()
+{
+    // starting at rising edge of the command parity bit, step over the
+    // remaining SCLK cycles without sampling SDATA
+    U32 edges = 2 * RFFEUtil::bitCount( mBus->mPacket.mCommand, IsProtocolV2() );
+
+    RFFE_PHASE( PhaseBitExtraction );
+
+    // and over the falling edge of the closing bus park
+    if ( mBus->mRffeType != RFFEAnalyzerResults::RffeTypeReserved )
+    {
+        edges++;
+    }
+
+    for ( ; edges != 0; edges-- )
+    {
+        AdvanceSclkToNextEdge();
+    }
+
+    if ( mBus->mRffeType == RFFEAnalyzerResults::RffeTypeReserved && IsProtocolV2() )
+    {
+        FindEndOfUnknownCommand();
+        return;
+    }
+    mBus->mPacket.mEndingSample = mSclk->GetSampleNumber();
+    mSdata->AdvanceToAbsPosition( mBus->mPacket.mEndingSample );
+}
+
+bool RFFEAnalyzer::IsProtocolV2() const
+{
+    return mSettings->mProtocolVersion == RFFEAnalyzerSettings::ProtocolV2;
+}
+
+// The v2.x commands besides masked write carry frames whose number this
+// decoder does not know. Rather than taking them for the next SSC, step over
+// their SCLK cycles up to the bus park: the last cycle before SCLK stays low
+// for an SSC (SDATA pulsing high while SCLK is low), or before the capture
+// has no further SCLK edges. Starts at a rising edge of SCLK; SDATA is left
+// at the SSC for the search to find it.
+void RFFEAnalyzer::FindEndOfUnknownCommand()
+{
+    U64 low = mBus->mClockLowCount != 0 ? mBus->mClockLowSum / mBus->mClockLowCount : 1;
+    U64 falling;
+    U64 end;
+
+    RFFE_PHASE( PhaseBitExtraction );
+
+    for ( ; ; )
+    {
+        AdvanceSclkToNextEdge();
+        falling = mSclk->GetSampleNumber();
+        mSdata->AdvanceToAbsPosition( falling );
+        if ( !mSclk->DoMoreTransitionsExistInCurrentData() )
+        {
+            end = falling;
+            break;
+        }
+
+        // SDATA edges while SCLK is low: a rising one followed by a falling
+        // one is the next SSC, anything else sets up a bit
+        U64 rising = mSclk->GetSampleOfNextEdge();
+        bool ssc = false;
+        while ( mSdata->WouldAdvancingToAbsPositionCauseTransition( rising - 1 ) )
+        {
+            mSdata->AdvanceToNextEdge();
+            if ( mSdata->GetBitState() == BIT_HIGH &&
+                 mSdata->WouldAdvancingToAbsPositionCauseTransition( rising - 1 ) )
+            {
+                ssc = true;
+                break;
+            }
+        }
+        if ( ssc )
+        {
+            end = falling + low;
+            if ( end >= mSdata->GetSampleNumber() )
+            {
+                end = mSdata->GetSampleNumber() - 1;
+            }
+            break;
+        }
+        AdvanceSclkToNextEdge();
+    }
+    mBus->mPacket.mEndingSample = end;
+}
+
+template< bool FromCommandFrame >
+void RFFEAnalyzer::FindParity( U64 frame_data )
 {
     U64 data;
+    U64 end;
     BitState bitstate;
-    AnalyzerResults::MarkerType state;
+    U32 b = mBus->mTrace.mBitCount;
 
-    bitstate = GetNextBit( 0, sampleClkOffsets, sampleDataOffsets );
-    sampleClkOffsets[1] = mSclk->GetSampleNumber();
-    mSdata->AdvanceToAbsPosition( sampleClkOffsets[1] );
+    bitstate = GetNextBit();
+    RFFE_PHASE( PhaseBitExtraction );
+    end = mSclk->GetSampleNumber();
+    mSdata->AdvanceToAbsPosition( end );
 
     if ( bitstate == BIT_HIGH )
     {
         data = 1;
-        state = AnalyzerResults::One;
+        mBus->mPacket.mParity |= ( 1 << mBus->mPacket.mParityCount );
     }
     else
     {
         data = 0;
-        state = AnalyzerResults::Zero;
     }
+    bool parity_ok = RFFEUtil::isParityOk( frame_data, (U8)data );
+    if ( !parity_ok )
+    {
+        mBus->mPacket.mParityErrors |= ( 1 << mBus->mPacket.mParityCount );
+        RFFE_COUNT( mParityErrors );
+    }
+    mBus->mPacket.mParityCount++;
+    mBus->mPacket.mEndingSample = end;
 
     FillInFrame( RFFEAnalyzerResults::RffeParityField,
                  data,
-                 (fromCommandFrame ? 1 : 0),
-                 sampleClkOffsets[0],
-                 sampleClkOffsets[1],
-                 0, 1,
-                 &state);
+                 ( FromCommandFrame ? RFFE_PARITY_COMMAND : 0 ) |
+                 ( parity_ok ? 0 : RFFE_PARITY_ERROR ),
+                 mBus->mTrace.mBitClk[b],
+                 end,
+                 b, 1 );
 }
 
-bool RFFEAnalyzer::FindBusPark()
+// Bus park cycle: SCLK rises and falls once more. In a read the slave then
+// drives the data frames, so the cycle ends at the next rising edge whatever
+// speed the slave answers at. After the last bus park SCLK stays low; the
+// cycle ends one SCLK low time (as measured on this packet) after the
+// falling edge, but never reaches into the next packet.
+void RFFEAnalyzer::FindBusPark( bool last )
 {
-    U64 delta;
-    bool reachClkEdge = false;
+    U64 rising;
+    U64 falling;
+    U64 end;
+    U32 b = mBus->mTrace.mBitCount++;
+
+    RFFE_PHASE( PhaseBitExtraction );
 
     // at rising edge of clk
-    sampleClkOffsets[0] = mSclk->GetSampleNumber();
-    mSclk->AdvanceToNextEdge();
+    rising = mSclk->GetSampleNumber();
+    AdvanceSclkToNextEdge();
 
     // at falling edge of clk
-    sampleDataOffsets[0] = mSclk->GetSampleNumber();
-    mSdata->AdvanceToAbsPosition( sampleDataOffsets[0] );
-    
-    // look if next rising edge is in reach
-    delta =  sampleDataOffsets[0] - sampleClkOffsets[0];
-    if ( mSclk->WouldAdvancingCauseTransition( (U32)(delta + 2) ) )
+    falling = mSclk->GetSampleNumber();
+
+    if ( !last )
     {
-        mSclk->AdvanceToNextEdge();
-        sampleClkOffsets[1] = mSclk->GetSampleNumber();
-        mSdata->AdvanceToAbsPosition( sampleClkOffsets[1] );
+        AdvanceSclkToNextEdge();
+        end = mSclk->GetSampleNumber();
 
-        reachClkEdge= true;
+        // a half speed read runs slower than the request, measure it separately
+        mBus->mClockLowSum   = 0;
+        mBus->mClockLowCount = 0;
     }
     else
     {
-        sampleClkOffsets[1] = sampleDataOffsets[0] + delta + 2;
-        if( mSclk->DoMoreTransitionsExistInCurrentData() )
+        if ( mBus->mClockLowCount != 0 )
         {
-            mSclk->AdvanceToAbsPosition ( sampleClkOffsets[1] );
-            mSdata->AdvanceToAbsPosition( sampleClkOffsets[1] );
+            end = falling + ( mBus->mClockLowSum + mBus->mClockLowCount / 2 ) / mBus->mClockLowCount;
+        }
+        else if ( U32 sclk_hz = mSettings->mDetectedSclkHz.load( std::memory_order_relaxed ) )
+        {
+            end = falling + mSampleRateHz / ( 2 * sclk_hz );
+        }
+        else
+        {
+            end = falling + ( falling - rising );
         }
-    }
 
-    return reachClkEdge;
+        mSdata->AdvanceToAbsPosition( falling );
+        if ( mSdata->WouldAdvancingToAbsPositionCauseTransition( end ) )
+        {
+            end = mSdata->GetSampleOfNextEdge() - 1;
+        }
+        if ( mSclk->WouldAdvancingToAbsPositionCauseTransition( end ) )
+        {
+            end = mSclk->GetSampleOfNextEdge() - 1;
+        }
+        if ( end < falling )
+        {
+            end = falling;
+        }
+        mSclk->AdvanceToAbsPosition( end );
+    }
+    mSdata->AdvanceToAbsPosition( end );
+    mBus->mPacket.mEndingSample = end;
+
+    mBus->mTrace.mBitClk[b]     = rising;
+    mBus->mTrace.mBitSample[b]  = falling;
+    mBus->mTrace.mBitMarker[b]  = AnalyzerResults::Stop;
+    mBus->mTrace.mBitFlags[b]   = 0;
+    mBus->mTrace.mBitClk[b + 1] = end;
 }
 
 void RFFEAnalyzer::FindBusParkLastSimbol()
 {
-    AnalyzerResults::MarkerType mark = AnalyzerResults::Stop;
+    U32 b = mBus->mTrace.mBitCount;
 
-    FindBusPark();
+    FindBusPark( true );
 
     FillInFrame( RFFEAnalyzerResults::RffeBusParkField,
                  0,
                  0,
-                 sampleClkOffsets[0],
-                 sampleClkOffsets[1],
-                 0, 1,
-                 &mark );
+                 mBus->mTrace.mBitClk[b],
+                 mBus->mTrace.mBitClk[b + 1],
+                 b, 1 );
 }
 
 void RFFEAnalyzer::FindBusParkAdditionalSimbols()
 {
-    AnalyzerResults::MarkerType mark = AnalyzerResults::Stop;
-
-    bool reachClkEdge = FindBusPark();
+    U32 b = mBus->mTrace.mBitCount;
 
-    if( !reachClkEdge && mSclk->DoMoreTransitionsExistInCurrentData() )
-    {
-        mSclk->AdvanceToNextEdge();
-        mSdata->AdvanceToAbsPosition( mSclk->GetSampleNumber() );
-    }
+    FindBusPark( false );
 
     FillInFrame( RFFEAnalyzerResults::RffeBusParkField,
                  0,
                  0,
-                 sampleClkOffsets[0],
-                 sampleClkOffsets[1],
-                 0, 1,
-                 &mark );
-
+                 mBus->mTrace.mBitClk[b],
+                 mBus->mTrace.mBitClk[b + 1],
+                 b, 1 );
 }
 
 void RFFEAnalyzer::FindDataFrame()
 {
-    AnalyzerResults::MarkerType sampleDataState[16];
+    U32 b = mBus->mTrace.mBitCount;
 
-    U64 data = GetBitStream( 8, sampleDataState );
+    U64 data = GetBits< 8 >();
+    U16 address = mBus->mRffeType == RFFEAnalyzerResults::RffeTypeMaskedWrite ? mBus->mPacket.mAddress :
+                  U16( mBus->mPacket.mAddress + mBus->mPacket.mByteCount );
+    mBus->mPacket.mData[mBus->mPacket.mByteCount++] = (U8)data;
 
-    // decode data
+    // decode data, along with the register it goes to or comes from
     FillInFrame( RFFEAnalyzerResults::RffeDataField,
                  data,
-                 0,
-                 sampleClkOffsets[0],
-                 sampleClkOffsets[8],
-                 0, 8,
-                 sampleDataState );
+                 address,
+                 mBus->mTrace.mBitClk[b],
+                 mBus->mTrace.mBitClk[b + 8],
+                 b, 8 );
+
+    FindParity< false >( data );
+}
+
+// the mask of a masked write goes into the payload ahead of the data byte
+void RFFEAnalyzer::FindMaskFrame()
+{
+    U32 b = mBus->mTrace.mBitCount;
+
+    U64 mask = GetBits< 8 >();
+    mBus->mPacket.mData[mBus->mPacket.mByteCount++] = (U8)mask;
+
+    FillInFrame( RFFEAnalyzerResults::RffeMaskField,
+                 mask,
+                 mBus->mPacket.mAddress,
+                 mBus->mTrace.mBitClk[b],
+                 mBus->mTrace.mBitClk[b + 8],
+                 b, 8 );
 
-    FindParity(false);
+    FindParity< false >( mask );
 }
 
 void RFFEAnalyzer::FindAddressFrame(RFFEAnalyzerResults::RffeAddressFieldSubType type)
 {
-    AnalyzerResults::MarkerType sampleDataState[16];
+    U32 b = mBus->mTrace.mBitCount;
 
-    U64 addr = GetBitStream( 8, sampleDataState );
+    U64 addr = GetBits< 8 >();
+    mBus->mPacket.mAddress = (U16)( ( mBus->mPacket.mAddress << 8 ) | addr );
 
     // decode address
     FillInFrame( RFFEAnalyzerResults::RffeAddressField,
                  addr,
                  type,
-                 sampleClkOffsets[0],
-                 sampleClkOffsets[8],
-                 0, 8,
-                 sampleDataState );
+                 mBus->mTrace.mBitClk[b],
+                 mBus->mTrace.mBitClk[b + 8],
+                 b, 8 );
 
-    FindParity(false);
+    FindParity< false >( addr );
 }
 
 /******************************************************************* markers */
-void RFFEAnalyzer::DrawMarkersDotsAndStates( U32 start,
+void RFFEAnalyzer::DrawMarkersDotsAndStates( const RFFEPacketTrace& trace,
+                                             U32 start,
                                              U32 len,
                                              AnalyzerResults::MarkerType type,
-                                             AnalyzerResults::MarkerType *states)
+                                             Channel& sclk,
+                                             Channel& sdata )
 {
     for (U32 i=start; len--; i++ )
     {
-        mResults->AddMarker( sampleClkOffsets[i],
+        mResults->AddMarker( trace.mBitClk[i],
                              type,
-                             mSettings->mSclkChannel );
-        mResults->AddMarker( sampleDataOffsets[i],
-                             states[i],
-                             mSettings->mSdataChannel );
+                             sclk );
+        mResults->AddMarker( trace.mBitSample[i],
+                             (AnalyzerResults::MarkerType)trace.mBitMarker[i],
+                             sdata );
     }
 }
 
@@ -507,78 +1329,395 @@ void RFFEAnalyzer::FillInFrame( RFFEAnalyzerResults::RffeFrameType type,
                                 U64 starting_sample,
                                 U64 ending_sample,
                                 U32 markers_start,
-                                U32 markers_len,
-                                AnalyzerResults::MarkerType *states )
+                                U32 markers_len )
 {
-    Frame frame;
+    RFFEPacketFrame& frame = mBus->mTrace.mFrames[mBus->mTrace.mFrameCount++];
+
+    frame.mType            = (U8)type;
+    frame.mFlags           = 0;
+    frame.mData1           = frame_data1;
+    frame.mData2           = frame_data2;
+    frame.mStartingSample  = starting_sample;
+    frame.mEndingSample    = ending_sample;
+    frame.mFirstBit        = (U8)markers_start;
+    frame.mBitCount        = (U8)markers_len;
+
+    if ( mTimingAnalysis )
+    {
+        for ( U32 i = markers_start; i < markers_start + markers_len; i++ )
+        {
+            frame.mFlags |= mBus->mTrace.mBitFlags[i];
+        }
+    }
+}
+
+void RFFEAnalyzer::CommitPacket( const RFFEPacket& packet, const RFFEPacketTrace& trace )
+{
+    Channel sclk  = mSettings->GetSclkChannel( packet.mBus );
+    Channel sdata = mSettings->GetSdataChannel( packet.mBus );
+
+    RFFE_PHASE( PhaseResultCommit );
+
+    if ( mCollapseRepeats )
+    {
+        if ( AddRepeat( packet ) )
+        {
+            ReportProgress( packet.mEndingSample );
+            return;
+        }
+        EndRepeatRun();
+    }
+
+    if ( mPacketOutput != NULL )
+    {
+        U32 error_frames = 0;
+        for ( U32 i = 0; i < trace.mFrameCount; i++ )
+        {
+            error_frames += trace.mFrames[i].mType == RFFEAnalyzerResults::RffeErrorCaseField;
+        }
+        if ( mCollapseRepeats )
+        {
+            mRepeats.mOpen        = true;
+            mRepeats.mPacket      = packet;
+            mRepeats.mCount       = 0;
+            mRepeats.mLastStart   = packet.mStartingSample;
+            mRepeats.mErrorFrames = error_frames;
+        }
+        else
+        {
+            OutputPacket( packet, error_frames );
+        }
+        ReportProgress( packet.mEndingSample );
+        return;
+    }
+
+    mResults->AddMarker( packet.mStartingSample,
+                         AnalyzerResults::Start,
+                         sdata );
+
+    if ( mSummaryFrames )
+    {
+        AddSummaryFrames( packet, trace );
+    }
+    else
+    {
+        for ( U32 i = 0; i < trace.mFrameCount; i++ )
+        {
+            const RFFEPacketFrame& packet_frame = trace.mFrames[i];
+            Frame frame;
+
+            frame.mType                    = packet_frame.mType;
+            frame.mFlags                   = packet_frame.mFlags | packet.mBus |
+                                             packet.mSlaveAddress << RFFE_FRAME_SA_SHIFT;
+            frame.mData1                   = packet_frame.mData1;
+            frame.mData2                   = packet_frame.mData2;
+            frame.mStartingSampleInclusive = packet_frame.mStartingSample;
+            frame.mEndingSampleInclusive   = packet_frame.mEndingSample;
+
+            if ( packet_frame.mBitCount != 0 )
+            {
+                DrawMarkersDotsAndStates( trace,
+                                          packet_frame.mFirstBit,
+                                          packet_frame.mBitCount,
+                                          AnalyzerResults::UpArrow,
+                                          sclk,
+                                          sdata );
+            }
+
+            mResults->AddFrame( frame );
+        }
+    }
+    if ( packet.mEventDelay != RFFE_NO_EVENT_DELAY )
+    {
+        AddEventFrame( packet );
+    }
+
+    if ( mCollapseRepeats )
+    {
+        // the packet is only complete once its run of repeats ends
+        mRepeats.mOpen      = true;
+        mRepeats.mPacket    = packet;
+        mRepeats.mCount     = 0;
+        mRepeats.mLastStart = packet.mStartingSample;
+    }
+    else
+    {
+        mResults->CommitPacketAndStartNewPacket();
+    }
+    mResults->CommitResults();
+    ReportProgress( packet.mEndingSample );
+}
 
-    frame.mType                    = (U8)type;
-    frame.mData1                   = frame_data1;
-    frame.mData2                   = frame_data2;
-	frame.mStartingSampleInclusive = starting_sample;
-	frame.mEndingSampleInclusive   = ending_sample;
+// Counts packet into the open run if it repeats the run's packet: same bus,
+// SA, command (type, byte count), address and payload, neither with parity
+// errors, timing violations or an event latency. A run ends before its
+// offsets and intervals outgrow 32 bits.
+bool RFFEAnalyzer::AddRepeat( const RFFEPacket& packet )
+{
+    const RFFEPacket& first = mRepeats.mPacket;
+    U64 interval = packet.mStartingSample - mRepeats.mLastStart;
+
+    if ( !mRepeats.mOpen ||
+         packet.mBus != first.mBus ||
+         packet.mSlaveAddress != first.mSlaveAddress ||
+         packet.mCommand != first.mCommand ||
+         packet.mAddress != first.mAddress ||
+         packet.mByteCount != first.mByteCount ||
+         memcmp( packet.mData, first.mData, packet.mByteCount ) != 0 ||
+         ( packet.mParityErrors | first.mParityErrors ) != 0 ||
+         ( packet.mTimingViolations | first.mTimingViolations ) != 0 ||
+         packet.mEventDelay != RFFE_NO_EVENT_DELAY ||
+         first.mEventDelay != RFFE_NO_EVENT_DELAY ||
+         interval > 0xFFFFFFFF ||
+         mRepeats.mCount == 0xFFFFFFFF ||
+         ( mRepeats.mCount != 0 && packet.mStartingSample - mRepeats.mFirstStart > 0xFFFFFFFF ) )
+    {
+        return false;
+    }
 
-    if ( markers_len != 0 )
+    if ( mRepeats.mCount == 0 )
     {
-        DrawMarkersDotsAndStates( markers_start,
-                                  markers_len,
-                                  AnalyzerResults::UpArrow,
-                                  states );
+        mRepeats.mFirstStart  = packet.mStartingSample;
+        mRepeats.mMinInterval = U32( interval );
+        mRepeats.mMaxInterval = U32( interval );
     }
     else
     {
+        mRepeats.mMinInterval = std::min( mRepeats.mMinInterval, U32( interval ) );
+        mRepeats.mMaxInterval = std::max( mRepeats.mMaxInterval, U32( interval ) );
+    }
+    mRepeats.mCount++;
+    mRepeats.mLastStart = packet.mStartingSample;
+    mRepeats.mLastEnd   = packet.mEndingSample;
+    return true;
+}
+
+// The event latency of a packet: a frame just after its end, and a marker
+// on the event channel at the edge (once for packets sharing an edge)
+void RFFEAnalyzer::AddEventFrame( const RFFEPacket& packet )
+{
+    Frame frame;
+
+    frame.mType                    = RFFEAnalyzerResults::RffeEventField;
+    frame.mFlags                   = packet.mBus | packet.mSlaveAddress << RFFE_FRAME_SA_SHIFT;
+    frame.mData1                   = packet.mEventDelay;
+    frame.mData2                   = mSettings->mEventEdge;
+    frame.mStartingSampleInclusive = packet.mEndingSample + 1;
+    frame.mEndingSampleInclusive   = packet.mEndingSample + 1;
+    if ( packet.mEventDelay == RFFE_EVENT_MISSED )
+    {
+        frame.mFlags |= DISPLAY_AS_WARNING_FLAG;
+    }
+    mResults->AddFrame( frame );
+
+    U64 edge = packet.mEndingSample + packet.mEventDelay;
+    if ( packet.mEventDelay != RFFE_EVENT_MISSED && edge > mLastEventMarker )
+    {
+        mResults->AddMarker( edge,
+                             mSettings->mEventEdge == RFFEAnalyzerSettings::EventEdgeRising ? AnalyzerResults::UpArrow :
+                             mSettings->mEventEdge == RFFEAnalyzerSettings::EventEdgeFalling ? AnalyzerResults::DownArrow :
+                             AnalyzerResults::Dot,
+                             mSettings->mEventChannel );
+        mLastEventMarker = edge;
+    }
+}
+
+// Closes the results packet of the open run, with a frame over its repeats
+void RFFEAnalyzer::EndRepeatRun()
+{
+    if ( !mRepeats.mOpen )
+    {
+        return;
+    }
+
+    if ( mPacketOutput != NULL )
+    {
+        OutputPacket( mRepeats.mPacket, mRepeats.mErrorFrames );
+        mRepeats.mOpen = false;
+        return;
+    }
+
+    if ( mRepeats.mCount != 0 )
+    {
+        Frame frame;
+
+        frame.mType                    = RFFEAnalyzerResults::RffeRepeatField;
+        frame.mFlags                   = mRepeats.mPacket.mBus;
+        frame.mData1                   = U64( mRepeats.mCount ) | ( mRepeats.mLastStart - mRepeats.mFirstStart ) << 32;
+        frame.mData2                   = U64( mRepeats.mMinInterval ) | U64( mRepeats.mMaxInterval ) << 32;
+        frame.mStartingSampleInclusive = mRepeats.mFirstStart;
+        frame.mEndingSampleInclusive   = mRepeats.mLastEnd;
+        mResults->AddFrame( frame );
+    }
+    mResults->CommitPacketAndStartNewPacket();
+    mResults->CommitResults();
+    mRepeats.mOpen = false;
+}
+
+// What ReadPacket would give for the packet, with the open run of repeats
+// when it is mRepeats.mPacket
+void RFFEAnalyzer::OutputPacket( const RFFEPacket& packet, U32 error_frames )
+{
+    RFFEPacketExtras extras;
+
+    extras.mHasAddress  = RFFEAnalyzerResults::GetAddressBits( packet.mType ) != 0;
+    extras.mErrorFrames = error_frames;
+    extras.mRepeats     = 0;
+    extras.mLastStart   = 0;
+    extras.mMinInterval = 0;
+    extras.mMaxInterval = 0;
+    if ( mRepeats.mOpen && mRepeats.mCount != 0 && &packet == &mRepeats.mPacket )
+    {
+        extras.mRepeats     = mRepeats.mCount;
+        extras.mLastStart   = mRepeats.mLastStart;
+        extras.mMinInterval = mRepeats.mMinInterval;
+        extras.mMaxInterval = mRepeats.mMaxInterval;
+    }
+    mPacketOutput->AddPacket( packet, extras );
+}
+
+// One frame over the whole packet instead of one per field, and no bit
+// markers. A payload of more than 8 bytes goes on in a second frame from
+// the 9th byte. Warnings of any field show on the summary.
+void RFFEAnalyzer::AddSummaryFrames( const RFFEPacket& packet, const RFFEPacketTrace& trace )
+{
+    Frame frame;
+    U8 flags = 0;
+    U64 split = packet.mEndingSample + 1;
+    U32 data_frames = 0;
+
+    for ( U32 i = 0; i < trace.mFrameCount; i++ )
+    {
+        flags |= trace.mFrames[i].mFlags;
+        if ( trace.mFrames[i].mType == RFFEAnalyzerResults::RffeDataField && data_frames++ == 8 )
+        {
+            split = trace.mFrames[i].mStartingSample;
+        }
     }
 
+    frame.mType                    = RFFEAnalyzerResults::RffeSummaryField;
+    frame.mFlags                   = flags | packet.mBus;
+    frame.mData1                   = RFFEAnalyzerResults::GetSummaryHeader( packet );
+    frame.mData2                   = RFFEAnalyzerResults::GetSummaryBytes( packet, 0 );
+    frame.mStartingSampleInclusive = packet.mStartingSample;
+    frame.mEndingSampleInclusive   = split - 1;
     mResults->AddFrame( frame );
-	mResults->CommitResults();
-	ReportProgress( frame.mEndingSampleInclusive );
+
+    if ( packet.mByteCount > 8 )
+    {
+        frame.mType                    = RFFEAnalyzerResults::RffeSummaryDataField;
+        frame.mData1                   = RFFEAnalyzerResults::GetSummaryBytes( packet, 8 );
+        frame.mData2                   = packet.mByteCount - 8;
+        frame.mStartingSampleInclusive = split;
+        frame.mEndingSampleInclusive   = packet.mEndingSample;
+        mResults->AddFrame( frame );
+    }
 }
 
 /**************************************************************** bits/bytes */
-BitState RFFEAnalyzer::GetNextBit(U32 const idx, U64 *const clk, U64 *const data )
+inline BitState RFFEAnalyzer::GetNextBit()
 {
     BitState state;
+    U32 idx = mBus->mTrace.mBitCount++;
+
+    RFFE_PHASE( PhaseBitExtraction );
 
     // at rising edge of clk
-    clk[idx] =  mSclk->GetSampleNumber();
-    gSampleClk[gSampleCount] = clk[idx] - gSampleNormalized;
+    mBus->mTrace.mBitClk[idx] = mSclk->GetSampleNumber();
 
     // advance to falling edge of sclk
-    mSclk->AdvanceToNextEdge();
-    data[idx] =  mSclk->GetSampleNumber();
-    gsampleData[gSampleCount] = data[idx] - gSampleNormalized;
-    gSampleCount++;
+    AdvanceSclkToNextEdge();
+    mBus->mTrace.mBitSample[idx] = mSclk->GetSampleNumber();
+
+    // walk the SDATA edges up to the sampling point to find the last one
+    U64 setup_edge = RFFE_NO_EDGE;
+    if ( mBus->mMeasureTiming )
+    {
+        while ( mSdata->WouldAdvancingToAbsPositionCauseTransition( mBus->mTrace.mBitSample[idx] ) )
+        {
+            mSdata->AdvanceToNextEdge();
+            setup_edge = mSdata->GetSampleNumber();
+        }
+    }
 
-    mSdata->AdvanceToAbsPosition( data[idx] );
+    mSdata->AdvanceToAbsPosition( mBus->mTrace.mBitSample[idx] );
     state = mSdata->GetBitState();
 
+    if ( state == BIT_HIGH )
+        mBus->mTrace.mBitMarker[idx] = AnalyzerResults::One;
+    else
+        mBus->mTrace.mBitMarker[idx] = AnalyzerResults::Zero;
+
     // at rising edge of clk
-    mSclk->AdvanceToNextEdge();
+    AdvanceSclkToNextEdge();
+    U64 low = mSclk->GetSampleNumber() - mBus->mTrace.mBitSample[idx];
+    mBus->mClockLowSum += low;
+    mBus->mClockLowCount++;
+    if ( !mSclkDetector.IsDone() )
+    {
+        mSclkDetector.AddBit( mBus->mTrace.mBitSample[idx] - mBus->mTrace.mBitClk[idx], low );
+    }
+
+    mBus->mTrace.mBitFlags[idx] = 0;
+    if ( mBus->mMeasureTiming )
+    {
+        U64 hold_edge = mSdata->DoMoreTransitionsExistInCurrentData() ?
+                        mSdata->GetSampleOfNextEdge() : RFFE_NO_EDGE;
+
+        if ( mTiming.AddBit( mBus->mTrace.mBitClk[idx],
+                             mBus->mTrace.mBitSample[idx],
+                             mSclk->GetSampleNumber(),
+                             setup_edge,
+                             hold_edge ) != 0 )
+        {
+            mBus->mTrace.mBitFlags[idx] = DISPLAY_AS_WARNING_FLAG;
+        }
+    }
 
     return state;
 }
 
-U64 RFFEAnalyzer::GetBitStream(U32 len, AnalyzerResults::MarkerType *states)
+// A frame of Bits bits, MSB first. The length is a compile time constant,
+// so the bit loop unrolls and GetNextBit() inlines into it; building with
+// RFFE_GENERIC_DECODE (build_analyzer.py --generic-decode) goes through the
+// runtime length GetBitStream() instead, to compare the two.
+template< U32 Bits >
+U64 RFFEAnalyzer::GetBits()
+{
+#ifdef RFFE_GENERIC_DECODE
+    return GetBitStream( Bits );
+#else
+    U64 data = 0;
+
+    RFFE_PHASE( PhaseBitExtraction );
+
+    // starting at rising edge of clk
+    for( U32 i = 0; i < Bits; i++ )
+    {
+        data = ( data << 1 ) | ( GetNextBit() == BIT_HIGH ? 1 : 0 );
+    }
+    mBus->mTrace.mBitClk[mBus->mTrace.mBitCount] = mSclk->GetSampleNumber();
+
+    return data;
+#endif
+}
+
+U64 RFFEAnalyzer::GetBitStream(U32 len)
 {
     U64 data;
     U32 i;
-    BitState state;
 	DataBuilder data_builder;
 
+    RFFE_PHASE( PhaseBitExtraction );
+
     data_builder.Reset( &data, AnalyzerEnums::MsbFirst , len );
 
     // starting at rising edge of clk
     for( i=0; i < len; i++ )
     {
-        state = GetNextBit( i, sampleClkOffsets,  sampleDataOffsets );
-        data_builder.AddBit( state );
-
-        if ( mSdata->GetBitState() == BIT_HIGH )
-            states[i] = AnalyzerResults::One;
-        else
-            states[i] = AnalyzerResults::Zero;
+        data_builder.AddBit( GetNextBit() );
     }
-    sampleClkOffsets[i] =  mSclk->GetSampleNumber();
+    mBus->mTrace.mBitClk[mBus->mTrace.mBitCount] = mSclk->GetSampleNumber();
 
     return data;
 }
@@ -588,6 +1727,16 @@ bool RFFEAnalyzer::NeedsRerun()
 	return false;
 }
 
+const RFFESelfCheck& RFFEAnalyzer::GetSelfCheck() const
+{
+    return mSelfCheck;
+}
+
+void RFFEAnalyzer::SetPacketOutput( RFFEPacketOutput* output )
+{
+    mPacketOutput = output;
+}
+
 U32 RFFEAnalyzer::GenerateSimulationData( U64 minimum_sample_index,
                                           U32 device_sample_rate,
                                           SimulationChannelDescriptor** simulation_channels )
@@ -605,7 +1754,14 @@ U32 RFFEAnalyzer::GenerateSimulationData( U64 minimum_sample_index,
 
 U32 RFFEAnalyzer::GetMinimumSampleRateHz()
 {
-	return 50000000;
+    U32 sclk_hz = mSettings->GetBusSclkHz();
+
+    // the decoder only follows edges, two samples per SCLK half period do
+    if ( sclk_hz == 0 )
+    {
+        return 50000000;
+    }
+    return 4 * sclk_hz;
 }
 
 const char* RFFEAnalyzer::GetAnalyzerName() const
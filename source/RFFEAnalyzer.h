@@ -2,14 +2,79 @@
 #define RFFE_ANALYZER_H
 
 #include <Analyzer.h>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <thread>
 #include "RFFEAnalyzerResults.h"
+#include "RFFECheckpoints.h"
 #include "RFFESimulationDataGenerator.h"
+#include "RFFESelfCheck.h"
+#include "RFFEPacket.h"
+#include "RFFEPacketRing.h"
+#include "RFFETiming.h"
+#include "RFFELatency.h"
+#include "RFFEInstrumentation.h"
 
 #pragma warning( push )
 //warning C4275: non dll-interface class 'Analyzer2' used 
 //               as base for dll-interface class 'RFFEAnalyzer'
 #pragma warning( disable : 4275 )
 
+// Decoder state of one RFFE bus. Every bus is decoded on its own channel
+// pair; their packets are committed to the results in sample order.
+struct RFFEBus
+{
+    U8 mId;
+    Channel mSclkChannel;
+    Channel mSdataChannel;
+    RFFEChannel* mSclk;
+    RFFEChannel* mSdata;
+    bool mPending;          // mPacket is decoded but not committed yet
+    std::chrono::steady_clock::time_point mDecodedAt;
+
+    RFFEAnalyzerResults::RffeTypeFieldType mRffeType;
+    RFFEPacket mPacket;
+    RFFEPacketTrace mTrace;
+    U64 mClockLowSum;       // SCLK low time of the bits sampled so far,
+    U32 mClockLowCount;     // since the SSC or the read bus park
+    bool mMeasureTiming;    // the timing of the packet goes into the report
+    U64 mSsc;               // last SSC found, see RFFECheckpoint
+    U64 mSscFall;
+    U64 mSscClock;
+
+#ifdef RFFE_INSTRUMENTATION
+    RFFEChannel mSclkProbe;
+    RFFEChannel mSdataProbe;
+#endif
+};
+
+// Run of packets identical to mPacket, the first of them. Its results packet
+// stays open until the run ends and then gets one RffeRepeatField frame for
+// all the repeats.
+struct RFFERepeatRun
+{
+    bool mOpen;
+    RFFEPacket mPacket;
+    U32 mCount;             // repeats after the first packet
+    U64 mFirstStart;        // SSC of the first repeat
+    U64 mLastStart;         // SSC of the last packet of the run
+    U64 mLastEnd;
+    U32 mMinInterval;       // SSC to SSC, in samples
+    U32 mMaxInterval;
+    U32 mErrorFrames;       // of mPacket, for RFFEPacketOutput
+};
+
+// Takes the packets of a decode in place of the results: no frames, markers
+// or bubbles are made for them. The Python module fills its arrays from it.
+class RFFEPacketOutput
+{
+public:
+    virtual ~RFFEPacketOutput() {}
+
+    virtual void AddPacket( const RFFEPacket& packet, const RFFEPacketExtras& extras ) = 0;
+};
+
 class RFFEAnalyzerSettings;
 class ANALYZER_EXPORT RFFEAnalyzer : public Analyzer2
 {
@@ -27,6 +92,12 @@ public:
 	virtual const char* GetAnalyzerName() const;
 	virtual bool NeedsRerun();
 
+    // round-trip check of the last decode of randomized simulation data
+    const RFFESelfCheck& GetSelfCheck() const;
+
+    // packets of the following decodes go to output (NULL: to the results)
+    void SetPacketOutput( RFFEPacketOutput* output );
+
 #pragma warning( push )
     //warning C4251: 'RFFEAnalyzer::<...>' : class <...> needs to have dll-interface
     //               to be used by clients of class
@@ -35,52 +106,117 @@ public:
 protected: //vars
 	std::auto_ptr< RFFEAnalyzerSettings > mSettings;
 	std::auto_ptr< RFFEAnalyzerResults > mResults;
-	AnalyzerChannelData* mSclk;
-	AnalyzerChannelData* mSdata;
+	RFFEChannel* mSclk;
+	RFFEChannel* mSdata;
 
 	RFFESimulationDataGenerator mSimulationDataGenerator;
 	bool mSimulationInitilized;
+	RFFESelfCheck mSelfCheck;
 
 	U32 mSampleRateHz;
-    RFFEAnalyzerResults::RffeTypeFieldType mRffeType;
+    U64 mDecodeEnd;
+    bool mTimingAnalysis;
+    RFFETiming mTiming;
+    RFFESclkDetector mSclkDetector;
+    bool mEventLatency;     // an event channel is set
+    RFFELatency mLatency;
+    U64 mLastEventMarker;   // event edge marked last, markers go in sample order
+    bool mSelfCheckActive;
+
+    RFFEBus mBuses[RFFE_MAX_BUSES];
+    U32 mBusCount;
+    RFFEBus* mBus;          // the bus being decoded, owner of mSclk/mSdata
+
+    // pipelined decode: this thread walks the edges, the worker builds results
+    bool mPipelined;
+    RFFEPacketRing mRing;
+    std::thread mExtractionThread;
+    std::atomic< bool > mStopExtraction;
+    std::atomic< bool > mExtractionIdle;
+    std::atomic< RFFEChannel* > mExtractionWait;  // SCLK the worker advances for it
+    std::exception_ptr mExtractionError;
+
+    // streaming decode: never block in the SDK waiting for more data
+    bool mStreaming;
+    std::chrono::microseconds mMaxLatency;
+    U64 mPacketsSinceReport;
+
+    bool mSummaryFrames;    // one frame per packet instead of one per field
+    bool mCollapseRepeats;
+    RFFERepeatRun mRepeats;
+    RFFEPacketOutput* mPacketOutput;
+
+    // reruns: build on the last decode where the settings allow
+    RFFECheckpoints mCheckpoints;
+    U64 mResultsSerial;     // counts the results objects made, names mResults
+    bool mResultsKept;      // SetupResults kept the results of the last decode
+    U64 mCommitFrom;        // packets starting earlier are stepped over
+    U64 mPacketsHandedOn;
+    U64 mFramesHandedOn;
+    U64 mNextCheckpoint;    // mPacketsHandedOn at which the next one is taken
 
 protected: // functions
+    void NewResults();
+    void SelectBus( RFFEBus* bus );
+    void GetCheckpoint( RFFECheckpoint* checkpoint );
+    bool IsCheckpointInData( const RFFECheckpoint& checkpoint );
+    void DecodeBuses();
+    RFFEBus* HandOnNextPacket();
+    bool DecodePacket();
+    void FinishPacket();
+    bool IsCommitDue( const RFFEBus* bus );
+    void AdvanceSclkToNextEdge();
+    void WaitForSclkEdge();
+    void Idle();
+    void WriteReports();
+    void RunPipelined();
+    void ExtractionThread();
+    void StopExtraction();
     void FindStartSeqCondition_MoveDataIfClkAheadOfData();
     bool FindStartSeqCondition_MoreTransitions();
 	bool FindStartSeqCondition_StartBitDetection();
     U64  FindStartSeqCondition_CalculatePulseWidth();
     S32 FindStartSeqCondition();
     S32 FindSlaveAddrAndCommand();
-    void FindParity(bool fromCommandFrame);
+    template< bool FromCommandFrame > void FindParity( U64 frame_data );
     void FindDataFrame();
+    void FindMaskFrame();
     void FindAddressFrame(RFFEAnalyzerResults::RffeAddressFieldSubType type);
     void FindBusParkLastSimbol();
     void FindBusParkAdditionalSimbols();
-    U64  GetBitStream(U32 len, AnalyzerResults::MarkerType *states);
-    void DrawMarkersDotsAndStates( U32 start,
+    void SkipPacket();
+    void FindEndOfUnknownCommand();
+    bool IsProtocolV2() const;
+    template< U32 Type > void DecodeFields( U32 count );
+    template< U32 Bits > U64 GetBits();
+    U64  GetBitStream(U32 len);
+    void DrawMarkersDotsAndStates( const RFFEPacketTrace& trace,
+                                   U32 start,
                                    U32 len,
                                    AnalyzerResults::MarkerType type,
-                                   AnalyzerResults::MarkerType *states);
-    BitState GetNextBit(U32 const idx, U64 *const clk, U64 *const data );
+                                   Channel& sclk,
+                                   Channel& sdata );
+    BitState GetNextBit();
     void FillInFrame( RFFEAnalyzerResults::RffeFrameType type,
                       U64 frame_data1,
                       U64 frame_data2,
                       U64 starting_sample,
                       U64 ending_sample,
                       U32 markers_start,
-                      U32 markers_len,
-                      AnalyzerResults::MarkerType *states);
+                      U32 markers_len );
+    void CommitPacket( const RFFEPacket& packet, const RFFEPacketTrace& trace );
+    void AddSummaryFrames( const RFFEPacket& packet, const RFFEPacketTrace& trace );
+    bool AddRepeat( const RFFEPacket& packet );
+    void AddEventFrame( const RFFEPacket& packet );
+    void EndRepeatRun();
+    void OutputPacket( const RFFEPacket& packet, U32 error_frames );
 private:
-    bool FindBusPark();
+    void FindBusPark( bool last );
 
+#ifdef RFFE_INSTRUMENTATION
 private:
-    U64 sampleClkOffsets[16];
-    U64 sampleDataOffsets[16];
-
-    U64 gSampleCount;
-    U64 gSampleNormalized;
-    U64 gSampleClk[256];
-    U64 gsampleData[256];
+    RFFEInstrumentation mInstrumentation;
+#endif
 
 #pragma warning( pop )
 };
@@ -2,7 +2,14 @@
 #include <AnalyzerHelpers.h>
 #include "RFFEAnalyzer.h"
 #include "RFFEAnalyzerSettings.h"
+#include "RFFEExportFile.h"
+#include "RFFEPcapng.h"
+#include "RFFEUtil.h"
+#include <algorithm>
+#include <string.h>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 
 static const char *RffeTypeStringShort[] =
@@ -15,6 +22,7 @@ static const char *RffeTypeStringShort[] =
     "W",
     "R",
     "W0",
+    "MW",
 };
 
 static const char *RffeTypeStringMid[] =
@@ -27,8 +35,270 @@ static const char *RffeTypeStringMid[] =
     "Wr",
     "Rd",
     "Wr0",
+    "MskWr",
 };
 
+// RffeSummaryField header: address, SA, type and byte count of the packet,
+// whether the command parity is wrong, its parity bits (command frame
+// first) above and the lower 8 bits of the command frame on top. The v2.x
+// type went into bit 29 when the three type bits were used up.
+#define SUMMARY_ADDRESS( h )        U16( ( h ) & 0xFFFF )
+#define SUMMARY_SA( h )             U8( ( ( h ) >> 16 ) & 0x0F )
+#define SUMMARY_TYPE( h )           U8( ( ( ( h ) >> 20 ) & 0x07 ) | ( ( ( h ) >> 26 ) & 0x08 ) )
+#define SUMMARY_PARITY_ERROR( h )   U8( ( ( h ) >> 23 ) & 0x01 )
+#define SUMMARY_BYTE_COUNT( h )     U8( ( ( h ) >> 24 ) & 0x1F )
+#define SUMMARY_PARITY( h )         U32( ( ( h ) >> 32 ) & 0xFFFFFF )
+#define SUMMARY_COMMAND( h )        U8( ( h ) >> 56 )
+
+// width of the register address of a packet type, 0 for none
+U32 RFFEAnalyzerResults::GetAddressBits( U8 type )
+{
+    switch( type )
+    {
+    case RFFEAnalyzerResults::RffeTypeExtWrite:
+    case RFFEAnalyzerResults::RffeTypeExtRead:
+    case RFFEAnalyzerResults::RffeTypeMaskedWrite:
+        return 8;
+    case RFFEAnalyzerResults::RffeTypeExtLongWrite:
+    case RFFEAnalyzerResults::RffeTypeExtLongRead:
+        return 16;
+    case RFFEAnalyzerResults::RffeTypeNormalWrite:
+    case RFFEAnalyzerResults::RffeTypeNormalRead:
+        return 5;
+    default:
+        return 0;
+    }
+}
+
+// The payload column of a packet committed as summary frames, the same as
+// its field frames would have given
+static void AppendSummaryPayload( std::stringstream& payload,
+                                  U64 header,
+                                  const U8* data,
+                                  DisplayBase display_base,
+                                  bool show_parity,
+                                  bool show_buspark )
+{
+    U8 type = SUMMARY_TYPE( header );
+    U32 parity = SUMMARY_PARITY( header ) >> 1;    // the command parity has its own column
+    U32 address_frames = 0;
+    bool read = false;
+    char data_str[8];
+
+    switch( type )
+    {
+    case RFFEAnalyzerResults::RffeTypeReserved:
+        return;
+    case RFFEAnalyzerResults::RffeTypeShortWrite:
+        AnalyzerHelpers::GetNumberString( data[0], display_base, 7, data_str, 8 );
+        payload << data_str << " ";
+        if ( show_buspark ) payload << "BP ";
+        return;
+    case RFFEAnalyzerResults::RffeTypeExtRead:
+        read = true;
+        // fall through
+    case RFFEAnalyzerResults::RffeTypeExtWrite:
+        address_frames = 1;
+        break;
+    case RFFEAnalyzerResults::RffeTypeExtLongRead:
+        read = true;
+        // fall through
+    case RFFEAnalyzerResults::RffeTypeExtLongWrite:
+        address_frames = 2;
+        break;
+    case RFFEAnalyzerResults::RffeTypeNormalRead:
+        read = true;
+        break;
+    case RFFEAnalyzerResults::RffeTypeMaskedWrite:
+        address_frames = 1;
+        break;
+    }
+
+    for ( U32 i = 0; i < address_frames; i++, parity >>= 1 )
+    {
+        if ( show_parity ) payload << "P" << ( parity & 1 ) << " ";
+    }
+    if ( read && show_buspark ) payload << "BP ";
+    for ( U32 i = 0; i < SUMMARY_BYTE_COUNT( header ); i++, parity >>= 1 )
+    {
+        AnalyzerHelpers::GetNumberString( data[i], display_base, 8, data_str, 8 );
+        if ( i == 0 && type == RFFEAnalyzerResults::RffeTypeMaskedWrite ) payload << "M:";
+        payload << data_str << " ";
+        if ( show_parity ) payload << "P" << ( parity & 1 ) << " ";
+    }
+    if ( show_buspark ) payload << "BP ";
+}
+
+// "PA_CTRL EN=1 GAIN=0xA" for a payload byte of a mapped register, the
+// registers of a packet separated by "; "
+static void AppendRegister( std::stringstream& registers,
+                            const RFFERegisterMap& map,
+                            U8 slave_address,
+                            U16 address,
+                            U8 value,
+                            DisplayBase display_base )
+{
+    const RFFERegister* reg = map.Find( slave_address, address );
+    char register_str[256];
+
+    if ( reg == NULL )
+        return;
+    RFFERegisterMap::Describe( *reg, value, display_base, register_str, sizeof( register_str ) );
+    if ( registers.tellp() > 0 ) registers << "; ";
+    registers << register_str;
+}
+
+// An NDJSON record being formatted. Appending never allocates and stops at
+// the end of the buffer, which is far more than the longest packet needs.
+struct RFFEJsonRecord
+{
+    char mText[1024];
+    U32  mLength;
+
+    void Text( const char* text )
+    {
+        while ( *text != '\0' && mLength < sizeof( mText ) )
+        {
+            mText[mLength++] = *text++;
+        }
+    }
+
+    void Number( U64 value )
+    {
+        char digits[20];
+        U32 count = 0;
+
+        do
+        {
+            digits[count++] = char( '0' + value % 10 );
+            value /= 10;
+        } while ( value != 0 );
+        while ( count != 0 && mLength < sizeof( mText ) )
+        {
+            mText[mLength++] = digits[--count];
+        }
+    }
+
+    void Signed( S64 value )
+    {
+        if ( value < 0 )
+        {
+            Text( "-" );
+            Number( U64( 0 ) - U64( value ) );
+        }
+        else
+        {
+            Number( U64( value ) );
+        }
+    }
+
+    // error codes go into an array, comma separated
+    void Error( const char* code, bool* first )
+    {
+        Text( *first ? "\"" : ",\"" );
+        Text( code );
+        Text( "\"" );
+        *first = false;
+    }
+};
+
+// samples relative to the trigger in ns, without overflow for long captures
+static S64 GetNanoseconds( U64 sample, U64 trigger_sample, U32 sample_rate )
+{
+    U64 delta = sample >= trigger_sample ? sample - trigger_sample : trigger_sample - sample;
+    U64 ns = delta / sample_rate * 1000000000ULL + ( delta % sample_rate ) * 1000000000ULL / sample_rate;
+
+    return sample >= trigger_sample ? S64( ns ) : -S64( ns );
+}
+
+// a signed integer as decimal text, without going through a stream
+static void GetIntegerString( S64 value, char* text, U32 size )
+{
+    char digits[24];
+    U32 n = 0;
+    U64 magnitude = value < 0 ? U64( 0 ) - U64( value ) : U64( value );
+
+    do
+    {
+        digits[n++] = char( '0' + magnitude % 10 );
+        magnitude /= 10;
+    } while ( magnitude != 0 );
+    if ( value < 0 )
+        digits[n++] = '-';
+
+    U32 length = std::min( n, size - 1 );
+    for ( U32 i = 0; i < length; i++ )
+        text[i] = digits[n - 1 - i];
+    text[length] = 0;
+}
+
+// sample relative to reference in the export time unit, exact for samples
+// and nanoseconds
+static void GetExportTimeString( U64 sample, U64 reference, U32 export_time, U32 sample_rate, char* text, U32 size )
+{
+    switch ( export_time )
+    {
+    case RFFEAnalyzerSettings::ExportTimeSamples:
+        GetIntegerString( sample >= reference ? S64( sample - reference ) : -S64( reference - sample ), text, size );
+        break;
+    case RFFEAnalyzerSettings::ExportTimeNanoseconds:
+        GetIntegerString( GetNanoseconds( sample, reference, sample_rate ), text, size );
+        break;
+    default:
+        AnalyzerHelpers::GetTimeString( sample, reference, sample_rate, text, size );
+        break;
+    }
+}
+
+// An export row and the identical packets it stands for
+struct RFFEExportRow
+{
+    std::string mTime;      // time and delta columns of the first packet
+    std::string mPacketId;
+    std::string mFields;    // bus to payload, equal for repeats
+    U64 mFirstPacket;
+    U64 mLastPacket;
+    U64 mFirstSample;
+    U64 mLastSample;
+    U64 mCount;
+    U64 mMinInterval;       // SSC to SSC, U64( -1 ) while there is none
+    U64 mMaxInterval;
+};
+
+static void WriteExportRow( RFFEExportFile& out,
+                            std::stringstream& ss,
+                            const RFFEExportRow& row,
+                            bool repeats,
+                            U32 export_time,
+                            U64 trigger_sample,
+                            U32 sample_rate )
+{
+    char time_str[32];
+    U64 origin = export_time == RFFEAnalyzerSettings::ExportTimeSamples ? 0 : trigger_sample;
+
+    ss << row.mTime << "," << row.mPacketId << "," << row.mFields;
+    if ( repeats )
+    {
+        ss << "," << row.mCount << ",";
+        if ( row.mCount > 1 )
+        {
+            GetExportTimeString( row.mLastSample, origin, export_time, sample_rate, time_str, sizeof( time_str ) );
+            ss << time_str << ",";
+            GetExportTimeString( row.mMinInterval, 0, export_time, sample_rate, time_str, sizeof( time_str ) );
+            ss << time_str << ",";
+            GetExportTimeString( row.mMaxInterval, 0, export_time, sample_rate, time_str, sizeof( time_str ) );
+            ss << time_str;
+        }
+        else
+        {
+            ss << ",,";
+        }
+    }
+    ss << std::endl;
+    out.Write( ss.str(), row.mFirstPacket, row.mLastPacket, row.mFirstSample, row.mLastSample );
+    ss.str( std::string() );
+}
+
 
 RFFEAnalyzerResults::RFFEAnalyzerResults( RFFEAnalyzer* analyzer, RFFEAnalyzerSettings* settings )
 :	AnalyzerResults(),
@@ -41,18 +311,116 @@ RFFEAnalyzerResults::~RFFEAnalyzerResults()
 {
 }
 
-void RFFEAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base )
+const char* RFFEAnalyzerResults::GetTypeString( U64 type )
+{
+    return RffeTypeStringMid[type];
+}
+
+const char* RFFEAnalyzerResults::GetTypeStringShort( U64 type )
+{
+    return RffeTypeStringShort[type];
+}
+
+U64 RFFEAnalyzerResults::GetSummaryHeader( const RFFEPacket& packet )
+{
+    return U64( packet.mAddress ) |
+           U64( packet.mSlaveAddress & 0x0F ) << 16 |
+           U64( packet.mType & 0x07 ) << 20 |
+           U64( packet.mType & 0x08 ) << 26 |
+           U64( packet.mParityErrors & 1 ) << 23 |
+           U64( packet.mByteCount & 0x1F ) << 24 |
+           U64( packet.mParity & 0xFFFFFF ) << 32 |
+           U64( packet.mCommand ) << 56;
+}
+
+// up to 8 payload bytes from first on, the first one in the low byte
+U64 RFFEAnalyzerResults::GetSummaryBytes( const RFFEPacket& packet, U32 first )
+{
+    U64 bytes = 0;
+
+    for ( U32 i = first; i < packet.mByteCount && i < first + 8; i++ )
+    {
+        bytes |= U64( packet.mData[i] ) << ( 8 * ( i - first ) );
+    }
+    return bytes;
+}
+
+// the register an address or data frame refers to, if the map has it
+const RFFERegister* RFFEAnalyzerResults::FindRegister( U64 frame_index, const Frame& frame )
 {
-    channel = channel;
+    const RFFERegisterMap& map = mSettings->mRegisterMap;
+    U8 sa = RFFE_FRAME_SA( frame.mFlags );
 
+    if ( map.IsEmpty() )
+    {
+        return NULL;
+    }
+
+    switch( frame.mType )
+    {
+    case RffeShortAddressField:
+        return map.Find( sa, U16( frame.mData1 ) );
+    case RffeAddressField:
+        if ( frame.mData2 == RffeAddressNormalField )
+        {
+            return map.Find( sa, U16( frame.mData1 ) );
+        }
+        // the high byte is two frames back, before its parity bit
+        if ( frame.mData2 == RffeAddressLoField && frame_index >= 2 )
+        {
+            Frame high = GetFrame( frame_index - 2 );
+            if ( high.mType == RffeAddressField && high.mData2 == RffeAddressHiField )
+            {
+                return map.Find( sa, U16( high.mData1 << 8 | frame.mData1 ) );
+            }
+        }
+        return NULL;
+    case RffeShortDataField:
+        return map.Find( sa, 0 );
+    case RffeDataField:
+        return map.Find( sa, U16( frame.mData2 ) );
+    default:
+        return NULL;
+    }
+}
+
+void RFFEAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base )
+{
 	ClearResultStrings();
 	Frame frame = GetFrame( frame_index );
+    const RFFERegister* reg;
+    char register_str[256];
+
+    // with several buses every frame only gets a bubble on its own SDATA
+    if ( mSettings->IsMultiBus() &&
+         channel != mSettings->GetSdataChannel( frame.mFlags & RFFE_FRAME_BUS_MASK ) )
+    {
+        return;
+    }
+
+    reg = FindRegister( frame_index, frame );
 
     switch( frame.mType )
     {
     case RffeSSCField:
         {
             AddResultString( "SSC" );
+
+            // measured SCLK frequency and timing violations of the packet
+            if ( frame.mData1 != 0 )
+            {
+		        std::stringstream ss;
+
+                ss << "SSC " << std::fixed << std::setprecision( 2 ) << frame.mData1 / 1e6 << "MHz";
+		        AddResultString( ss.str().c_str() );
+                if ( frame.mData2 & RFFETiming::ViolationSclkFrequency ) ss << " !SCLK";
+                if ( frame.mData2 & RFFETiming::ViolationSetup )         ss << " !setup";
+                if ( frame.mData2 & RFFETiming::ViolationHold )          ss << " !hold";
+                if ( frame.mData2 != 0 )
+                {
+		            AddResultString( ss.str().c_str() );
+                }
+            }
         }
         break;
 
@@ -117,6 +485,11 @@ void RFFEAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel,
 
 		    ss << "A:" << number_str;
 		    AddResultString( ss.str().c_str() );
+            if ( reg != NULL )
+            {
+                ss << " " << reg->mName;
+		        AddResultString( ss.str().c_str() );
+            }
         }
         break;
 
@@ -148,6 +521,11 @@ void RFFEAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel,
 		        ss << "A:" << number_str;
 		        AddResultString( ss.str().c_str() );
             }
+            if ( reg != NULL )
+            {
+                ss << " " << reg->mName;
+		        AddResultString( ss.str().c_str() );
+            }
         }
         break;
 
@@ -162,6 +540,18 @@ void RFFEAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel,
 
 		    ss << "D:" << number_str;
 		    AddResultString( ss.str().c_str() );
+            if ( reg != NULL )
+            {
+                ss << " " << reg->mName;
+		        AddResultString( ss.str().c_str() );
+                if ( reg->mFieldCount != 0 )
+                {
+                    RFFERegisterMap::Describe( *reg, U8( frame.mData1 ), display_base, register_str, sizeof( register_str ) );
+                    ss.str( "" );
+                    ss << "D:" << number_str << " " << register_str;
+		            AddResultString( ss.str().c_str() );
+                }
+            }
         }
         break;
 
@@ -176,6 +566,32 @@ void RFFEAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel,
 
 		    ss << "D:" << number_str;
 		    AddResultString( ss.str().c_str() );
+            if ( reg != NULL )
+            {
+                ss << " " << reg->mName;
+		        AddResultString( ss.str().c_str() );
+                if ( reg->mFieldCount != 0 )
+                {
+                    RFFERegisterMap::Describe( *reg, U8( frame.mData1 ), display_base, register_str, sizeof( register_str ) );
+                    ss.str( "" );
+                    ss << "D:" << number_str << " " << register_str;
+		            AddResultString( ss.str().c_str() );
+                }
+            }
+        }
+        break;
+
+    case RffeMaskField:
+        {
+            char number_str[8];
+		    std::stringstream ss;
+
+		    AnalyzerHelpers::GetNumberString( frame.mData1, display_base, 8, number_str, 8 );
+
+            AddResultString( "M" );
+
+		    ss << "M:" << number_str;
+		    AddResultString( ss.str().c_str() );
         }
         break;
 
@@ -200,6 +616,103 @@ void RFFEAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel,
         }
         break;
 
+    case RffeSummaryField:
+        {
+            U8 type = SUMMARY_TYPE( frame.mData1 );
+            U32 address_bits = GetAddressBits( type );
+            U32 count = SUMMARY_BYTE_COUNT( frame.mData1 );
+            char number_str[20];
+		    std::stringstream ss;
+
+            // "SA5 ELW 0x5A94 x8", from short to long
+            ss << "SA" << U32( SUMMARY_SA( frame.mData1 ) );
+		    AddResultString( ss.str().c_str() );
+            ss << " " << RffeTypeStringShort[type];
+		    AddResultString( ss.str().c_str() );
+            if ( address_bits != 0 )
+            {
+		        AnalyzerHelpers::GetNumberString( SUMMARY_ADDRESS( frame.mData1 ), display_base, address_bits, number_str, 20 );
+                ss << " " << number_str;
+		        AddResultString( ss.str().c_str() );
+
+                reg = mSettings->mRegisterMap.Find( SUMMARY_SA( frame.mData1 ), SUMMARY_ADDRESS( frame.mData1 ) );
+                if ( reg != NULL )
+                {
+                    ss << " " << reg->mName;
+		            AddResultString( ss.str().c_str() );
+                }
+            }
+            if ( count != 0 )
+            {
+                ss << " x" << count;
+		        AddResultString( ss.str().c_str() );
+                ss << ":";
+                for ( U32 i = 0; i < count && i < 8; i++ )
+                {
+		            AnalyzerHelpers::GetNumberString( ( frame.mData2 >> ( 8 * i ) ) & 0xFF, display_base,
+                                                      type == RffeTypeShortWrite ? 7 : 8, number_str, 20 );
+                    ss << " " << number_str;
+                }
+		        AddResultString( ss.str().c_str() );
+            }
+        }
+        break;
+
+    case RffeSummaryDataField:
+        {
+            char number_str[20];
+		    std::stringstream ss;
+
+            AddResultString( "D" );
+
+            ss << "D:";
+            for ( U32 i = 0; i < frame.mData2; i++ )
+            {
+		        AnalyzerHelpers::GetNumberString( ( frame.mData1 >> ( 8 * i ) ) & 0xFF, display_base, 8, number_str, 20 );
+                ss << " " << number_str;
+            }
+		    AddResultString( ss.str().c_str() );
+        }
+        break;
+
+    case RffeRepeatField:
+        {
+            double ms_per_sample = 1e3 / mAnalyzer->GetSampleRate();
+		    std::stringstream ss;
+
+            AddResultString( "R" );
+
+            // the packets of the run, the first one included, as in the exports
+            ss << "x" << 1 + RFFE_REPEAT_COUNT( frame );
+		    AddResultString( ss.str().c_str() );
+            ss.str( "" );
+            ss << 1 + RFFE_REPEAT_COUNT( frame ) << " packets";
+		    AddResultString( ss.str().c_str() );
+            ss << " every " << std::fixed << std::setprecision( 3 )
+               << RFFE_REPEAT_MIN_INTERVAL( frame ) * ms_per_sample << "-"
+               << RFFE_REPEAT_MAX_INTERVAL( frame ) * ms_per_sample << " ms";
+		    AddResultString( ss.str().c_str() );
+        }
+        break;
+
+    case RffeEventField:
+        {
+            std::stringstream ss;
+
+            AddResultString( "Ev" );
+            if ( frame.mData1 == RFFE_EVENT_MISSED )
+            {
+                AddResultString( "no event" );
+                break;
+            }
+            ss << "+" << std::fixed << std::setprecision( 3 ) << frame.mData1 * 1e6 / mAnalyzer->GetSampleRate() << " us";
+		    AddResultString( ss.str().c_str() );
+            ss.str( "" );
+            ss << "event +" << std::fixed << std::setprecision( 3 ) << frame.mData1 * 1e6 / mAnalyzer->GetSampleRate() << " us";
+		    AddResultString( ss.str().c_str() );
+        }
+        break;
+
     case RffeErrorCaseField:
     default:
         {
@@ -219,15 +732,103 @@ void RFFEAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel,
     }
 }
 
-void RFFEAnalyzerResults::GenerateExportFile( const char* file,
-                                              DisplayBase display_base,
-                                              U32 export_type_user_id )
+// One row per packet (or per run of identical packets with export 1):
+// time, packet ID, bus, SA, type, address, byte count and payload
+class RFFEAnalyzerResults::CsvExporter : public RFFEExporter
+{
+public:
+    CsvExporter( RFFEAnalyzerResults* results, const char* file, DisplayBase display_base, bool collapse );
+
+    virtual void Add( U64 packet_id );
+    virtual void Finish();
+
+protected:
+    RFFEAnalyzerResults* mResults;
+    RFFEExportFile mOut;
+    DisplayBase mDisplayBase;
+    bool mShowParity;
+    bool mShowBusPark;
+    bool mCollapse;
+    bool mRepeats;
+    U64 mTriggerSample;
+    U32 mSampleRate;
+    bool mMultiBus;
+    const RFFERegisterMap& mMap;
+    bool mAnnotate;
+    bool mEvents;
+    U32 mExportTime;
+    bool mDeltas;
+    U64 mOrigin;
+    U64 mPreviousSample;
+    U64 mPreviousSaSample[RFFE_MAX_BUSES][16];
+
+    // of the last packet that had them
+    U32 mBus;
+    U8 mSlaveAddress;
+    U64 mSummaryHeader;
+    U8 mSummaryData[16];
+
+    std::stringstream mPayload;
+    std::stringstream mRegisters;
+    std::stringstream mFieldText;
+    std::stringstream mText;
+    RFFEExportRow mNext;
+    RFFEExportRow mRow;
+    bool mRowPending;
+};
+
+RFFEAnalyzerResults::CsvExporter::CsvExporter( RFFEAnalyzerResults* results, const char* file,
+                                               DisplayBase display_base, bool collapse )
+:   mResults( results ),
+    mOut( file, U64( results->mSettings->mExportChunkMB ) << 20, false ),
+    mDisplayBase( display_base ),
+    mShowParity( results->mSettings->mShowParityInReport ),
+    mShowBusPark( results->mSettings->mShowBusParkInReport ),
+    mCollapse( collapse ),
+    mRepeats( collapse || results->mSettings->mCollapseRepeats ),
+    mTriggerSample( results->mAnalyzer->GetTriggerSample() ),
+    mSampleRate( results->mAnalyzer->GetSampleRate() ),
+    mMultiBus( results->mSettings->IsMultiBus() ),
+    mMap( results->mSettings->mRegisterMap ),
+    mAnnotate( !results->mSettings->mRegisterMap.IsEmpty() ),
+    mEvents( results->mSettings->mEventChannel != UNDEFINED_CHANNEL ),
+    mExportTime( results->mSettings->mExportTime ),
+    mDeltas( results->mSettings->mExportDeltas ),
+    mPreviousSample( U64( -1 ) ),
+    mBus( 0 ),
+    mSlaveAddress( 0 ),
+    mSummaryHeader( 0 ),
+    mRowPending( false )
+{
+    // either CSV export shows the repeats the decoder collapsed; packet
+    // times are exact integers unless exported as seconds; deltas go from
+    // the SSC of the previous packet (its last repeat) on any SA and on the
+    // same bus and SA
+    mOrigin = mExportTime == RFFEAnalyzerSettings::ExportTimeSamples ? 0 : mTriggerSample;
+    std::fill( &mPreviousSaSample[0][0], &mPreviousSaSample[0][0] + RFFE_MAX_BUSES * 16, U64( -1 ) );
+    const char* unit = mExportTime == RFFEAnalyzerSettings::ExportTimeSamples ? " [samples]" :
+                       mExportTime == RFFEAnalyzerSettings::ExportTimeNanoseconds ? " [ns]" : " [s]";
+
+	mText << "Time" << unit << ",";
+    if ( mDeltas ) mText << "Delta" << unit << ",SA Delta" << unit << ",";
+    mText << "Packet ID,";
+    if ( mMultiBus ) mText << "Bus,";
+    mText << "SSC,SA,Type,Adr,BC,Payload";
+    if ( mAnnotate ) mText << ",Registers";
+    if ( mEvents ) mText << ",Event Delay" << unit;
+    if ( mRepeats ) mText << ",Count,Last" << unit << ",Min Interval" << unit << ",Max Interval" << unit;
+    mText << std::endl;
+    mOut.SetHeader( mText.str() );
+    mText.str( std::string() );
+}
+
+void RFFEAnalyzerResults::CsvExporter::Add( U64 packet_id )
 {
     U64 first_frame_id;
     U64 last_frame_id;
     U64 address;
-	char time_str[16];
-    char packet_str[16];
+	char time_str[32];
+    char packet_str[24];
     char sa_str[8];
     char type_str[16];
     char addr_str[16];
@@ -235,202 +836,699 @@ void RFFEAnalyzerResults::GenerateExportFile( const char* file,
     char parityCmd_str[8];
     char bc_str[8];
     char data_str[8];
-    bool show_parity = mSettings->mShowParityInReport;
-    bool show_buspark = mSettings->mShowBusParkInReport;
-    std::stringstream payload;
-    std::stringstream ss;
-    Frame frame;
-	void* f = AnalyzerHelpers::StartFile( file );
-
-    export_type_user_id = export_type_user_id;
+    bool summary;
+    U64 event_delay;
+
+    // package id
+	AnalyzerHelpers::GetNumberString( packet_id, Decimal, 0, packet_str, sizeof( packet_str ) );
+
+    mPayload.str( std::string() );
+    mRegisters.str( std::string() );
+    sprintf_s( sa_str, 8, "" );
+    sprintf_s( type_str, 8, "" );
+    sprintf_s( addr_str, 8, "" );
+    sprintf_s( parity_str, 8, "" );
+    sprintf_s( parityCmd_str, 8, "" );
+    sprintf_s( bc_str, 8, "" );
+    sprintf_s( data_str, 8, "" );
+    address = 0xFFFFFFFF;
+    summary = false;
+    event_delay = RFFE_NO_EVENT_DELAY;
+    mNext.mFirstPacket = packet_id;
+    mNext.mLastPacket  = packet_id;
+    mNext.mFirstSample = 0;
+    mNext.mCount       = 1;
+    mNext.mMinInterval = U64( -1 );
+    mNext.mMaxInterval = 0;
+
+	mResults->GetFramesContainedInPacket( packet_id, &first_frame_id, &last_frame_id );
+    for ( U64 j = first_frame_id; j <= last_frame_id; j++ )
+    {
+		Frame frame = mResults->GetFrame( j );
 
-	U64 trigger_sample  = mAnalyzer->GetTriggerSample();
-	U32 sample_rate     = mAnalyzer->GetSampleRate();
+        switch( frame.mType )
+        {
+        case RffeSSCField:
+            mBus = frame.mFlags & RFFE_FRAME_BUS_MASK;
+            mNext.mFirstSample = frame.mStartingSampleInclusive;
+            break;
+
+        case RffeSAField:
+            mSlaveAddress = U8( frame.mData1 );
+	        AnalyzerHelpers::GetNumberString( frame.mData1, 
+                                              mDisplayBase,
+                                              4,
+                                              sa_str,
+                                              8 );
+            break;
 
-	ss << "Time [s],Packet ID,SSC,SA,Type,Adr,BC,Payload" << std::endl;
+        case RffeTypeField:
+            sprintf_s( type_str, sizeof(type_str), "%s", RffeTypeStringMid[frame.mData1] );
+            break;
 
-	U64 num_packets = GetNumPackets();
-	for( U32 i = 0; i < num_packets; i++ )
-	{
-        // package id
-		AnalyzerHelpers::GetNumberString( i, Decimal, 0, packet_str, 16 );
+        case RffeExByteCountField:
+	        AnalyzerHelpers::GetNumberString( frame.mData1,
+                                              mDisplayBase,
+                                              4,
+                                              bc_str,
+                                              8 );
+            break;
 
-        payload.str( std::string() );
-        sprintf_s( sa_str, 8, "" );
-        sprintf_s( type_str, 8, "" );
-        sprintf_s( addr_str, 8, "" );
-        sprintf_s( parity_str, 8, "" );
-        sprintf_s( parityCmd_str, 8, "" );
-        sprintf_s( bc_str, 8, "" );
-        sprintf_s( data_str, 8, "" );
-        address = 0xFFFFFFFF;
+        case RffeExLongByteCountField:
+	        AnalyzerHelpers::GetNumberString( frame.mData1,
+                                              mDisplayBase,
+                                              3,
+                                              bc_str,
+                                              8 );
+            break;
 
-		GetFramesContainedInPacket( i, &first_frame_id, &last_frame_id );
-        for ( U64 j = first_frame_id; j <= last_frame_id; j++ )
-        {
-    		frame = GetFrame( j );
+        case RffeShortAddressField:
+            address = frame.mData1;
+            break;
 
-            switch( frame.mType )
+        case RffeAddressField:
+            switch( frame.mData2 )
             {
-            case RffeSSCField:
-                // starting time using SSC as marker
-		        AnalyzerHelpers::GetTimeString( frame.mStartingSampleInclusive,
-                                                trigger_sample,
-                                                sample_rate,
-                                                time_str,
-                                                16 );
+            case RffeAddressHiField:
+                address = (frame.mData1<<8);
                 break;
-
-            case RffeSAField:
-		        AnalyzerHelpers::GetNumberString( frame.mData1, 
-                                                  display_base,
-                                                  4,
-                                                  sa_str,
-                                                  8 );
+            case RffeAddressLoField:
+                address |= frame.mData1;
                 break;
-
-            case RffeTypeField:
-                sprintf_s( type_str, sizeof(type_str), "%s", RffeTypeStringMid[frame.mData1] );
+            case RffeAddressNormalField:
+            default:
+                address = frame.mData1;
                 break;
+            }
+            break;
+
+        case RffeShortDataField:
+	        AnalyzerHelpers::GetNumberString( frame.mData1,
+                                              mDisplayBase,
+                                              7,
+                                              data_str,
+                                              8 );
+	        mPayload << data_str << " ";
+            if ( mAnnotate ) AppendRegister( mRegisters, mMap, mSlaveAddress, 0, U8( frame.mData1 ), mDisplayBase );
+            break;
+
+        case RffeDataField:
+	        AnalyzerHelpers::GetNumberString( frame.mData1,
+                mDisplayBase,
+                8,
+                data_str,
+                8 );
+	        mPayload << data_str << " ";
+            if ( mAnnotate ) AppendRegister( mRegisters, mMap, mSlaveAddress, U16( frame.mData2 ), U8( frame.mData1 ), mDisplayBase );
+            break;
+
+        case RffeMaskField:
+	        AnalyzerHelpers::GetNumberString( frame.mData1,
+                mDisplayBase,
+                8,
+                data_str,
+                8 );
+	        mPayload << "M:" << data_str << " ";
+            break;
+
+        case RffeParityField:
+            if ( ! mShowParity ) break;
+            if ( ( frame.mData2 & RFFE_PARITY_COMMAND ) == 0 )
+            {
+	            AnalyzerHelpers::GetNumberString( frame.mData1,
+                    Decimal,
+                    1,
+                    parity_str,
+                    4 );
+		        mPayload << "P" << parity_str << " ";
+            }
+            else
+            {
+	            AnalyzerHelpers::GetNumberString( frame.mData1,
+                    Decimal,
+                    1,
+                    parityCmd_str,
+                    4 );
+            }
+            break;
+
+        case RffeBusParkField:
+            if( ! mShowBusPark ) break;
 
-            case RffeExByteCountField:
-		        AnalyzerHelpers::GetNumberString( frame.mData1,
-                                                  display_base,
+            mPayload << "BP ";
+            break;
+
+        case RffeErrorCaseField:
+        default:
+            char number1_str[20];
+            char number2_str[20];
+
+	        AnalyzerHelpers::GetNumberString( frame.mData1,
+                Hexadecimal,
+                32, 
+                number1_str,
+                10 );
+	        AnalyzerHelpers::GetNumberString( frame.mData2,
+                Hexadecimal,
+                32,
+                number2_str,
+                10 );
+	        mPayload << "E:" << number1_str << " - " << number2_str << " ";
+            break;
+
+        case RffeSummaryField:
+            mBus = frame.mFlags & RFFE_FRAME_BUS_MASK;
+            summary = true;
+            mSummaryHeader = frame.mData1;
+            mNext.mFirstSample = frame.mStartingSampleInclusive;
+            mSlaveAddress = SUMMARY_SA( mSummaryHeader );
+            for ( U32 k = 0; k < 8; k++ )
+            {
+                mSummaryData[k] = U8( frame.mData2 >> ( 8 * k ) );
+            }
+
+	        AnalyzerHelpers::GetNumberString( SUMMARY_SA( mSummaryHeader ),
+                                              mDisplayBase,
+                                              4,
+                                              sa_str,
+                                              8 );
+            sprintf_s( type_str, sizeof(type_str), "%s", RffeTypeStringMid[SUMMARY_TYPE( mSummaryHeader )] );
+	        AnalyzerHelpers::GetNumberString( SUMMARY_PARITY( mSummaryHeader ) & 1,
+                                              Decimal,
+                                              1,
+                                              parityCmd_str,
+                                              4 );
+
+            // the byte count field holds the number of bytes less one
+            switch( SUMMARY_TYPE( mSummaryHeader ) )
+            {
+            case RffeTypeExtWrite:
+            case RffeTypeExtRead:
+	            AnalyzerHelpers::GetNumberString( SUMMARY_BYTE_COUNT( mSummaryHeader ) - 1,
+                                                  mDisplayBase,
                                                   4,
                                                   bc_str,
                                                   8 );
+                address = SUMMARY_ADDRESS( mSummaryHeader );
                 break;
-
-            case RffeExLongByteCountField:
-		        AnalyzerHelpers::GetNumberString( frame.mData1,
-                                                  display_base,
+            case RffeTypeExtLongWrite:
+            case RffeTypeExtLongRead:
+	            AnalyzerHelpers::GetNumberString( SUMMARY_BYTE_COUNT( mSummaryHeader ) - 1,
+                                                  mDisplayBase,
                                                   3,
                                                   bc_str,
                                                   8 );
+                address = SUMMARY_ADDRESS( mSummaryHeader );
                 break;
-
-            case RffeShortAddressField:
-                address = frame.mData1;
+            case RffeTypeNormalWrite:
+            case RffeTypeNormalRead:
+            case RffeTypeMaskedWrite:
+                address = SUMMARY_ADDRESS( mSummaryHeader );
                 break;
+            }
+            break;
 
-            case RffeAddressField:
-                switch( frame.mData2 )
-                {
-                case RffeAddressHiField:
-                    address = (frame.mData1<<8);
-                    break;
-                case RffeAddressLoField:
-                    address |= frame.mData1;
-                    break;
-                case RffeAddressNormalField:
-                default:
-                    address = frame.mData1;
-                    break;
-                }
-                break;
+        case RffeSummaryDataField:
+            for ( U32 k = 0; k < 8; k++ )
+            {
+                mSummaryData[8 + k] = U8( frame.mData1 >> ( 8 * k ) );
+            }
+            break;
+
+        case RffeEventField:
+            event_delay = frame.mData1;
+            break;
+
+        case RffeRepeatField:
+            mNext.mCount       = 1 + RFFE_REPEAT_COUNT( frame );
+            mNext.mLastSample  = RFFE_REPEAT_LAST( frame );
+            mNext.mMinInterval = RFFE_REPEAT_MIN_INTERVAL( frame );
+            mNext.mMaxInterval = RFFE_REPEAT_MAX_INTERVAL( frame );
+            break;
+        }
+    }
+    if ( summary )
+    {
+        AppendSummaryPayload( mPayload, mSummaryHeader, mSummaryData, mDisplayBase, mShowParity, mShowBusPark );
 
-            case RffeShortDataField:
-		        AnalyzerHelpers::GetNumberString( frame.mData1,
-                                                  display_base,
-                                                  7,
-                                                  data_str,
-                                                  8 );
-		        payload << data_str << " ";
-                break;
+        // payload bytes go to consecutive registers, Wr0 to register 0,
+        // the data of a masked write (after its mask) to its address
+        for ( U32 k = 0; mAnnotate && k < SUMMARY_BYTE_COUNT( mSummaryHeader ); k++ )
+        {
+            U16 register_address = SUMMARY_TYPE( mSummaryHeader ) == RffeTypeShortWrite ? 0 :
+                                   U16( SUMMARY_ADDRESS( mSummaryHeader ) + k );
+            if ( SUMMARY_TYPE( mSummaryHeader ) == RffeTypeMaskedWrite )
+            {
+                if ( k == 0 ) continue;
+                register_address = SUMMARY_ADDRESS( mSummaryHeader );
+            }
+            AppendRegister( mRegisters, mMap, SUMMARY_SA( mSummaryHeader ), register_address, mSummaryData[k], mDisplayBase );
+        }
+    }
 
-            case RffeDataField:
-		        AnalyzerHelpers::GetNumberString( frame.mData1,
-                    display_base,
-                    8,
-                    data_str,
-                    8 );
-		        payload << data_str << " ";
-                break;
+    mFieldText.str( std::string() );
+    if ( mMultiBus ) mFieldText << mBus << ",";
+    mFieldText << "SSC," << sa_str << "," << type_str;
 
-            case RffeParityField:
-                if ( ! show_parity ) break;
-                if ( frame.mData2 == 0 )
-                {
-		            AnalyzerHelpers::GetNumberString( frame.mData1,
-                        Decimal,
-                        1,
-                        parity_str,
-                        4 );
-    		        payload << "P" << parity_str << " ";
-                }
-                else
-                {
-		            AnalyzerHelpers::GetNumberString( frame.mData1,
-                        Decimal,
-                        1,
-                        parityCmd_str,
-                        4 );
-                }
-                break;
+    if ( address == 0xFFFFFFFF )
+    {
+        mFieldText << ",,," << mPayload.str().c_str();
+        if ( mShowParity ) mFieldText << " P" << parityCmd_str;
+    }
+    else
+    {
+	    AnalyzerHelpers::GetNumberString( address,
+                                          mDisplayBase,
+                                          8,
+                                          addr_str,
+                                          8 );
+
+        mFieldText << "," << addr_str;
+        if ( mShowParity )  mFieldText <<" P" << parityCmd_str;
+        mFieldText << "," << bc_str << "," << mPayload.str().c_str();
+    }
+    if ( mAnnotate ) mFieldText << "," << mRegisters.str();
+    if ( mEvents )
+    {
+        // "none" when no event edge followed, empty if not an event packet
+        mFieldText << ",";
+        if ( event_delay == RFFE_EVENT_MISSED )
+        {
+            mFieldText << "none";
+        }
+        else if ( event_delay != RFFE_NO_EVENT_DELAY )
+        {
+            GetExportTimeString( event_delay, 0, mExportTime, mSampleRate, time_str, sizeof( time_str ) );
+            mFieldText << time_str;
+        }
+    }
 
-            case RffeBusParkField:
-                if( ! show_buspark ) break;
+    if ( mNext.mCount == 1 )
+    {
+        mNext.mLastSample = mNext.mFirstSample;
+    }
 
-                payload << "BP ";
-                break;
+    // starting time using SSC as marker
+    GetExportTimeString( mNext.mFirstSample, mOrigin, mExportTime, mSampleRate, time_str, sizeof( time_str ) );
+    mNext.mTime = time_str;
+    if ( mDeltas )
+    {
+        U64& previous_sa = mPreviousSaSample[mBus][mSlaveAddress & 0x0F];
 
-            case RffeErrorCaseField:
-            default:
-                char number1_str[20];
-                char number2_str[20];
-
-		        AnalyzerHelpers::GetNumberString( frame.mData1,
-                    Hexadecimal,
-                    32, 
-                    number1_str,
-                    10 );
-		        AnalyzerHelpers::GetNumberString( frame.mData2,
-                    Hexadecimal,
-                    32,
-                    number2_str,
-                    10 );
-		        payload << "E:" << number1_str << " - " << number2_str << " ";
-                break;
-            }
+        mNext.mTime += ",";
+        if ( mPreviousSample != U64( -1 ) )
+        {
+            GetExportTimeString( mNext.mFirstSample, mPreviousSample, mExportTime, mSampleRate, time_str, sizeof( time_str ) );
+            mNext.mTime += time_str;
         }
+        mNext.mTime += ",";
+        if ( previous_sa != U64( -1 ) )
+        {
+            GetExportTimeString( mNext.mFirstSample, previous_sa, mExportTime, mSampleRate, time_str, sizeof( time_str ) );
+            mNext.mTime += time_str;
+        }
+        mPreviousSample = mNext.mLastSample;
+        previous_sa     = mNext.mLastSample;
+    }
+    mNext.mPacketId = packet_str;
+    mNext.mFields   = mFieldText.str();
 
-        ss << time_str << "," << packet_str << ",SSC," << sa_str << "," << type_str;
+    if ( mCollapse && mRowPending && mNext.mFields == mRow.mFields )
+    {
+        U64 interval = mNext.mFirstSample - mRow.mLastSample;
 
-        if ( address == 0xFFFFFFFF )
+        mRow.mMinInterval = std::min( std::min( mRow.mMinInterval, mNext.mMinInterval ), interval );
+        mRow.mMaxInterval = std::max( std::max( mRow.mMaxInterval, mNext.mMaxInterval ), interval );
+        mRow.mCount      += mNext.mCount;
+        mRow.mLastPacket  = mNext.mLastPacket;
+        mRow.mLastSample  = mNext.mLastSample;
+    }
+    else
+    {
+        if ( mRowPending )
         {
-            ss << ",,," << payload.str().c_str();
-            if ( show_parity ) ss << " P" << parityCmd_str;
+            WriteExportRow( mOut, mText, mRow, mRepeats, mExportTime, mTriggerSample, mSampleRate );
         }
-        else
+        mRow = mNext;
+        mRowPending = true;
+    }
+    if ( !mCollapse )
+    {
+        WriteExportRow( mOut, mText, mRow, mRepeats, mExportTime, mTriggerSample, mSampleRate );
+        mRowPending = false;
+    }
+}
+
+void RFFEAnalyzerResults::CsvExporter::Finish()
+{
+    if ( mRowPending )
+    {
+        WriteExportRow( mOut, mText, mRow, mRepeats, mExportTime, mTriggerSample, mSampleRate );
+        mRowPending = false;
+    }
+    mOut.Finish( mTriggerSample, mSampleRate );
+}
+
+// Reads a results packet back from its frames, field or summary frames
+// alike. Parity errors of address and data frames in a summary are found
+// again from the bits. The timing is only there when it was measured and
+// the packet committed as field frames.
+void RFFEAnalyzerResults::ReadPacket( U64 packet_id, RFFEPacket* packet, RFFEPacketExtras* extras )
+{
+    U64 first_frame_id;
+    U64 last_frame_id;
+    U64 header = 0;
+    bool summary = false;
+
+    memset( packet, 0, sizeof( *packet ) );
+    memset( extras, 0, sizeof( *extras ) );
+    packet->mEventDelay = RFFE_NO_EVENT_DELAY;
+
+    GetFramesContainedInPacket( packet_id, &first_frame_id, &last_frame_id );
+    for ( U64 j = first_frame_id; j <= last_frame_id; j++ )
+    {
+        Frame frame = GetFrame( j );
+
+        if ( frame.mType != RffeRepeatField && frame.mType != RffeEventField )
         {
-    	    AnalyzerHelpers::GetNumberString( address,
-                                              display_base,
-                                              8,
-                                              addr_str,
-                                              8 );
+            packet->mEndingSample = std::max( packet->mEndingSample, U64( frame.mEndingSampleInclusive ) );
+        }
+
+        switch( frame.mType )
+        {
+        case RffeSSCField:
+            packet->mBus              = U8( frame.mFlags & RFFE_FRAME_BUS_MASK );
+            packet->mStartingSample   = frame.mStartingSampleInclusive;
+            packet->mSclkFrequency    = U32( frame.mData1 );
+            packet->mTimingViolations = U8( frame.mData2 );
+            break;
+        case RffeSAField:
+            packet->mSlaveAddress = U8( frame.mData1 );
+            break;
+        case RffeTypeField:
+            packet->mType    = U8( frame.mData1 );
+            packet->mCommand = U8( frame.mData2 );
+            break;
+        case RffeShortAddressField:
+            packet->mAddress    = U16( frame.mData1 );
+            extras->mHasAddress = true;
+            break;
+        case RffeAddressField:
+            if ( frame.mData2 == RffeAddressLoField )
+                packet->mAddress = U16( packet->mAddress | frame.mData1 );
+            else if ( frame.mData2 == RffeAddressHiField )
+                packet->mAddress = U16( frame.mData1 << 8 );
+            else
+                packet->mAddress = U16( frame.mData1 );
+            extras->mHasAddress = true;
+            break;
+        case RffeShortDataField:
+        case RffeDataField:
+        case RffeMaskField:
+            if ( packet->mByteCount < sizeof( packet->mData ) )
+                packet->mData[packet->mByteCount++] = U8( frame.mData1 );
+            break;
+        case RffeParityField:
+            packet->mParity       |= U32( frame.mData1 & 1 ) << packet->mParityCount;
+            packet->mParityErrors |= U32( ( frame.mData2 & RFFE_PARITY_ERROR ) != 0 ) << packet->mParityCount;
+            packet->mParityCount++;
+            break;
+        case RffeSummaryField:
+            summary                   = true;
+            header                    = frame.mData1;
+            packet->mBus              = U8( frame.mFlags & RFFE_FRAME_BUS_MASK );
+            packet->mStartingSample   = frame.mStartingSampleInclusive;
+            packet->mSlaveAddress     = SUMMARY_SA( header );
+            packet->mType             = SUMMARY_TYPE( header );
+            packet->mCommand          = SUMMARY_COMMAND( header );
+            packet->mByteCount        = std::min< U8 >( SUMMARY_BYTE_COUNT( header ), 16 );
+            packet->mAddress          = SUMMARY_ADDRESS( header );
+            packet->mParity           = SUMMARY_PARITY( header );
+            extras->mHasAddress       = GetAddressBits( packet->mType ) != 0;
+            for ( U32 k = 0; k < 8; k++ )
+                packet->mData[k] = U8( frame.mData2 >> ( 8 * k ) );
+            break;
+        case RffeSummaryDataField:
+            for ( U32 k = 0; k < 8; k++ )
+                packet->mData[8 + k] = U8( frame.mData1 >> ( 8 * k ) );
+            break;
+        case RffeRepeatField:
+            extras->mRepeats     = RFFE_REPEAT_COUNT( frame );
+            extras->mLastStart   = RFFE_REPEAT_LAST( frame );
+            extras->mMinInterval = RFFE_REPEAT_MIN_INTERVAL( frame );
+            extras->mMaxInterval = RFFE_REPEAT_MAX_INTERVAL( frame );
+            break;
+        case RffeEventField:
+            packet->mEventDelay = frame.mData1;
+            break;
+        case RffeErrorCaseField:
+            extras->mErrorFrames++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if ( summary )
+    {
+        U32 address_frames = GetAddressBits( packet->mType ) / 8;
+        U32 n = 1;
 
-            ss << "," << addr_str;
-            if ( show_parity )  ss <<" P" << parityCmd_str;
-            ss << "," << bc_str << "," << payload.str().c_str();
+        packet->mParityErrors = SUMMARY_PARITY_ERROR( header );
+        for ( U32 k = 0; k < address_frames; k++, n++ )
+        {
+            U8 byte = U8( packet->mAddress >> ( 8 * ( address_frames - 1 - k ) ) );
+            if ( !RFFEUtil::isParityOk( byte, U8( packet->mParity >> n ) & 1 ) )
+                packet->mParityErrors |= 1 << n;
+        }
+        for ( U32 k = 0; packet->mType != RffeTypeShortWrite && k < packet->mByteCount; k++, n++ )
+        {
+            if ( !RFFEUtil::isParityOk( packet->mData[k], U8( packet->mParity >> n ) & 1 ) )
+                packet->mParityErrors |= 1 << n;
         }
-        ss << std::endl;
-        AnalyzerHelpers::AppendToFile( (U8*)ss.str().c_str(), (U32)ss.str().length(), f );
-        ss.str( std::string() );
+        packet->mParityCount = U8( n );
+        packet->mParity     &= ( 1 << n ) - 1;
+    }
+}
+
+// One JSON object per line and packet, with typed fields for log pipelines:
+// {"packet_id":0,"timestamp_ns":600,"sample":60,"end_sample":95,"bus":0,
+//  "sa":5,"type":"ExtWr","address":101,"byte_count":1,"payload":[1],
+//  "parity_ok":true,"errors":[]}
+// plus "sclk_hz" when the timing was measured, "event_delay_ns" for event
+// packets (null when no event edge followed) and "repeats" for collapsed
+// runs. The records are formatted in place, nothing is allocated per packet.
+class RFFEAnalyzerResults::NdjsonExporter : public RFFEExporter
+{
+public:
+    NdjsonExporter( RFFEAnalyzerResults* results, const char* file );
+
+    virtual void Add( U64 packet_id );
+    virtual void Finish();
+
+protected:
+    RFFEAnalyzerResults* mResults;
+    RFFEExportFile mOut;
+    RFFEJsonRecord mRecord;
+    U64 mTriggerSample;
+    U32 mSampleRate;
+};
+
+RFFEAnalyzerResults::NdjsonExporter::NdjsonExporter( RFFEAnalyzerResults* results, const char* file )
+:   mResults( results ),
+    mOut( file, U64( results->mSettings->mExportChunkMB ) << 20, false ),
+    mTriggerSample( results->mAnalyzer->GetTriggerSample() ),
+    mSampleRate( results->mAnalyzer->GetSampleRate() )
+{
+}
+
+void RFFEAnalyzerResults::NdjsonExporter::Add( U64 packet_id )
+{
+    RFFEPacket packet;
+    RFFEPacketExtras extras;
+    bool first = true;
+
+    mResults->ReadPacket( packet_id, &packet, &extras );
+    U32 address_frames = GetAddressBits( packet.mType ) / 8;
+
+    mRecord.mLength = 0;
+    mRecord.Text( "{\"packet_id\":" );
+    mRecord.Number( packet_id );
+    mRecord.Text( ",\"timestamp_ns\":" );
+    mRecord.Signed( GetNanoseconds( packet.mStartingSample, mTriggerSample, mSampleRate ) );
+    mRecord.Text( ",\"sample\":" );
+    mRecord.Number( packet.mStartingSample );
+    mRecord.Text( ",\"end_sample\":" );
+    mRecord.Number( packet.mEndingSample );
+    mRecord.Text( ",\"bus\":" );
+    mRecord.Number( packet.mBus );
+    mRecord.Text( ",\"sa\":" );
+    mRecord.Number( packet.mSlaveAddress );
+    mRecord.Text( ",\"type\":\"" );
+    mRecord.Text( RffeTypeStringMid[packet.mType] );
+    mRecord.Text( "\",\"address\":" );
+    if ( extras.mHasAddress )
+        mRecord.Number( packet.mAddress );
+    else
+        mRecord.Text( "null" );
+    mRecord.Text( ",\"byte_count\":" );
+    mRecord.Number( packet.mByteCount );
+    mRecord.Text( ",\"payload\":[" );
+    for ( U32 k = 0; k < packet.mByteCount; k++ )
+    {
+        if ( k != 0 ) mRecord.Text( "," );
+        mRecord.Number( packet.mData[k] );
+    }
+    mRecord.Text( "],\"parity_ok\":" );
+    mRecord.Text( packet.mParityErrors == 0 ? "true" : "false" );
+
+    mRecord.Text( ",\"errors\":[" );
+    // parity bits: command frame, address frames, data frames
+    if ( packet.mParityErrors & 1 )
+        mRecord.Error( "command_parity", &first );
+    if ( packet.mParityErrors & ( ( 1 << ( 1 + address_frames ) ) - 2 ) )
+        mRecord.Error( "address_parity", &first );
+    if ( packet.mParityErrors >> ( 1 + address_frames ) )
+        mRecord.Error( "data_parity", &first );
+    if ( packet.mTimingViolations & RFFETiming::ViolationSclkFrequency )
+        mRecord.Error( "sclk_frequency", &first );
+    if ( packet.mTimingViolations & RFFETiming::ViolationSetup )
+        mRecord.Error( "setup", &first );
+    if ( packet.mTimingViolations & RFFETiming::ViolationHold )
+        mRecord.Error( "hold", &first );
+    if ( extras.mErrorFrames != 0 )
+        mRecord.Error( "decode", &first );
+    mRecord.Text( "]" );
+
+    if ( packet.mSclkFrequency != 0 )
+    {
+        mRecord.Text( ",\"sclk_hz\":" );
+        mRecord.Number( packet.mSclkFrequency );
+    }
+    if ( packet.mEventDelay != RFFE_NO_EVENT_DELAY )
+    {
+        mRecord.Text( ",\"event_delay_ns\":" );
+        if ( packet.mEventDelay == RFFE_EVENT_MISSED )
+            mRecord.Text( "null" );
+        else
+            mRecord.Number( U64( GetNanoseconds( packet.mEventDelay, 0, mSampleRate ) ) );
+    }
+    if ( extras.mRepeats != 0 )
+    {
+        mRecord.Text( ",\"repeats\":{\"count\":" );
+        mRecord.Number( 1 + U64( extras.mRepeats ) );
+        mRecord.Text( ",\"last_sample\":" );
+        mRecord.Number( extras.mLastStart );
+        mRecord.Text( ",\"min_interval_ns\":" );
+        mRecord.Number( U64( GetNanoseconds( extras.mMinInterval, 0, mSampleRate ) ) );
+        mRecord.Text( ",\"max_interval_ns\":" );
+        mRecord.Number( U64( GetNanoseconds( extras.mMaxInterval, 0, mSampleRate ) ) );
+        mRecord.Text( "}" );
+    }
+    mRecord.Text( "}\n" );
+
+    mOut.Write( mRecord.mText, mRecord.mLength, packet_id, packet_id,
+                packet.mStartingSample, extras.mRepeats != 0 ? extras.mLastStart : packet.mStartingSample );
+}
+
+void RFFEAnalyzerResults::NdjsonExporter::Finish()
+{
+    mOut.Finish( mTriggerSample, mSampleRate );
+}
+
+// One enhanced packet block per packet, see RFFEPcapng.h for the payload.
+// Timestamps count from the start of the capture, pcapng has no negative ones.
+class RFFEAnalyzerResults::PcapngExporter : public RFFEExporter
+{
+public:
+    PcapngExporter( RFFEAnalyzerResults* results, const char* file );
+
+    virtual void Add( U64 packet_id );
+    virtual void Finish();
+
+protected:
+    RFFEAnalyzerResults* mResults;
+    RFFEPcapngWriter mOut;
+    U64 mTriggerSample;
+    U32 mSampleRate;
+};
+
+RFFEAnalyzerResults::PcapngExporter::PcapngExporter( RFFEAnalyzerResults* results, const char* file )
+:   mResults( results ),
+    mOut( file, U64( results->mSettings->mExportChunkMB ) << 20 ),
+    mTriggerSample( results->mAnalyzer->GetTriggerSample() ),
+    mSampleRate( results->mAnalyzer->GetSampleRate() )
+{
+}
+
+void RFFEAnalyzerResults::PcapngExporter::Add( U64 packet_id )
+{
+    RFFEPacket packet;
+    RFFEPacketExtras extras;
+
+    mResults->ReadPacket( packet_id, &packet, &extras );
+    mOut.Add( packet_id, packet, extras, U64( GetNanoseconds( packet.mStartingSample, 0, mSampleRate ) ) );
+}
+
+void RFFEAnalyzerResults::PcapngExporter::Finish()
+{
+    mOut.Finish( mTriggerSample, mSampleRate );
+}
+
+void RFFEAnalyzerResults::GenerateExportFile( const char* file,
+                                              DisplayBase display_base,
+                                              U32 export_type_user_id )
+{
+    std::unique_ptr< RFFEExporter > exporter( CreateExporter( file, display_base, export_type_user_id ) );
+
+	U64 num_packets = GetNumPackets();
+	for( U64 i = 0; i < num_packets; i++ )
+	{
+        exporter->Add( i );
 
 		if( UpdateExportProgressAndCheckForCancel( i, num_packets ) == true )
 		{
-			AnalyzerHelpers::EndFile( f );
-			return;
+			break;
 		}
     }
+    exporter->Finish();
+}
+
+RFFEExporter* RFFEAnalyzerResults::CreateExporter( const char* file, DisplayBase display_base, U32 export_type_user_id )
+{
+    if ( export_type_user_id == 2 )
+    {
+        return new NdjsonExporter( this, file );
+    }
+    if ( export_type_user_id == 3 )
+    {
+        return new PcapngExporter( this, file );
+    }
+    // export 1 merges runs of identical rows
+    return new CsvExporter( this, file, display_base, export_type_user_id == 1 );
 }
 
 void RFFEAnalyzerResults::GenerateFrameTabularText( U64 frame_index, DisplayBase display_base )
 {
-	//Frame frame = GetFrame( frame_index );
+	Frame frame = GetFrame( frame_index );
+    const RFFERegister* reg = FindRegister( frame_index, frame );
+    char register_str[256];
 
 	ClearTabularText();
-	//AddTabularText( "" );
+
+    // the register of an address or data frame, with its fields for data
+    if ( reg != NULL )
+    {
+        if ( frame.mType == RffeShortDataField || frame.mType == RffeDataField )
+        {
+            RFFERegisterMap::Describe( *reg, U8( frame.mData1 ), display_base, register_str, sizeof( register_str ) );
+	        AddTabularText( register_str );
+        }
+        else
+        {
+	        AddTabularText( reg->mName );
+        }
+    }
 }
 
 void RFFEAnalyzerResults::GeneratePacketTabularText( U64 packet_id, DisplayBase display_base )
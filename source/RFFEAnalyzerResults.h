@@ -2,10 +2,35 @@
 #define RFFE_ANALYZER_RESULTS
 
 #include <AnalyzerResults.h>
+#include "RFFEPacket.h"
+#include "RFFERegisterMap.h"
 
 class RFFEAnalyzer;
 class RFFEAnalyzerSettings;
 
+// What a results packet holds besides its RFFEPacket content
+struct RFFEPacketExtras
+{
+    bool mHasAddress;
+    U32 mErrorFrames;       // RffeErrorCaseField frames
+    U32 mRepeats;           // collapsed repeats after the packet
+    U64 mLastStart;         // SSC of the last repeat
+    U32 mMinInterval;
+    U32 mMaxInterval;
+};
+
+// An export written a packet at a time, in the order of the packets:
+// GenerateExportFile feeds it the finished results, rffe_decode every packet
+// as it is committed
+class RFFEExporter
+{
+public:
+    virtual ~RFFEExporter() {}
+
+    virtual void Add( U64 packet_id ) = 0;
+    virtual void Finish() = 0;
+};
+
 class RFFEAnalyzerResults : public AnalyzerResults
 {
 public:
@@ -19,21 +44,35 @@ public:
 	virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base );
 	virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base );
 
+    static const char* GetTypeString( U64 type );
+    static const char* GetTypeStringShort( U64 type );
+    static U64 GetSummaryHeader( const RFFEPacket& packet );
+    static U64 GetSummaryBytes( const RFFEPacket& packet, U32 first );
+    static U32 GetAddressBits( U8 type );   // width of the register address, 0 for none
+
+    void ReadPacket( U64 packet_id, RFFEPacket* packet, RFFEPacketExtras* extras );
+    RFFEExporter* CreateExporter( const char* file, DisplayBase display_base, U32 export_type_user_id );
+
 public:
     enum RffeFrameType
     { 
         RffeSSCField,
         RffeSAField,
-        RffeTypeField,
+        RffeTypeField,          // lower 8 bits of the command frame in mData2
         RffeExByteCountField,
         RffeExLongByteCountField,
         RffeShortAddressField,
         RffeAddressField,
         RffeShortDataField,
-        RffeDataField,
-        RffeParityField,
+        RffeDataField,          // register address in mData2
+        RffeParityField,        // RFFE_PARITY_* in mData2
         RffeBusParkField,
         RffeErrorCaseField,
+        RffeSummaryField,       // whole packet: header in mData1, bytes 0..7 in mData2
+        RffeSummaryDataField,   // rest of a longer payload: bytes 8..15 in mData1
+        RffeRepeatField,        // repeats of the packet, see RFFE_REPEAT_* below
+        RffeMaskField,          // mask of a masked write, register address in mData2
+        RffeEventField,         // event latency in samples in mData1 (RFFE_EVENT_MISSED), EventEdge in mData2
     };
     enum RffeTypeFieldType
     {
@@ -45,6 +84,7 @@ public:
         RffeTypeNormalWrite,
         RffeTypeNormalRead,
         RffeTypeShortWrite,
+        RffeTypeMaskedWrite,    // RFFE v2.x, decoded as reserved by v1.0
     };
     enum RffeAddressFieldSubType
     {
@@ -53,7 +93,24 @@ public:
         RffeAddressLoField,
     };
 
+#define RFFE_COMMAND_TYPES      9
+
+// RffeParityField: parity of the command frame, parity bit wrong
+#define RFFE_PARITY_COMMAND     0x01
+#define RFFE_PARITY_ERROR       0x02
+
+// RffeRepeatField: from the SSC of the first repeat to the end of the last
+#define RFFE_REPEAT_COUNT( frame )          U32( ( frame ).mData1 )
+#define RFFE_REPEAT_LAST( frame )           ( ( frame ).mStartingSampleInclusive + ( ( frame ).mData1 >> 32 ) )
+#define RFFE_REPEAT_MIN_INTERVAL( frame )   U32( ( frame ).mData2 )
+#define RFFE_REPEAT_MAX_INTERVAL( frame )   U32( ( frame ).mData2 >> 32 )
+
 protected: //functions
+    const RFFERegister* FindRegister( U64 frame_index, const Frame& frame );
+
+    class CsvExporter;
+    class NdjsonExporter;
+    class PcapngExporter;
 
 protected:  //vars
 	RFFEAnalyzerSettings* mSettings;
@@ -1,10 +1,237 @@
 #include "RFFEAnalyzerSettings.h"
+#include "RFFEAnalyzerResults.h"
 #include <AnalyzerHelpers.h>
+#include <ctype.h>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
 
+#define RFFE_ALL_SLAVE_ADDRESSES	0xFFFF
+#define RFFE_ALL_COMMAND_TYPES		0x1FF
+
+static bool IsListSeparator( char c )
+{
+	return c == ',' || c == ';' || c == ' ' || c == '\t';
+}
+
+// "0x5, 7, 0xA-0xC" -> mask of slave addresses, empty text selects all
+static bool ParseSlaveAddressFilter( const char* text, U32* mask )
+{
+	*mask = 0;
+	while( *text != '\0' )
+	{
+		if( IsListSeparator( *text ) )
+		{
+			text++;
+			continue;
+		}
+
+		char* end;
+		U32 first = U32( strtoul( text, &end, 0 ) );
+		U32 last = first;
+		if( end == text )
+			return false;
+		text = end;
+		if( *text == '-' )
+		{
+			last = U32( strtoul( ++text, &end, 0 ) );
+			if( end == text )
+				return false;
+			text = end;
+		}
+		if( last > 15 || first > last || ( *text != '\0' && !IsListSeparator( *text ) ) )
+			return false;
+		for( U32 sa = first; sa <= last; sa++ )
+			*mask |= 1 << sa;
+	}
+	if( *mask == 0 )
+		*mask = RFFE_ALL_SLAVE_ADDRESSES;
+	return true;
+}
+
+static bool MatchesName( const char* text, size_t len, const char* name )
+{
+	if( strlen( name ) != len )
+		return false;
+	for( size_t i = 0; i < len; i++ )
+	{
+		if( tolower( (unsigned char)text[i] ) != tolower( (unsigned char)name[i] ) )
+			return false;
+	}
+	return true;
+}
+
+// "ExtRd, ELW" -> mask of command types (short or long names), empty text selects all
+static bool ParseCommandTypeFilter( const char* text, U32* mask )
+{
+	*mask = 0;
+	while( *text != '\0' )
+	{
+		if( IsListSeparator( *text ) )
+		{
+			text++;
+			continue;
+		}
+
+		size_t len = 0;
+		while( text[len] != '\0' && !IsListSeparator( text[len] ) )
+			len++;
+
+		U32 type;
+		for( type = 0; type < RFFE_COMMAND_TYPES; type++ )
+		{
+			if( MatchesName( text, len, RFFEAnalyzerResults::GetTypeString( type ) ) ||
+			    MatchesName( text, len, RFFEAnalyzerResults::GetTypeStringShort( type ) ) )
+				break;
+		}
+		if( type == RFFE_COMMAND_TYPES )
+			return false;
+		*mask |= 1 << type;
+		text += len;
+	}
+	if( *mask == 0 )
+		*mask = RFFE_ALL_COMMAND_TYPES;
+	return true;
+}
+
+static std::string FormatSlaveAddressFilter( U32 mask )
+{
+	std::string text;
+	char number[8];
+
+	if( ( mask & RFFE_ALL_SLAVE_ADDRESSES ) == RFFE_ALL_SLAVE_ADDRESSES )
+		return text;
+	for( U32 sa = 0; sa < 16; sa++ )
+	{
+		if( ( mask & ( 1 << sa ) ) == 0 )
+			continue;
+		sprintf_s( number, sizeof( number ), "0x%X", sa );
+		if( !text.empty() )
+			text += ", ";
+		text += number;
+	}
+	return text;
+}
+
+static std::string FormatCommandTypeFilter( U32 mask )
+{
+	std::string text;
+
+	if( ( mask & RFFE_ALL_COMMAND_TYPES ) == RFFE_ALL_COMMAND_TYPES )
+		return text;
+	for( U32 type = 0; type < RFFE_COMMAND_TYPES; type++ )
+	{
+		if( ( mask & ( 1 << type ) ) == 0 )
+			continue;
+		if( !text.empty() )
+			text += ", ";
+		text += RFFEAnalyzerResults::GetTypeString( type );
+	}
+	return text;
+}
+
+// "0x5:0x1C, *:0x2D, 0x7" -> event packets, "*" or no address matches any;
+// empty text leaves the list empty (all packets)
+static bool ParseEventPackets( const char* text, std::vector< RFFEEventPacket >* packets )
+{
+	packets->clear();
+	while( *text != '\0' )
+	{
+		if( IsListSeparator( *text ) )
+		{
+			text++;
+			continue;
+		}
+
+		RFFEEventPacket packet;
+		char* end;
+		packet.mAnySlaveAddress = ( *text == '*' );
+		packet.mAnyAddress = true;
+		packet.mSlaveAddress = 0;
+		packet.mAddress = 0;
+		if( packet.mAnySlaveAddress )
+		{
+			text++;
+		}
+		else
+		{
+			U32 sa = U32( strtoul( text, &end, 0 ) );
+			if( end == text || sa > 15 )
+				return false;
+			packet.mSlaveAddress = U8( sa );
+			text = end;
+		}
+		if( *text == ':' )
+		{
+			text++;
+			if( *text == '*' )
+			{
+				text++;
+			}
+			else
+			{
+				U32 address = U32( strtoul( text, &end, 0 ) );
+				if( end == text || address > 0xFFFF )
+					return false;
+				packet.mAnyAddress = false;
+				packet.mAddress = U16( address );
+				text = end;
+			}
+		}
+		if( *text != '\0' && !IsListSeparator( *text ) )
+			return false;
+		packets->push_back( packet );
+	}
+	return true;
+}
+
+// a sample number or a time in seconds, empty text leaves the bound open
+static bool ParseRangeBound( const char* text, double* value, bool* is_set )
+{
+	char* end;
+
+	while( IsListSeparator( *text ) )
+		text++;
+	*is_set = ( *text != '\0' );
+	if( !*is_set )
+		return true;
+
+	*value = strtod( text, &end );
+	while( IsListSeparator( *end ) )
+		end++;
+	return end != text && *end == '\0';
+}
+
+static const char* BusSclkNames[RFFE_MAX_BUSES - 1] = { "SCLK bus 1", "SCLK bus 2", "SCLK bus 3" };
+static const char* BusSdataNames[RFFE_MAX_BUSES - 1] = { "SDATA bus 1", "SDATA bus 2", "SDATA bus 3" };
 
 RFFEAnalyzerSettings::RFFEAnalyzerSettings()
 :	mSclkChannel( UNDEFINED_CHANNEL ),
-    mSdataChannel( UNDEFINED_CHANNEL )
+    mSdataChannel( UNDEFINED_CHANNEL ),
+    mShowParityInReport( false ),
+    mShowBusParkInReport( false ),
+    mProtocolVersion( ProtocolV1 ),
+    mSimulationMode( SimulationCommandSweep ),
+    mSlaveAddressFilter( RFFE_ALL_SLAVE_ADDRESSES ),
+    mCommandTypeFilter( RFFE_ALL_COMMAND_TYPES ),
+    mDecodeRange( DecodeRangeAll ),
+    mBusSclkKHz( 0 ),
+    mDetectedSclkHz( 0 ),
+    mTimingAnalysis( false ),
+    mMaxSclkKHz( 26000 ),
+    mMaxReadSclkKHz( 13000 ),
+    mMinSetupNs( 1 ),
+    mMinHoldNs( 5 ),
+    mEventChannel( UNDEFINED_CHANNEL ),
+    mEventEdge( EventEdgeAny ),
+    mPipelined( false ),
+    mStreaming( false ),
+    mMaxLatencyMs( 10 ),
+    mSummaryFrames( false ),
+    mCollapseRepeats( false ),
+    mExportChunkMB( 0 ),
+    mExportTime( ExportTimeSeconds ),
+    mExportDeltas( false )
 {
 	mSclkChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
 	mSclkChannelInterface->SetTitleAndTooltip( "SCLK", "Specify the SCLK Signal(RFFEv1.0)" );
@@ -16,6 +243,35 @@ RFFEAnalyzerSettings::RFFEAnalyzerSettings()
 	mSdataChannelInterface->SetChannel( mSdataChannel );
 	AddInterface( mSdataChannelInterface.get() );
 
+	for( U32 i = 0; i < RFFE_MAX_BUSES - 1; i++ )
+	{
+		mBusSclkChannel[i] = UNDEFINED_CHANNEL;
+		mBusSdataChannel[i] = UNDEFINED_CHANNEL;
+
+		mBusSclkChannelInterface[i].reset( new AnalyzerSettingInterfaceChannel() );
+		mBusSclkChannelInterface[i]->SetTitleAndTooltip( BusSclkNames[i],
+			"SCLK of a further RFFE bus decoded in the same pass (optional)" );
+		mBusSclkChannelInterface[i]->SetChannel( mBusSclkChannel[i] );
+		mBusSclkChannelInterface[i]->SetSelectionOfNoneIsAllowed( true );
+		AddInterface( mBusSclkChannelInterface[i].get() );
+
+		mBusSdataChannelInterface[i].reset( new AnalyzerSettingInterfaceChannel() );
+		mBusSdataChannelInterface[i]->SetTitleAndTooltip( BusSdataNames[i],
+			"SDATA of a further RFFE bus decoded in the same pass (optional)" );
+		mBusSdataChannelInterface[i]->SetChannel( mBusSdataChannel[i] );
+		mBusSdataChannelInterface[i]->SetSelectionOfNoneIsAllowed( true );
+		AddInterface( mBusSdataChannelInterface[i].get() );
+	}
+
+	mProtocolVersionInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+	mProtocolVersionInterface->SetTitleAndTooltip( "Protocol Version",
+		"Command set of the devices on the bus" );
+	mProtocolVersionInterface->AddNumber( ProtocolV1, "RFFE v1.0", "Commands 0x10-0x1F are reserved" );
+	mProtocolVersionInterface->AddNumber( ProtocolV2, "RFFE v2.x masked write",
+		"Masked writes (0x19) are decoded, the other v2.x commands 0x10-0x1F are only stepped over to their bus park before the next SSC" );
+	mProtocolVersionInterface->SetNumber( mProtocolVersion );
+	AddInterface( mProtocolVersionInterface.get() );
+
 	mShowParityInReportInterface.reset( new AnalyzerSettingInterfaceBool() );
 	mShowParityInReportInterface->SetTitleAndTooltip("Show Parity in Report?",
 		"Check if you want parity information in the exported file" );
@@ -26,13 +282,215 @@ RFFEAnalyzerSettings::RFFEAnalyzerSettings()
 		"Check if you want bus park information in the exported file" );
 	AddInterface( mShowBusParkInReportInterface.get() );
 
+	mSimulationModeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+	mSimulationModeInterface->SetTitleAndTooltip( "Simulation Data",
+		"Kind of traffic produced when simulating this analyzer" );
+	mSimulationModeInterface->AddNumber( SimulationCommandSweep, "Command sweep",
+		"Every command type with fixed addresses and data" );
+	mSimulationModeInterface->AddNumber( SimulationRandomized, "Randomized (self-check)",
+		"Random packets, decoded packets are compared with the generated ones" );
+	mSimulationModeInterface->SetNumber( mSimulationMode );
+	AddInterface( mSimulationModeInterface.get() );
+
+	mSelfCheckReportFileInterface.reset( new AnalyzerSettingInterfaceText() );
+	mSelfCheckReportFileInterface->SetTitleAndTooltip( "Self-check Report",
+		"File receiving the round-trip report of a randomized simulation (optional)" );
+	mSelfCheckReportFileInterface->SetTextType( AnalyzerSettingInterfaceText::FilePath );
+	mSelfCheckReportFileInterface->SetText( mSelfCheckReportFile.c_str() );
+	AddInterface( mSelfCheckReportFileInterface.get() );
+
+	mSlaveAddressFilterInterface.reset( new AnalyzerSettingInterfaceText() );
+	mSlaveAddressFilterInterface->SetTitleAndTooltip( "Slave Address Filter",
+		"Only decode packets for these slave addresses, e.g. \"0x5, 0x7, 0xA-0xC\" (empty: all)" );
+	mSlaveAddressFilterInterface->SetText( "" );
+	AddInterface( mSlaveAddressFilterInterface.get() );
+
+	mCommandTypeFilterInterface.reset( new AnalyzerSettingInterfaceText() );
+	mCommandTypeFilterInterface->SetTitleAndTooltip( "Command Type Filter",
+		"Only decode these command types, e.g. \"ExtRd, ELW, Wr0, MskWr\" (empty: all)" );
+	mCommandTypeFilterInterface->SetText( "" );
+	AddInterface( mCommandTypeFilterInterface.get() );
+
+	mDecodeRangeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+	mDecodeRangeInterface->SetTitleAndTooltip( "Decode Range",
+		"Limit decoding to a window of the capture" );
+	mDecodeRangeInterface->AddNumber( DecodeRangeAll, "Whole capture", "Decode all of the data" );
+	mDecodeRangeInterface->AddNumber( DecodeRangeSamples, "Sample numbers",
+		"Range Start/End are sample numbers" );
+	mDecodeRangeInterface->AddNumber( DecodeRangeTriggerTime, "Seconds from trigger",
+		"Range Start/End are times in seconds relative to the trigger, e.g. -0.5 and 0.5" );
+	mDecodeRangeInterface->SetNumber( mDecodeRange );
+	AddInterface( mDecodeRangeInterface.get() );
+
+	mDecodeRangeStartInterface.reset( new AnalyzerSettingInterfaceText() );
+	mDecodeRangeStartInterface->SetTitleAndTooltip( "Range Start",
+		"Decoding starts at the first SSC after this point (empty: beginning of the capture)" );
+	mDecodeRangeStartInterface->SetText( mDecodeRangeStart.c_str() );
+	AddInterface( mDecodeRangeStartInterface.get() );
+
+	mDecodeRangeEndInterface.reset( new AnalyzerSettingInterfaceText() );
+	mDecodeRangeEndInterface->SetTitleAndTooltip( "Range End",
+		"No packet starting after this point is decoded (empty: end of the capture)" );
+	mDecodeRangeEndInterface->SetText( mDecodeRangeEnd.c_str() );
+	AddInterface( mDecodeRangeEndInterface.get() );
+
+	mBusSclkKHzInterface.reset( new AnalyzerSettingInterfaceInteger() );
+	mBusSclkKHzInterface->SetTitleAndTooltip( "Bus SCLK [kHz]",
+		"Fastest SCLK used on the bus; the minimum sample rate is four times this (0: use the rate detected by the last decode, 50 MHz before that)" );
+	mBusSclkKHzInterface->SetMax( 100000 );
+	mBusSclkKHzInterface->SetMin( 0 );
+	mBusSclkKHzInterface->SetInteger( mBusSclkKHz );
+	AddInterface( mBusSclkKHzInterface.get() );
+
+	mTimingAnalysisInterface.reset( new AnalyzerSettingInterfaceBool() );
+	mTimingAnalysisInterface->SetTitleAndTooltip( "Measure Timing?",
+		"Measure SCLK frequency, duty cycle and SDATA setup/hold per packet and flag packets breaking the limits below" );
+	mTimingAnalysisInterface->SetValue( mTimingAnalysis );
+	AddInterface( mTimingAnalysisInterface.get() );
+
+	mMaxSclkKHzInterface.reset( new AnalyzerSettingInterfaceInteger() );
+	mMaxSclkKHzInterface->SetTitleAndTooltip( "Max SCLK [kHz]",
+		"Highest allowed average SCLK frequency of a packet (full speed: 26000; 0: 10% above the bus SCLK, configured or detected)" );
+	mMaxSclkKHzInterface->SetMax( 1000000 );
+	mMaxSclkKHzInterface->SetMin( 0 );
+	mMaxSclkKHzInterface->SetInteger( mMaxSclkKHz );
+	AddInterface( mMaxSclkKHzInterface.get() );
+
+	mMaxReadSclkKHzInterface.reset( new AnalyzerSettingInterfaceInteger() );
+	mMaxReadSclkKHzInterface->SetTitleAndTooltip( "Max Read SCLK [kHz]",
+		"Highest allowed average SCLK frequency of a read packet (half speed read: 13000; 0: 10% above the bus SCLK, configured or detected)" );
+	mMaxReadSclkKHzInterface->SetMax( 1000000 );
+	mMaxReadSclkKHzInterface->SetMin( 0 );
+	mMaxReadSclkKHzInterface->SetInteger( mMaxReadSclkKHz );
+	AddInterface( mMaxReadSclkKHzInterface.get() );
+
+	mMinSetupNsInterface.reset( new AnalyzerSettingInterfaceInteger() );
+	mMinSetupNsInterface->SetTitleAndTooltip( "Min SDATA Setup [ns]",
+		"Shortest allowed time from an SDATA transition to the SCLK falling edge; resolution is one sample" );
+	mMinSetupNsInterface->SetMax( 1000000 );
+	mMinSetupNsInterface->SetMin( 0 );
+	mMinSetupNsInterface->SetInteger( mMinSetupNs );
+	AddInterface( mMinSetupNsInterface.get() );
+
+	mMinHoldNsInterface.reset( new AnalyzerSettingInterfaceInteger() );
+	mMinHoldNsInterface->SetTitleAndTooltip( "Min SDATA Hold [ns]",
+		"Shortest allowed time from the SCLK falling edge to the next SDATA transition; resolution is one sample" );
+	mMinHoldNsInterface->SetMax( 1000000 );
+	mMinHoldNsInterface->SetMin( 0 );
+	mMinHoldNsInterface->SetInteger( mMinHoldNs );
+	AddInterface( mMinHoldNsInterface.get() );
+
+	mTimingReportFileInterface.reset( new AnalyzerSettingInterfaceText() );
+	mTimingReportFileInterface->SetTitleAndTooltip( "Timing Report",
+		"File receiving min/avg/max of the measured timing once the decode is done (optional)" );
+	mTimingReportFileInterface->SetTextType( AnalyzerSettingInterfaceText::FilePath );
+	mTimingReportFileInterface->SetText( mTimingReportFile.c_str() );
+	AddInterface( mTimingReportFileInterface.get() );
+
+	mEventChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
+	mEventChannelInterface->SetTitleAndTooltip( "Event Channel",
+		"Line the commands act on, e.g. a PA enable: the delay from the end of each event packet to the next edge here is measured (optional)" );
+	mEventChannelInterface->SetChannel( mEventChannel );
+	mEventChannelInterface->SetSelectionOfNoneIsAllowed( true );
+	AddInterface( mEventChannelInterface.get() );
+
+	mEventPacketsInterface.reset( new AnalyzerSettingInterfaceText() );
+	mEventPacketsInterface->SetTitleAndTooltip( "Event Packets",
+		"Packets the event latency is measured for as SA:address, e.g. \"0x5:0x1C, *:0x2D, 0x7\" (* or no address: any, Wr0 writes address 0; empty: all)" );
+	mEventPacketsInterface->SetText( mEventPackets.c_str() );
+	AddInterface( mEventPacketsInterface.get() );
+
+	mEventEdgeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+	mEventEdgeInterface->SetTitleAndTooltip( "Event Edge",
+		"Edge of the event channel that ends the latency" );
+	mEventEdgeInterface->AddNumber( EventEdgeAny, "Any edge", "The next transition of the event channel" );
+	mEventEdgeInterface->AddNumber( EventEdgeRising, "Rising edge", "The next low to high transition" );
+	mEventEdgeInterface->AddNumber( EventEdgeFalling, "Falling edge", "The next high to low transition" );
+	mEventEdgeInterface->SetNumber( mEventEdge );
+	AddInterface( mEventEdgeInterface.get() );
+
+	mLatencyReportFileInterface.reset( new AnalyzerSettingInterfaceText() );
+	mLatencyReportFileInterface->SetTitleAndTooltip( "Latency Report",
+		"File receiving the statistics and histogram of the event latencies once the decode is done (optional)" );
+	mLatencyReportFileInterface->SetTextType( AnalyzerSettingInterfaceText::FilePath );
+	mLatencyReportFileInterface->SetText( mLatencyReportFile.c_str() );
+	AddInterface( mLatencyReportFileInterface.get() );
+
+	mPipelinedInterface.reset( new AnalyzerSettingInterfaceBool() );
+	mPipelinedInterface->SetTitleAndTooltip( "Pipelined Decode?",
+		"Walk the SCLK/SDATA edges and build the frames and markers on two threads (faster on multicore hosts)" );
+	mPipelinedInterface->SetValue( mPipelined );
+	AddInterface( mPipelinedInterface.get() );
+
+	mStreamingInterface.reset( new AnalyzerSettingInterfaceBool() );
+	mStreamingInterface->SetTitleAndTooltip( "Streaming Decode?",
+		"Keep decoding a running capture as its data arrives instead of waiting inside a packet for more data" );
+	mStreamingInterface->SetValue( mStreaming );
+	AddInterface( mStreamingInterface.get() );
+
+	mMaxLatencyMsInterface.reset( new AnalyzerSettingInterfaceInteger() );
+	mMaxLatencyMsInterface->SetTitleAndTooltip( "Max Latency [ms]",
+		"Streaming decode: longest time a decoded packet is held back before it is shown" );
+	mMaxLatencyMsInterface->SetMax( 10000 );
+	mMaxLatencyMsInterface->SetMin( 1 );
+	mMaxLatencyMsInterface->SetInteger( mMaxLatencyMs );
+	AddInterface( mMaxLatencyMsInterface.get() );
+
+	mSummaryFramesInterface.reset( new AnalyzerSettingInterfaceBool() );
+	mSummaryFramesInterface->SetTitleAndTooltip( "Packet Summary Frames?",
+		"One frame per packet (\"SA5 ELW 0x5A94 x8\") instead of one per field, for fast drawing of long captures" );
+	mSummaryFramesInterface->SetValue( mSummaryFrames );
+	AddInterface( mSummaryFramesInterface.get() );
+
+	mCollapseRepeatsInterface.reset( new AnalyzerSettingInterfaceBool() );
+	mCollapseRepeatsInterface->SetTitleAndTooltip( "Collapse Repeats?",
+		"Show a run of identical packets as the first one and a repeat count with first/last time and min/max interval" );
+	mCollapseRepeatsInterface->SetValue( mCollapseRepeats );
+	AddInterface( mCollapseRepeatsInterface.get() );
+
+	mRegisterMapFileInterface.reset( new AnalyzerSettingInterfaceText() );
+	mRegisterMapFileInterface->SetTitleAndTooltip( "Register Map",
+		"CSV or JSON file with register names and bit fields per SA and address, shown in bubbles and the export (optional)" );
+	mRegisterMapFileInterface->SetTextType( AnalyzerSettingInterfaceText::FilePath );
+	mRegisterMapFileInterface->SetText( mRegisterMapFile.c_str() );
+	AddInterface( mRegisterMapFileInterface.get() );
+
+	mExportChunkMBInterface.reset( new AnalyzerSettingInterfaceInteger() );
+	mExportChunkMBInterface->SetTitleAndTooltip( "Export Chunk Size [MB]",
+		"Split exports into numbered files of at most this size, the export file then indexes them (0: one file)" );
+	mExportChunkMBInterface->SetMax( 1048576 );
+	mExportChunkMBInterface->SetMin( 0 );
+	mExportChunkMBInterface->SetInteger( mExportChunkMB );
+	AddInterface( mExportChunkMBInterface.get() );
+
+	mExportTimeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+	mExportTimeInterface->SetTitleAndTooltip( "Export Time",
+		"Unit of the time columns of the CSV export" );
+	mExportTimeInterface->AddNumber( ExportTimeSeconds, "Seconds from trigger", "Time as text, rounded like the display" );
+	mExportTimeInterface->AddNumber( ExportTimeSamples, "Sample numbers", "Exact sample numbers, intervals in samples" );
+	mExportTimeInterface->AddNumber( ExportTimeNanoseconds, "Nanoseconds from trigger", "Exact integer nanoseconds" );
+	mExportTimeInterface->SetNumber( mExportTime );
+	AddInterface( mExportTimeInterface.get() );
+
+	mExportDeltasInterface.reset( new AnalyzerSettingInterfaceBool() );
+	mExportDeltasInterface->SetTitleAndTooltip( "Export Deltas?",
+		"Add the time since the previous packet and since the previous packet to the same SA to the CSV export" );
+	mExportDeltasInterface->SetValue( mExportDeltas );
+	AddInterface( mExportDeltasInterface.get() );
+
 	AddExportOption( 0, "Export as csv/text file" );
 	AddExportExtension( 0, "csv", "csv" );
 	AddExportExtension( 0, "text", "txt" );
+	AddExportOption( 1, "Export as csv/text file, repeats collapsed" );
+	AddExportExtension( 1, "csv", "csv" );
+	AddExportExtension( 1, "text", "txt" );
+	AddExportOption( 2, "Export as NDJSON file (one JSON record per packet)" );
+	AddExportExtension( 2, "ndjson", "ndjson" );
+	AddExportExtension( 2, "json lines", "jsonl" );
+	AddExportOption( 3, "Export as pcapng file (Wireshark, user link type 147)" );
+	AddExportExtension( 3, "pcapng", "pcapng" );
 
-	ClearChannels();
-	AddChannel( mSclkChannel, "SCLK", false );
-	AddChannel( mSdataChannel, "SDATA", false );
+	UpdateChannels( false );
 }
 
 RFFEAnalyzerSettings::~RFFEAnalyzerSettings()
@@ -41,14 +499,134 @@ RFFEAnalyzerSettings::~RFFEAnalyzerSettings()
 
 bool RFFEAnalyzerSettings::SetSettingsFromInterfaces()
 {
-	mSclkChannel = mSclkChannelInterface->GetChannel();
-	mSdataChannel = mSdataChannelInterface->GetChannel();
+	Channel sclk[RFFE_MAX_BUSES];
+	Channel sdata[RFFE_MAX_BUSES];
+
+	sclk[0] = mSclkChannelInterface->GetChannel();
+	sdata[0] = mSdataChannelInterface->GetChannel();
+	for( U32 i = 1; i < RFFE_MAX_BUSES; i++ )
+	{
+		sclk[i] = mBusSclkChannelInterface[i - 1]->GetChannel();
+		sdata[i] = mBusSdataChannelInterface[i - 1]->GetChannel();
+		if( ( sclk[i] == UNDEFINED_CHANNEL ) != ( sdata[i] == UNDEFINED_CHANNEL ) )
+		{
+			SetErrorText( "Each further bus needs both its SCLK and its SDATA channel" );
+			return false;
+		}
+	}
+	for( U32 i = 0; i < 2 * RFFE_MAX_BUSES; i++ )
+	{
+		Channel& a = ( i & 1 ) ? sdata[i / 2] : sclk[i / 2];
+		for( U32 j = i + 1; j < 2 * RFFE_MAX_BUSES && a != UNDEFINED_CHANNEL; j++ )
+		{
+			if( a == ( ( j & 1 ) ? sdata[j / 2] : sclk[j / 2] ) )
+			{
+				SetErrorText( "Please select different channels for each input" );
+				return false;
+			}
+		}
+	}
+
+	Channel event = mEventChannelInterface->GetChannel();
+	for( U32 i = 0; i < RFFE_MAX_BUSES && event != UNDEFINED_CHANNEL; i++ )
+	{
+		if( event == sclk[i] || event == sdata[i] )
+		{
+			SetErrorText( "Please select different channels for each input" );
+			return false;
+		}
+	}
+
+	// the detected SCLK rate belongs to the bus on these channels
+	U32 protocol_version = U32( mProtocolVersionInterface->GetNumber() );
+	bool same_bus = protocol_version == mProtocolVersion;
+	for( U32 i = 0; i < RFFE_MAX_BUSES; i++ )
+	{
+		same_bus = same_bus && sclk[i] == GetSclkChannel( i ) && sdata[i] == GetSdataChannel( i );
+	}
+	if( !same_bus )
+		mDetectedSclkHz = 0;
+
+	mSclkChannel = sclk[0];
+	mSdataChannel = sdata[0];
+	for( U32 i = 1; i < RFFE_MAX_BUSES; i++ )
+	{
+		mBusSclkChannel[i - 1] = sclk[i];
+		mBusSdataChannel[i - 1] = sdata[i];
+	}
+	mProtocolVersion = protocol_version;
 	mShowParityInReport = mShowParityInReportInterface->GetValue();
 	mShowBusParkInReport = mShowBusParkInReportInterface->GetValue();
+	mSimulationMode = U32( mSimulationModeInterface->GetNumber() );
+	mSelfCheckReportFile = mSelfCheckReportFileInterface->GetText();
 
-	ClearChannels();
-	AddChannel( mSclkChannel, "SCLK", true );
-	AddChannel( mSdataChannel, "SDATA", true );
+	U32 sa_filter;
+	U32 type_filter;
+	if( !ParseSlaveAddressFilter( mSlaveAddressFilterInterface->GetText(), &sa_filter ) )
+	{
+		SetErrorText( "Slave Address Filter: expected a list of addresses 0x0-0xF, e.g. \"0x5, 0xA-0xC\"" );
+		return false;
+	}
+	if( !ParseCommandTypeFilter( mCommandTypeFilterInterface->GetText(), &type_filter ) )
+	{
+		SetErrorText( "Command Type Filter: expected a list of EW/ExtWr, Rsv, ER/ExtRd, ELW/ExtLngWr, ELR/ExtLngRd, W/Wr, R/Rd, W0/Wr0, MW/MskWr" );
+		return false;
+	}
+	std::vector< RFFEEventPacket > event_packets;
+	if( !ParseEventPackets( mEventPacketsInterface->GetText(), &event_packets ) )
+	{
+		SetErrorText( "Event Packets: expected a list of SA:address, e.g. \"0x5:0x1C, *:0x2D, 0x7\"" );
+		return false;
+	}
+
+	double bound;
+	bool is_set;
+	if( !ParseRangeBound( mDecodeRangeStartInterface->GetText(), &bound, &is_set ) ||
+	    !ParseRangeBound( mDecodeRangeEndInterface->GetText(), &bound, &is_set ) )
+	{
+		SetErrorText( "Range Start/End: expected a sample number or a time in seconds" );
+		return false;
+	}
+
+	// read again on every save, the file may have been edited
+	RFFERegisterMap register_map;
+	std::string register_map_file = mRegisterMapFileInterface->GetText();
+	std::string error;
+	if( !register_map_file.empty() && !register_map.Load( register_map_file.c_str(), &error ) )
+	{
+		SetErrorText( ( "Register Map: " + error ).c_str() );
+		return false;
+	}
+
+	mSlaveAddressFilter = sa_filter;
+	mCommandTypeFilter = type_filter;
+	mDecodeRange = U32( mDecodeRangeInterface->GetNumber() );
+	mDecodeRangeStart = mDecodeRangeStartInterface->GetText();
+	mDecodeRangeEnd = mDecodeRangeEndInterface->GetText();
+	mBusSclkKHz = U32( mBusSclkKHzInterface->GetInteger() );
+	mTimingAnalysis = mTimingAnalysisInterface->GetValue();
+	mMaxSclkKHz = U32( mMaxSclkKHzInterface->GetInteger() );
+	mMaxReadSclkKHz = U32( mMaxReadSclkKHzInterface->GetInteger() );
+	mMinSetupNs = U32( mMinSetupNsInterface->GetInteger() );
+	mMinHoldNs = U32( mMinHoldNsInterface->GetInteger() );
+	mTimingReportFile = mTimingReportFileInterface->GetText();
+	mEventChannel = event;
+	mEventPackets = mEventPacketsInterface->GetText();
+	mEventPacketList = event_packets;
+	mEventEdge = U32( mEventEdgeInterface->GetNumber() );
+	mLatencyReportFile = mLatencyReportFileInterface->GetText();
+	mPipelined = mPipelinedInterface->GetValue();
+	mStreaming = mStreamingInterface->GetValue();
+	mMaxLatencyMs = U32( mMaxLatencyMsInterface->GetInteger() );
+	mSummaryFrames = mSummaryFramesInterface->GetValue();
+	mCollapseRepeats = mCollapseRepeatsInterface->GetValue();
+	mRegisterMapFile = register_map_file;
+	mRegisterMap = register_map;
+	mExportChunkMB = U32( mExportChunkMBInterface->GetInteger() );
+	mExportTime = U32( mExportTimeInterface->GetNumber() );
+	mExportDeltas = mExportDeltasInterface->GetValue();
+
+	UpdateChannels( true );
 
 	return true;
 }
@@ -57,8 +635,41 @@ void RFFEAnalyzerSettings::UpdateInterfacesFromSettings()
 {
 	mSclkChannelInterface->SetChannel( mSclkChannel );
 	mSdataChannelInterface->SetChannel( mSdataChannel );
+	for( U32 i = 0; i < RFFE_MAX_BUSES - 1; i++ )
+	{
+		mBusSclkChannelInterface[i]->SetChannel( mBusSclkChannel[i] );
+		mBusSdataChannelInterface[i]->SetChannel( mBusSdataChannel[i] );
+	}
 	mShowParityInReportInterface->SetValue(mShowParityInReport);
 	mShowBusParkInReportInterface->SetValue(mShowBusParkInReport);
+	mSimulationModeInterface->SetNumber( mSimulationMode );
+	mSelfCheckReportFileInterface->SetText( mSelfCheckReportFile.c_str() );
+	mSlaveAddressFilterInterface->SetText( FormatSlaveAddressFilter( mSlaveAddressFilter ).c_str() );
+	mCommandTypeFilterInterface->SetText( FormatCommandTypeFilter( mCommandTypeFilter ).c_str() );
+	mDecodeRangeInterface->SetNumber( mDecodeRange );
+	mDecodeRangeStartInterface->SetText( mDecodeRangeStart.c_str() );
+	mDecodeRangeEndInterface->SetText( mDecodeRangeEnd.c_str() );
+	mBusSclkKHzInterface->SetInteger( mBusSclkKHz );
+	mTimingAnalysisInterface->SetValue( mTimingAnalysis );
+	mMaxSclkKHzInterface->SetInteger( mMaxSclkKHz );
+	mMaxReadSclkKHzInterface->SetInteger( mMaxReadSclkKHz );
+	mMinSetupNsInterface->SetInteger( mMinSetupNs );
+	mMinHoldNsInterface->SetInteger( mMinHoldNs );
+	mTimingReportFileInterface->SetText( mTimingReportFile.c_str() );
+	mEventChannelInterface->SetChannel( mEventChannel );
+	mEventPacketsInterface->SetText( mEventPackets.c_str() );
+	mEventEdgeInterface->SetNumber( mEventEdge );
+	mLatencyReportFileInterface->SetText( mLatencyReportFile.c_str() );
+	mPipelinedInterface->SetValue( mPipelined );
+	mStreamingInterface->SetValue( mStreaming );
+	mMaxLatencyMsInterface->SetInteger( mMaxLatencyMs );
+	mSummaryFramesInterface->SetValue( mSummaryFrames );
+	mCollapseRepeatsInterface->SetValue( mCollapseRepeats );
+	mRegisterMapFileInterface->SetText( mRegisterMapFile.c_str() );
+	mExportChunkMBInterface->SetInteger( mExportChunkMB );
+	mExportTimeInterface->SetNumber( mExportTime );
+	mExportDeltasInterface->SetValue( mExportDeltas );
+	mProtocolVersionInterface->SetNumber( mProtocolVersion );
 }
 
 void RFFEAnalyzerSettings::LoadSettings( const char* settings )
@@ -71,9 +682,142 @@ void RFFEAnalyzerSettings::LoadSettings( const char* settings )
 	text_archive >> mShowParityInReport;
 	text_archive >> mShowBusParkInReport;
 
-	ClearChannels();
-	AddChannel( mSclkChannel, "SCLK", true );
-	AddChannel( mSdataChannel, "SDATA", true );
+	// settings saved by older versions end here
+	const char* report_file;
+	if( text_archive >> mSimulationMode &&
+	    text_archive >> &report_file )
+	{
+		mSelfCheckReportFile = report_file;
+	}
+	if( !( text_archive >> mSlaveAddressFilter &&
+	       text_archive >> mCommandTypeFilter ) )
+	{
+		mSlaveAddressFilter = RFFE_ALL_SLAVE_ADDRESSES;
+		mCommandTypeFilter = RFFE_ALL_COMMAND_TYPES;
+	}
+	// saved before there were v2.x types: all v1.0 types meant all
+	if( mCommandTypeFilter == 0xFF )
+	{
+		mCommandTypeFilter = RFFE_ALL_COMMAND_TYPES;
+	}
+	const char* range_start;
+	const char* range_end;
+	if( text_archive >> mDecodeRange &&
+	    text_archive >> &range_start &&
+	    text_archive >> &range_end )
+	{
+		mDecodeRangeStart = range_start;
+		mDecodeRangeEnd = range_end;
+	}
+	else
+	{
+		mDecodeRange = DecodeRangeAll;
+	}
+	const char* timing_report_file;
+	if( text_archive >> mTimingAnalysis &&
+	    text_archive >> mMaxSclkKHz &&
+	    text_archive >> mMaxReadSclkKHz &&
+	    text_archive >> mMinSetupNs &&
+	    text_archive >> mMinHoldNs &&
+	    text_archive >> &timing_report_file )
+	{
+		mTimingReportFile = timing_report_file;
+	}
+	else
+	{
+		mTimingAnalysis = false;
+	}
+	U32 detected_sclk_hz;
+	if( !( text_archive >> mBusSclkKHz &&
+	       text_archive >> detected_sclk_hz ) )
+	{
+		mBusSclkKHz = 0;
+		detected_sclk_hz = 0;
+	}
+	mDetectedSclkHz = detected_sclk_hz;
+	for( U32 i = 0; i < RFFE_MAX_BUSES - 1; i++ )
+	{
+		if( !( text_archive >> mBusSclkChannel[i] &&
+		       text_archive >> mBusSdataChannel[i] ) )
+		{
+			mBusSclkChannel[i] = UNDEFINED_CHANNEL;
+			mBusSdataChannel[i] = UNDEFINED_CHANNEL;
+		}
+	}
+	if( !( text_archive >> mPipelined ) )
+	{
+		mPipelined = false;
+	}
+	if( !( text_archive >> mStreaming &&
+	       text_archive >> mMaxLatencyMs ) )
+	{
+		mStreaming = false;
+		mMaxLatencyMs = 10;
+	}
+	if( !( text_archive >> mSummaryFrames ) )
+	{
+		mSummaryFrames = false;
+	}
+	if( !( text_archive >> mCollapseRepeats ) )
+	{
+		mCollapseRepeats = false;
+	}
+	const char* register_map_file;
+	mRegisterMapFile.clear();
+	if( text_archive >> &register_map_file )
+	{
+		mRegisterMapFile = register_map_file;
+	}
+
+	if( !( text_archive >> mExportChunkMB ) )
+	{
+		mExportChunkMB = 0;
+	}
+	if( !( text_archive >> mExportTime ) || mExportTime > ExportTimeNanoseconds )
+	{
+		mExportTime = ExportTimeSeconds;
+	}
+	if( !( text_archive >> mExportDeltas ) )
+	{
+		mExportDeltas = false;
+	}
+	if( !( text_archive >> mProtocolVersion ) || mProtocolVersion > ProtocolV2 )
+	{
+		mProtocolVersion = ProtocolV1;
+	}
+	const char* event_packets;
+	const char* latency_report_file;
+	mEventPackets.clear();
+	mLatencyReportFile.clear();
+	if( text_archive >> mEventChannel &&
+	    text_archive >> &event_packets &&
+	    text_archive >> mEventEdge &&
+	    text_archive >> &latency_report_file &&
+	    mEventEdge <= EventEdgeFalling )
+	{
+		mEventPackets = event_packets;
+		mLatencyReportFile = latency_report_file;
+	}
+	else
+	{
+		mEventChannel = UNDEFINED_CHANNEL;
+		mEventEdge = EventEdgeAny;
+	}
+	if( !ParseEventPackets( mEventPackets.c_str(), &mEventPacketList ) )
+	{
+		mEventPackets.clear();
+		mEventPacketList.clear();
+	}
+
+	// a map that no longer loads only loses the annotation
+	std::string error;
+	mRegisterMap.Clear();
+	if( !mRegisterMapFile.empty() )
+	{
+		mRegisterMap.Load( mRegisterMapFile.c_str(), &error );
+	}
+
+	UpdateChannels( true );
 
 	UpdateInterfacesFromSettings();
 }
@@ -86,6 +830,145 @@ const char* RFFEAnalyzerSettings::SaveSettings()
 	text_archive << mSdataChannel;
 	text_archive << mShowParityInReport;
 	text_archive << mShowBusParkInReport;
+	text_archive << mSimulationMode;
+	text_archive << mSelfCheckReportFile.c_str();
+	text_archive << mSlaveAddressFilter;
+	text_archive << mCommandTypeFilter;
+	text_archive << mDecodeRange;
+	text_archive << mDecodeRangeStart.c_str();
+	text_archive << mDecodeRangeEnd.c_str();
+	text_archive << mTimingAnalysis;
+	text_archive << mMaxSclkKHz;
+	text_archive << mMaxReadSclkKHz;
+	text_archive << mMinSetupNs;
+	text_archive << mMinHoldNs;
+	text_archive << mTimingReportFile.c_str();
+	text_archive << mBusSclkKHz;
+	text_archive << mDetectedSclkHz.load();
+	for( U32 i = 0; i < RFFE_MAX_BUSES - 1; i++ )
+	{
+		text_archive << mBusSclkChannel[i];
+		text_archive << mBusSdataChannel[i];
+	}
+	text_archive << mPipelined;
+	text_archive << mStreaming;
+	text_archive << mMaxLatencyMs;
+	text_archive << mSummaryFrames;
+	text_archive << mCollapseRepeats;
+	text_archive << mRegisterMapFile.c_str();
+	text_archive << mExportChunkMB;
+	text_archive << mExportTime;
+	text_archive << mExportDeltas;
+	text_archive << mProtocolVersion;
+	text_archive << mEventChannel;
+	text_archive << mEventPackets.c_str();
+	text_archive << mEventEdge;
+	text_archive << mLatencyReportFile.c_str();
 
 	return SetReturnString( text_archive.GetString() );
 }
+
+bool RFFEAnalyzerSettings::GetDecodeRange( U64 trigger_sample, U32 sample_rate_hz, U64* start_sample, U64* end_sample ) const
+{
+	double bound[2];
+	bool is_set[2];
+	U64* sample[2] = { start_sample, end_sample };
+
+	*start_sample = 0;
+	*end_sample = U64( -1 );
+	if( mDecodeRange == DecodeRangeAll ||
+	    !ParseRangeBound( mDecodeRangeStart.c_str(), &bound[0], &is_set[0] ) ||
+	    !ParseRangeBound( mDecodeRangeEnd.c_str(), &bound[1], &is_set[1] ) )
+	{
+		return false;
+	}
+
+	for( U32 i = 0; i < 2; i++ )
+	{
+		if( !is_set[i] )
+			continue;
+		if( mDecodeRange == DecodeRangeTriggerTime )
+			bound[i] = double( trigger_sample ) + bound[i] * double( sample_rate_hz );
+		*sample[i] = ( bound[i] <= 0.0 ) ? 0 : U64( bound[i] + 0.5 );
+	}
+	return true;
+}
+
+void RFFEAnalyzerSettings::UpdateChannels( bool is_used )
+{
+	ClearChannels();
+	AddChannel( mSclkChannel, "SCLK", is_used );
+	AddChannel( mSdataChannel, "SDATA", is_used );
+	for( U32 i = 0; i < RFFE_MAX_BUSES - 1; i++ )
+	{
+		AddChannel( mBusSclkChannel[i], BusSclkNames[i], is_used && mBusSclkChannel[i] != UNDEFINED_CHANNEL );
+		AddChannel( mBusSdataChannel[i], BusSdataNames[i], is_used && mBusSdataChannel[i] != UNDEFINED_CHANNEL );
+	}
+	AddChannel( mEventChannel, "Event", is_used && mEventChannel != UNDEFINED_CHANNEL );
+}
+
+Channel RFFEAnalyzerSettings::GetSclkChannel( U32 bus ) const
+{
+	return ( bus == 0 ) ? mSclkChannel : mBusSclkChannel[bus - 1];
+}
+
+Channel RFFEAnalyzerSettings::GetSdataChannel( U32 bus ) const
+{
+	return ( bus == 0 ) ? mSdataChannel : mBusSdataChannel[bus - 1];
+}
+
+bool RFFEAnalyzerSettings::IsBusUsed( U32 bus ) const
+{
+	return GetSclkChannel( bus ) != UNDEFINED_CHANNEL && GetSdataChannel( bus ) != UNDEFINED_CHANNEL;
+}
+
+bool RFFEAnalyzerSettings::IsMultiBus() const
+{
+	for( U32 i = 1; i < RFFE_MAX_BUSES; i++ )
+	{
+		if( IsBusUsed( i ) )
+			return true;
+	}
+	return false;
+}
+
+// Wr0 writes register 0, so it is an event packet of address 0
+bool RFFEAnalyzerSettings::IsEventPacket( U8 slave_address, U16 address ) const
+{
+	if( mEventPacketList.empty() )
+		return true;
+	for( size_t i = 0; i < mEventPacketList.size(); i++ )
+	{
+		const RFFEEventPacket& packet = mEventPacketList[i];
+		if( ( packet.mAnySlaveAddress || packet.mSlaveAddress == slave_address ) &&
+		    ( packet.mAnyAddress || packet.mAddress == address ) )
+			return true;
+	}
+	return false;
+}
+
+// the configured rate wins over the one detected on the bus
+U32 RFFEAnalyzerSettings::GetBusSclkHz() const
+{
+	if( mBusSclkKHz != 0 )
+		return mBusSclkKHz * 1000;
+	return mDetectedSclkHz.load( std::memory_order_relaxed );
+}
+
+// Everything that changes the decoded packets apart from the bus channels and
+// the decode range. The report options, "Pipelined Decode?" and the latency bound
+// only change how results are shown or produced, not the results.
+std::string RFFEAnalyzerSettings::GetDecodeKey() const
+{
+	std::ostringstream key;
+
+	key << mProtocolVersion << ' ' << mSimulationMode << ' ' << mSelfCheckReportFile << '\n'
+	    << mSlaveAddressFilter << ' ' << mCommandTypeFilter << ' '
+	    << mBusSclkKHz << ' ' << mStreaming << ' '
+	    << mTimingAnalysis << ' ' << mMaxSclkKHz << ' ' << mMaxReadSclkKHz << ' '
+	    << mMinSetupNs << ' ' << mMinHoldNs << ' ' << mTimingReportFile << '\n'
+	    << mSummaryFrames << ' ' << mCollapseRepeats << '\n'
+	    << ( mEventChannel == UNDEFINED_CHANNEL ? -1 : S64( mEventChannel.mChannelIndex ) ) << ' '
+	    << mEventPackets << ' ' << mEventEdge << ' ' << mLatencyReportFile;
+	return key.str();
+}
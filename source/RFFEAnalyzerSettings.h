@@ -3,6 +3,21 @@
 
 #include <AnalyzerSettings.h>
 #include <AnalyzerTypes.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "RFFEPacket.h"
+#include "RFFERegisterMap.h"
+
+// a packet the event latency is measured for: SA and register address,
+// either of them any
+struct RFFEEventPacket
+{
+	bool mAnySlaveAddress;
+	bool mAnyAddress;
+	U8   mSlaveAddress;
+	U16  mAddress;
+};
 
 class RFFEAnalyzerSettings : public AnalyzerSettings
 {
@@ -18,14 +33,132 @@ public:
 	
 	Channel mSclkChannel;
 	Channel mSdataChannel;
+	Channel mBusSclkChannel[RFFE_MAX_BUSES - 1];	// buses 1..3, UNDEFINED_CHANNEL when not used
+	Channel mBusSdataChannel[RFFE_MAX_BUSES - 1];
 	bool    mShowParityInReport;
 	bool    mShowBusParkInReport;
+	U32     mProtocolVersion;	// ProtocolVersion: command set of the bus
+	U32     mSimulationMode;
+	std::string mSelfCheckReportFile;
+	U32     mSlaveAddressFilter;	// bit n set: decode packets for SA n
+	U32     mCommandTypeFilter;	// bit n set: decode RffeTypeFieldType n
+
+	U32     mDecodeRange;
+	std::string mDecodeRangeStart;	// empty: from the beginning of the capture
+	std::string mDecodeRangeEnd;	// empty: up to the end of the capture
+
+	U32     mBusSclkKHz;		// fastest SCLK on the bus, 0: not known
+	std::atomic< U32 > mDetectedSclkHz;	// measured on these channels, 0: none yet; set by the worker
+
+	bool    mTimingAnalysis;
+	U32     mMaxSclkKHz;		// RFFE v1.0 full speed: 26 MHz
+	U32     mMaxReadSclkKHz;	// RFFE v1.0 half speed read: 13 MHz
+	U32     mMinSetupNs;
+	U32     mMinHoldNs;
+	std::string mTimingReportFile;
+
+	Channel mEventChannel;		// UNDEFINED_CHANNEL: no latency measurement
+	std::string mEventPackets;	// "SA:address" list, empty: all packets
+	std::vector< RFFEEventPacket > mEventPacketList;	// parsed from mEventPackets
+	U32     mEventEdge;		// EventEdge ending the latency
+	std::string mLatencyReportFile;
+
+	bool    mPipelined;		// bit extraction and result building on two threads
+	bool    mStreaming;		// decode a running capture as its data arrives
+	U32     mMaxLatencyMs;		// streaming: longest a decoded packet waits for its commit
+	bool    mSummaryFrames;		// one frame per packet instead of one per field
+	bool    mCollapseRepeats;	// runs of identical packets as one with a repeat count
+	std::string mRegisterMapFile;	// CSV or JSON register map, empty: none
+	RFFERegisterMap mRegisterMap;	// loaded from mRegisterMapFile
+	U32     mExportChunkMB;		// split exports into files of this size, 0: one file
+	U32     mExportTime;		// ExportTime of the CSV time columns
+	bool    mExportDeltas;		// CSV: time since the previous packet and the previous one of its SA
+
+	Channel GetSclkChannel( U32 bus ) const;
+	Channel GetSdataChannel( U32 bus ) const;
+	bool IsBusUsed( U32 bus ) const;
+	bool IsMultiBus() const;
+
+	U32 GetBusSclkHz() const;
+	bool GetDecodeRange( U64 trigger_sample, U32 sample_rate_hz, U64* start_sample, U64* end_sample ) const;
+	std::string GetDecodeKey() const;
+
+	bool IsPacketSelected( U8 slave_address, U8 type ) const
+	{
+		return ( ( mSlaveAddressFilter >> slave_address ) & ( mCommandTypeFilter >> type ) & 1 ) != 0;
+	}
+	bool IsEventPacket( U8 slave_address, U16 address ) const;
+
+	enum ProtocolVersion
+	{
+		ProtocolV1,
+		ProtocolV2,	// v1.0 plus the v2.x masked write, other v2.x commands are skipped
+	};
+
+	enum SimulationMode
+	{
+		SimulationCommandSweep,
+		SimulationRandomized,
+	};
+
+	enum DecodeRange
+	{
+		DecodeRangeAll,
+		DecodeRangeSamples,
+		DecodeRangeTriggerTime,
+	};
+
+	enum EventEdge
+	{
+		EventEdgeAny,
+		EventEdgeRising,
+		EventEdgeFalling,
+	};
+
+	enum ExportTime
+	{
+		ExportTimeSeconds,
+		ExportTimeSamples,
+		ExportTimeNanoseconds,
+	};
 
 protected:
+	void UpdateChannels( bool is_used );
+
 	std::auto_ptr< AnalyzerSettingInterfaceChannel > mSclkChannelInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceChannel > mSdataChannelInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceChannel > mBusSclkChannelInterface[RFFE_MAX_BUSES - 1];
+	std::auto_ptr< AnalyzerSettingInterfaceChannel > mBusSdataChannelInterface[RFFE_MAX_BUSES - 1];
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mProtocolVersionInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceBool >	 mShowParityInReportInterface;
 	std::auto_ptr< AnalyzerSettingInterfaceBool >	 mShowBusParkInReportInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mSimulationModeInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mSelfCheckReportFileInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mSlaveAddressFilterInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mCommandTypeFilterInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mDecodeRangeInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mDecodeRangeStartInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mDecodeRangeEndInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mBusSclkKHzInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool >	 mTimingAnalysisInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mMaxSclkKHzInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mMaxReadSclkKHzInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mMinSetupNsInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mMinHoldNsInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mTimingReportFileInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceChannel > mEventChannelInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mEventPacketsInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mEventEdgeInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mLatencyReportFileInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool >	 mPipelinedInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool >	 mStreamingInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mMaxLatencyMsInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool >	 mSummaryFramesInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool >	 mCollapseRepeatsInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText >	 mRegisterMapFileInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mExportChunkMBInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceNumberList > mExportTimeInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool >	 mExportDeltasInterface;
 };
 
 #endif //RFFE_ANALYZER_SETTINGS
@@ -0,0 +1,78 @@
+#include "RFFECheckpoints.h"
+
+RFFECheckpoints::RFFECheckpoints()
+:   mRangeStart( 0 ),
+    mRangeEnd( 0 ),
+    mResults( 0 ),
+    mFinished( false )
+{
+}
+
+RFFECheckpoints::~RFFECheckpoints()
+{
+}
+
+void RFFECheckpoints::Start( const std::string& capture, const std::string& decode, U64 range_start, U64 range_end )
+{
+    mCapture    = capture;
+    mDecode     = decode;
+    mRangeStart = range_start;
+    mRangeEnd   = range_end;
+    mFinished   = false;
+    mCheckpoints.clear();
+}
+
+void RFFECheckpoints::Add( const RFFECheckpoint& checkpoint )
+{
+    mCheckpoints.push_back( checkpoint );
+}
+
+// the decode goes on from the end, its results are incomplete until Finish
+void RFFECheckpoints::Resume()
+{
+    mFinished = false;
+}
+
+// a later decode may build on its results by going on from end
+void RFFECheckpoints::Finish( const RFFECheckpoint& end, U64 range_end, U64 results )
+{
+    mEnd      = end;
+    mRangeEnd = range_end;
+    mResults  = results;
+    mFinished = true;
+}
+
+void RFFECheckpoints::Invalidate()
+{
+    mCapture.clear();
+    mFinished = false;
+    mCheckpoints.clear();
+}
+
+// The last checkpoint where no bus stands past sample, NULL when there is
+// none. Bus positions only grow from one checkpoint to the next.
+const RFFECheckpoint* RFFECheckpoints::FindBefore( U64 sample, U32 bus_count ) const
+{
+    size_t low  = 0;
+    size_t high = mCheckpoints.size();
+
+    while ( low < high )
+    {
+        size_t mid = low + ( high - low ) / 2;
+        bool before = true;
+
+        for ( U32 i = 0; i < bus_count; i++ )
+        {
+            before &= mCheckpoints[mid].mSample[i] <= sample;
+        }
+        if ( before )
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low == 0 ? NULL : &mCheckpoints[low - 1];
+}
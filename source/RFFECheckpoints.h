@@ -0,0 +1,67 @@
+#ifndef RFFE_CHECKPOINTS
+#define RFFE_CHECKPOINTS
+
+#include <LogicPublicTypes.h>
+#include <string>
+#include <vector>
+#include "RFFEPacket.h"
+
+// packets handed on between two checkpoints
+#define RFFE_CHECKPOINT_INTERVAL    1024
+
+// Decoder position between two packets: every bus goes on searching for its
+// next SSC at mSample[bus] (by its slot in the decoder, not its bus id), and
+// mPackets packets of mFrames frames were handed on before (at the end of a
+// decode: are in the results, collapsed repeats and all). mSsc, mSscFall
+// and mSscClock are where the last SSC a bus found before mSample starts, its
+// SDATA falling edge and the SCLK edge after it (RFFE_NO_SSC before the
+// first): a capture with these edges is the one the checkpoint was taken in.
+#define RFFE_NO_SSC     U64( -1 )
+
+struct RFFECheckpoint
+{
+    U64 mSample[RFFE_MAX_BUSES];
+    U64 mSsc[RFFE_MAX_BUSES];
+    U64 mSscFall[RFFE_MAX_BUSES];
+    U64 mSscClock[RFFE_MAX_BUSES];
+    U64 mPackets;
+    U64 mFrames;
+};
+
+// Checkpoints of the last decode, kept across reruns. They are only good for
+// the same capture (channels, sample rate, data) and, for results to build
+// on, the same decoding settings and the same results object (by the serial
+// number the analyzer gives each one it makes).
+class RFFECheckpoints
+{
+public:
+    RFFECheckpoints();
+    ~RFFECheckpoints();
+
+    void Start( const std::string& capture, const std::string& decode, U64 range_start, U64 range_end );
+    void Add( const RFFECheckpoint& checkpoint );
+    void Resume();
+    void Finish( const RFFECheckpoint& end, U64 range_end, U64 results );
+    void Invalidate();
+
+    bool IsFinished() const             { return mFinished; }
+    const std::string& GetCapture() const { return mCapture; }
+    const std::string& GetDecode() const  { return mDecode; }
+    U64 GetRangeStart() const           { return mRangeStart; }
+    U64 GetRangeEnd() const             { return mRangeEnd; }
+    const RFFECheckpoint& GetEnd() const { return mEnd; }
+    U64 GetResults() const              { return mResults; }
+    const RFFECheckpoint* FindBefore( U64 sample, U32 bus_count ) const;
+
+protected:
+    std::string mCapture;
+    std::string mDecode;
+    U64 mRangeStart;
+    U64 mRangeEnd;
+    std::vector< RFFECheckpoint > mCheckpoints;
+    RFFECheckpoint mEnd;    // where a finished decode stopped
+    U64 mResults;           // the results it stopped in
+    bool mFinished;
+};
+
+#endif //RFFE_CHECKPOINTS
@@ -0,0 +1,142 @@
+#include "RFFEExportFile.h"
+#include <AnalyzerHelpers.h>
+#include <iomanip>
+#include <sstream>
+
+// "dir/capture.csv" -> "dir/capture.007.csv"
+static std::string GetChunkName( const std::string& file, size_t index )
+{
+    size_t slash = file.find_last_of( "/\\" );
+    size_t dot = file.find_last_of( '.' );
+    std::ostringstream name;
+
+    if ( dot == std::string::npos || ( slash != std::string::npos && dot < slash ) )
+        dot = file.size();
+    name << file.substr( 0, dot ) << "." << std::setw( 3 ) << std::setfill( '0' ) << index << file.substr( dot );
+    return name.str();
+}
+
+static std::string GetBaseName( const std::string& file )
+{
+    size_t slash = file.find_last_of( "/\\" );
+    return slash == std::string::npos ? file : file.substr( slash + 1 );
+}
+
+RFFEExportFile::RFFEExportFile( const char* file, U64 chunk_bytes, bool is_binary )
+:   mFile( file ),
+    mChunkBytes( chunk_bytes ),
+    mIsBinary( is_binary ),
+    mOut( NULL )
+{
+}
+
+RFFEExportFile::~RFFEExportFile()
+{
+    if ( mOut != NULL )
+    {
+        AnalyzerHelpers::EndFile( mOut );
+    }
+}
+
+void RFFEExportFile::SetHeader( const std::string& header )
+{
+    mHeader = header;
+}
+
+void RFFEExportFile::Write( const char* record, U32 length, U64 first_packet, U64 last_packet, U64 first_sample, U64 last_sample )
+{
+    if ( mOut != NULL && mChunkBytes != 0 &&
+         mChunks.back().mRecords != 0 && mChunks.back().mBytes + length > mChunkBytes )
+    {
+        EndChunk();
+    }
+    if ( mOut == NULL )
+    {
+        StartChunk();
+    }
+
+    Chunk& chunk = mChunks.back();
+    if ( chunk.mRecords == 0 )
+    {
+        chunk.mFirstPacket = first_packet;
+        chunk.mFirstSample = first_sample;
+    }
+    chunk.mLastPacket = last_packet;
+    chunk.mLastSample = last_sample;
+    chunk.mBytes     += length;
+    chunk.mRecords++;
+
+    AnalyzerHelpers::AppendToFile( (const U8*)record, length, mOut );
+}
+
+// closes the last file; an export without records still gets its header
+void RFFEExportFile::Finish( U64 trigger_sample, U32 sample_rate )
+{
+    if ( mChunks.empty() )
+    {
+        StartChunk();
+    }
+    EndChunk();
+    if ( mChunkBytes == 0 )
+    {
+        return;
+    }
+
+    std::stringstream ss;
+    char time_str[32];
+    void* index = AnalyzerHelpers::StartFile( mFile.c_str() );
+
+    ss << "File,First Packet ID,Last Packet ID,First Sample,Last Sample,First Time [s],Last Time [s],Bytes" << std::endl;
+    for ( size_t i = 0; i < mChunks.size(); i++ )
+    {
+        const Chunk& chunk = mChunks[i];
+
+        ss << GetBaseName( chunk.mName ) << ",";
+        if ( chunk.mRecords != 0 )
+        {
+            ss << chunk.mFirstPacket << "," << chunk.mLastPacket << ","
+               << chunk.mFirstSample << "," << chunk.mLastSample << ",";
+            AnalyzerHelpers::GetTimeString( chunk.mFirstSample, trigger_sample, sample_rate, time_str, sizeof( time_str ) );
+            ss << time_str << ",";
+            AnalyzerHelpers::GetTimeString( chunk.mLastSample, trigger_sample, sample_rate, time_str, sizeof( time_str ) );
+            ss << time_str << ",";
+        }
+        else
+        {
+            ss << ",,,,,,";
+        }
+        ss << chunk.mBytes << std::endl;
+        AnalyzerHelpers::AppendToFile( (const U8*)ss.str().c_str(), (U32)ss.str().length(), index );
+        ss.str( std::string() );
+    }
+    AnalyzerHelpers::EndFile( index );
+}
+
+void RFFEExportFile::StartChunk()
+{
+    Chunk chunk;
+
+    chunk.mName        = mChunkBytes == 0 ? mFile : GetChunkName( mFile, mChunks.size() );
+    chunk.mFirstPacket = 0;
+    chunk.mLastPacket  = 0;
+    chunk.mFirstSample = 0;
+    chunk.mLastSample  = 0;
+    chunk.mBytes       = mHeader.size();
+    chunk.mRecords     = 0;
+    mChunks.push_back( chunk );
+
+    mOut = AnalyzerHelpers::StartFile( chunk.mName.c_str(), mIsBinary );
+    if ( !mHeader.empty() )
+    {
+        AnalyzerHelpers::AppendToFile( (const U8*)mHeader.data(), (U32)mHeader.size(), mOut );
+    }
+}
+
+void RFFEExportFile::EndChunk()
+{
+    if ( mOut != NULL )
+    {
+        AnalyzerHelpers::EndFile( mOut );
+        mOut = NULL;
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef RFFE_EXPORT_FILE
+#define RFFE_EXPORT_FILE
+
+#include <LogicPublicTypes.h>
+#include <string>
+#include <vector>
+
+// Destination of an export. Without a chunk size everything goes to the
+// file picked for the export. With one, the records go to numbered files
+// next to it ("capture.000.csv", "capture.001.csv", ...) of at most that
+// size (but at least one record), each starting with the header, and the
+// picked file becomes a CSV index of the packets and samples in each chunk.
+class RFFEExportFile
+{
+public:
+    RFFEExportFile( const char* file, U64 chunk_bytes, bool is_binary );
+    ~RFFEExportFile();
+
+    void SetHeader( const std::string& header );
+    void Write( const char* record, U32 length, U64 first_packet, U64 last_packet, U64 first_sample, U64 last_sample );
+    void Write( const std::string& record, U64 first_packet, U64 last_packet, U64 first_sample, U64 last_sample )
+    {
+        Write( record.data(), U32( record.size() ), first_packet, last_packet, first_sample, last_sample );
+    }
+    void Finish( U64 trigger_sample, U32 sample_rate );
+
+protected:
+    struct Chunk
+    {
+        std::string mName;
+        U64 mFirstPacket;
+        U64 mLastPacket;
+        U64 mFirstSample;
+        U64 mLastSample;
+        U64 mBytes;
+        U64 mRecords;
+    };
+
+    void StartChunk();
+    void EndChunk();
+
+    std::string mFile;
+    U64 mChunkBytes;        // 0: one file
+    bool mIsBinary;
+    std::string mHeader;
+    void* mOut;             // the file or chunk being written, NULL between chunks
+    std::vector< Chunk > mChunks;
+};
+
+#endif //RFFE_EXPORT_FILE
@@ -0,0 +1,99 @@
+#include "RFFEInstrumentation.h"
+
+#ifdef RFFE_INSTRUMENTATION
+
+#include "RFFEAnalyzerResults.h"
+#include <AnalyzerHelpers.h>
+#include <sstream>
+
+void RFFEInstrumentation::Reset()
+{
+    mSdkCalls     = 0;
+    mEdges        = 0;
+    mResyncs      = 0;
+    mParityErrors = 0;
+    for ( U32 i = 0; i < RFFE_COMMAND_TYPES; i++ )
+    {
+        mPackets[i] = 0;
+    }
+    for ( U32 i = 0; i < PhaseCount; i++ )
+    {
+        mCycles[i] = 0;
+    }
+    mPhase     = PhaseOther;
+    mLastTicks = Ticks();
+}
+
+RFFEInstrumentation::Phase RFFEInstrumentation::Switch( Phase phase )
+{
+    U64 now = Ticks();
+    Phase previous = mPhase;
+
+    mCycles[mPhase] += now - mLastTicks;
+    mLastTicks = now;
+    mPhase = phase;
+
+    return previous;
+}
+
+void RFFEInstrumentation::Dump( const char* file )
+{
+    static const char* phase_names[PhaseCount] =
+    {
+        "other",
+        "start-condition search",
+        "bit extraction",
+        "result commits",
+    };
+    std::stringstream ss;
+    U64 packets = 0;
+    U64 cycles = 0;
+
+    Switch( mPhase );
+
+    for ( U32 i = 0; i < RFFE_COMMAND_TYPES; i++ )
+    {
+        packets += mPackets[i];
+    }
+    for ( U32 i = 0; i < PhaseCount; i++ )
+    {
+        cycles += mCycles[i];
+    }
+
+    ss << "RFFE decoder instrumentation" << std::endl;
+    ss << "SDK calls:       " << mSdkCalls << std::endl;
+    ss << "edges consumed:  " << mEdges << std::endl;
+    ss << "resyncs:         " << mResyncs << std::endl;
+    ss << "parity errors:   " << mParityErrors << std::endl;
+    ss << "packets:         " << packets << std::endl;
+    for ( U32 i = 0; i < RFFE_COMMAND_TYPES; i++ )
+    {
+        ss << "  " << RFFEAnalyzerResults::GetTypeString( i ) << ": " << mPackets[i] << std::endl;
+    }
+    ss << "cycles:          " << cycles << std::endl;
+    for ( U32 i = 0; i < PhaseCount; i++ )
+    {
+        ss << "  " << phase_names[i] << ": " << mCycles[i];
+        if ( cycles != 0 )
+        {
+            ss << " (" << ( 100.0 * double( mCycles[i] ) / double( cycles ) ) << "%";
+            if ( packets != 0 )
+            {
+                ss << ", " << ( mCycles[i] / packets ) << "/packet";
+            }
+            ss << ")";
+        }
+        ss << std::endl;
+    }
+    if ( packets != 0 )
+    {
+        ss << "cycles/packet:   " << ( cycles / packets ) << std::endl;
+        ss << "SDK calls/packet: " << ( mSdkCalls / packets ) << std::endl;
+    }
+
+    void* f = AnalyzerHelpers::StartFile( file );
+    AnalyzerHelpers::AppendToFile( (U8*)ss.str().c_str(), (U32)ss.str().length(), f );
+    AnalyzerHelpers::EndFile( f );
+}
+
+#endif //RFFE_INSTRUMENTATION
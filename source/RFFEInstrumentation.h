@@ -0,0 +1,161 @@
+#ifndef RFFE_INSTRUMENTATION_H
+#define RFFE_INSTRUMENTATION_H
+
+// Hot-path counters and phase timers of the decoder. Only compiled in when
+// RFFE_INSTRUMENTATION is defined (build_analyzer.py --instrumented); in
+// regular builds the RFFE_COUNT/RFFE_PHASE macros expand to nothing and the
+// decoder talks to AnalyzerChannelData directly.
+
+#ifdef RFFE_INSTRUMENTATION
+
+#include <AnalyzerChannelData.h>
+#include "RFFEAnalyzerResults.h"
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#elif defined( __i386__ ) || defined( __x86_64__ )
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+#ifndef RFFE_INSTRUMENTATION_LOG
+#define RFFE_INSTRUMENTATION_LOG "RFFEAnalyzer_instrumentation.txt"
+#endif
+
+class RFFEInstrumentation
+{
+public:
+    enum Phase
+    {
+        PhaseOther,
+        PhaseStartSearch,
+        PhaseBitExtraction,
+        PhaseResultCommit,
+        PhaseCount,
+    };
+
+    void Reset();
+    Phase Switch( Phase phase );
+    void Dump( const char* file );
+
+    static U64 Ticks()
+    {
+#if defined( _MSC_VER ) || defined( __i386__ ) || defined( __x86_64__ )
+        return __rdtsc();
+#else
+        return U64( std::chrono::steady_clock::now().time_since_epoch().count() );
+#endif
+    }
+
+    U64 mSdkCalls;
+    U64 mEdges;
+    U64 mPackets[RFFE_COMMAND_TYPES];
+    U64 mResyncs;
+    U64 mParityErrors;
+    U64 mCycles[PhaseCount];
+
+private:
+    Phase mPhase;
+    U64 mLastTicks;
+};
+
+// attributes the cycles of the enclosing scope to a phase
+class RFFEPhaseScope
+{
+public:
+    RFFEPhaseScope( RFFEInstrumentation& instrumentation, RFFEInstrumentation::Phase phase )
+    :   mInstrumentation( instrumentation ),
+        mPrevious( instrumentation.Switch( phase ) )
+    {
+    }
+    ~RFFEPhaseScope()
+    {
+        mInstrumentation.Switch( mPrevious );
+    }
+
+private:
+    RFFEInstrumentation& mInstrumentation;
+    RFFEInstrumentation::Phase mPrevious;
+};
+
+// AnalyzerChannelData front end counting SDK calls and consumed edges
+class RFFEChannel
+{
+public:
+    void Attach( AnalyzerChannelData* data, RFFEInstrumentation* instrumentation )
+    {
+        mData = data;
+        mInstrumentation = instrumentation;
+    }
+
+    U64 GetSampleNumber()
+    {
+        mInstrumentation->mSdkCalls++;
+        return mData->GetSampleNumber();
+    }
+    BitState GetBitState()
+    {
+        mInstrumentation->mSdkCalls++;
+        return mData->GetBitState();
+    }
+    U32 Advance( U32 num_samples )
+    {
+        mInstrumentation->mSdkCalls++;
+        U32 edges = mData->Advance( num_samples );
+        mInstrumentation->mEdges += edges;
+        return edges;
+    }
+    U32 AdvanceToAbsPosition( U64 sample_number )
+    {
+        mInstrumentation->mSdkCalls++;
+        U32 edges = mData->AdvanceToAbsPosition( sample_number );
+        mInstrumentation->mEdges += edges;
+        return edges;
+    }
+    void AdvanceToNextEdge()
+    {
+        mInstrumentation->mSdkCalls++;
+        mInstrumentation->mEdges++;
+        mData->AdvanceToNextEdge();
+    }
+    U64 GetSampleOfNextEdge()
+    {
+        mInstrumentation->mSdkCalls++;
+        return mData->GetSampleOfNextEdge();
+    }
+    bool WouldAdvancingCauseTransition( U32 num_samples )
+    {
+        mInstrumentation->mSdkCalls++;
+        return mData->WouldAdvancingCauseTransition( num_samples );
+    }
+    bool WouldAdvancingToAbsPositionCauseTransition( U64 sample_number )
+    {
+        mInstrumentation->mSdkCalls++;
+        return mData->WouldAdvancingToAbsPositionCauseTransition( sample_number );
+    }
+    bool DoMoreTransitionsExistInCurrentData()
+    {
+        mInstrumentation->mSdkCalls++;
+        return mData->DoMoreTransitionsExistInCurrentData();
+    }
+
+private:
+    AnalyzerChannelData* mData;
+    RFFEInstrumentation* mInstrumentation;
+};
+
+#define RFFE_COUNT( counter )   ( mInstrumentation.counter++ )
+#define RFFE_PHASE( phase )     RFFEPhaseScope rffe_phase_scope( mInstrumentation, RFFEInstrumentation::phase )
+
+#else
+
+class AnalyzerChannelData;
+typedef AnalyzerChannelData RFFEChannel;
+
+#define RFFE_COUNT( counter )
+#define RFFE_PHASE( phase )
+
+#endif //RFFE_INSTRUMENTATION
+
+#endif //RFFE_INSTRUMENTATION_H
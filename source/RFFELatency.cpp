@@ -0,0 +1,253 @@
+#include "RFFELatency.h"
+#include "RFFEAnalyzerSettings.h"
+#include <AnalyzerChannelData.h>
+#include <AnalyzerHelpers.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+RFFELatency::RFFELatency()
+:   mSettings( NULL ),
+    mEvent( NULL ),
+    mSampleRateHz( 0.0 ),
+    mEdgeCount( 0 ),
+    mDroppedSample( 0 ),
+    mPackets( 0 ),
+    mMissed( 0 ),
+    mMin( 0 ),
+    mMax( 0 ),
+    mSum( 0 )
+{
+}
+
+RFFELatency::~RFFELatency()
+{
+}
+
+void RFFELatency::Start( const RFFEAnalyzerSettings* settings, U32 sample_rate_hz )
+{
+    mSettings      = settings;
+    mEvent         = NULL;
+    mSampleRateHz  = double( sample_rate_hz );
+    mEdgeCount     = 0;
+    mDroppedSample = 0;
+    mPackets       = 0;
+    mMissed        = 0;
+    mMin           = 0;
+    mMax           = 0;
+    mSum           = 0;
+    for ( U32 i = 0; i < RFFE_LATENCY_BINS; i++ )
+    {
+        mBins[i] = 0;
+    }
+}
+
+// the event channel of this decode; a resumed decode goes on with the edges
+// walked by the last one
+void RFFELatency::Attach( AnalyzerChannelData* event, U64 from_sample )
+{
+    mEvent = event;
+    if ( from_sample > mEvent->GetSampleNumber() )
+    {
+        mEvent->AdvanceToAbsPosition( from_sample );
+    }
+}
+
+U64 RFFELatency::Measure( const RFFEPacket& packet )
+{
+    U64 edge;
+
+    if ( !mSettings->IsEventPacket( packet.mSlaveAddress, packet.mAddress ) )
+    {
+        return RFFE_NO_EVENT_DELAY;
+    }
+
+    mPackets++;
+    if ( !FindEdge( packet.mEndingSample, &edge ) )
+    {
+        mMissed++;
+        return RFFE_EVENT_MISSED;
+    }
+
+    U64 delay = edge - packet.mEndingSample;
+    if ( mPackets - mMissed == 1 || delay < mMin )
+        mMin = delay;
+    if ( mPackets - mMissed == 1 || delay > mMax )
+        mMax = delay;
+    mSum += delay;
+    mBins[GetBin( delay )]++;
+    return delay;
+}
+
+bool RFFELatency::IsEventEdge( BitState state ) const
+{
+    switch ( mSettings->mEventEdge )
+    {
+    case RFFEAnalyzerSettings::EventEdgeRising:
+        return state == BIT_HIGH;
+    case RFFEAnalyzerSettings::EventEdgeFalling:
+        return state == BIT_LOW;
+    default:
+        return true;
+    }
+}
+
+// The first event edge at or after a packet end. Edges are only walked as
+// far as the capture goes; one that is not there (yet) is no event.
+bool RFFELatency::FindEdge( U64 after, U64* edge )
+{
+    // the ring lost edges after the packet end, the first of them is gone
+    if ( mEdgeCount > RFFE_LATENCY_EDGES && mDroppedSample >= after )
+    {
+        return false;
+    }
+
+    // edges in the ring are in order: the first one not before the end
+    U64 low  = mEdgeCount > RFFE_LATENCY_EDGES ? mEdgeCount - RFFE_LATENCY_EDGES : 0;
+    U64 high = mEdgeCount;
+    while ( low < high )
+    {
+        U64 middle = low + ( high - low ) / 2;
+        if ( mEdgeSample[middle % RFFE_LATENCY_EDGES] < after )
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    for ( ; low < mEdgeCount; low++ )
+    {
+        if ( IsEventEdge( BitState( mEdgeState[low % RFFE_LATENCY_EDGES] ) ) )
+        {
+            *edge = mEdgeSample[low % RFFE_LATENCY_EDGES];
+            return true;
+        }
+    }
+
+    while ( mEvent->DoMoreTransitionsExistInCurrentData() )
+    {
+        mEvent->AdvanceToNextEdge();
+
+        U32 slot = U32( mEdgeCount++ % RFFE_LATENCY_EDGES );
+        if ( mEdgeCount > RFFE_LATENCY_EDGES )
+        {
+            mDroppedSample = mEdgeSample[slot];
+        }
+        mEdgeSample[slot] = mEvent->GetSampleNumber();
+        mEdgeState[slot]  = U8( mEvent->GetBitState() );
+
+        if ( mEdgeSample[slot] >= after && IsEventEdge( mEvent->GetBitState() ) )
+        {
+            *edge = mEdgeSample[slot];
+            return true;
+        }
+    }
+    return false;
+}
+
+U32 RFFELatency::GetBin( U64 samples )
+{
+    U32 octave = 63;
+
+    if ( samples < RFFE_LATENCY_SUB_BINS )
+    {
+        return U32( samples );
+    }
+    while ( ( samples >> octave ) == 0 )
+    {
+        octave--;
+    }
+    return ( octave - 2 ) * RFFE_LATENCY_SUB_BINS + U32( ( samples >> ( octave - 3 ) ) & ( RFFE_LATENCY_SUB_BINS - 1 ) );
+}
+
+U64 RFFELatency::GetBinStart( U32 bin )
+{
+    if ( bin < RFFE_LATENCY_SUB_BINS )
+    {
+        return bin;
+    }
+    U32 octave = bin / RFFE_LATENCY_SUB_BINS + 2;
+    return U64( RFFE_LATENCY_SUB_BINS + bin % RFFE_LATENCY_SUB_BINS ) << ( octave - 3 );
+}
+
+// the middle of the bin holding the given fraction of the latencies,
+// within the measured range
+U64 RFFELatency::GetPercentile( double fraction ) const
+{
+    U64 count = mPackets - mMissed;
+    U64 rank = U64( fraction * double( count ) + 0.999999 );
+    U64 seen = 0;
+
+    for ( U32 bin = 0; bin < RFFE_LATENCY_BINS; bin++ )
+    {
+        seen += mBins[bin];
+        if ( seen >= rank && mBins[bin] != 0 )
+        {
+            U64 width = bin < RFFE_LATENCY_SUB_BINS ? 1 : U64( 1 ) << ( bin / RFFE_LATENCY_SUB_BINS - 1 );
+            U64 value = GetBinStart( bin ) + width / 2;
+            return std::min( std::max( value, mMin ), mMax );
+        }
+    }
+    return mMax;
+}
+
+void RFFELatency::Describe( std::ostream& os, U64 samples )
+{
+    os << std::fixed << std::setprecision( 3 ) << double( samples ) * 1e6 / mSampleRateHz;
+}
+
+void RFFELatency::Finish( const char* report_file )
+{
+    static const char* EdgeNames[] = { "any edge", "rising edge", "falling edge" };
+    std::stringstream ss;
+    U64 measured = mPackets - mMissed;
+
+    if ( report_file == NULL || report_file[0] == '\0' )
+    {
+        return;
+    }
+
+    ss << "RFFE command to event latency" << std::endl;
+    ss << "sample rate:        " << mSampleRateHz / 1e6 << " MHz" << std::endl;
+    ss << "event channel:      " << mSettings->mEventChannel.mChannelIndex << ", "
+       << EdgeNames[mSettings->mEventEdge % 3] << std::endl;
+    ss << "event packets:      " << ( mSettings->mEventPackets.empty() ? "all" : mSettings->mEventPackets.c_str() ) << std::endl;
+    ss << "packets:            " << mPackets << std::endl;
+    ss << "no event edge:      " << mMissed << std::endl;
+    if ( measured != 0 )
+    {
+        ss << "latency:            min ";
+        Describe( ss, mMin );
+        ss << "  avg ";
+        Describe( ss, ( mSum + measured / 2 ) / measured );
+        ss << "  max ";
+        Describe( ss, mMax );
+        ss << " us  (" << measured << ")" << std::endl;
+        ss << "percentiles:        p50 ";
+        Describe( ss, GetPercentile( 0.50 ) );
+        ss << "  p90 ";
+        Describe( ss, GetPercentile( 0.90 ) );
+        ss << "  p99 ";
+        Describe( ss, GetPercentile( 0.99 ) );
+        ss << " us" << std::endl;
+
+        // bins from the first to the last one used, each from its start
+        U32 first = GetBin( mMin );
+        U32 last  = GetBin( mMax );
+        U64 largest = 0;
+        for ( U32 bin = first; bin <= last; bin++ )
+        {
+            largest = std::max( largest, mBins[bin] );
+        }
+        ss << "histogram [us]:" << std::endl;
+        for ( U32 bin = first; bin <= last; bin++ )
+        {
+            std::ostringstream start;
+            Describe( start, GetBinStart( bin ) );
+            ss << std::right << std::setw( 14 ) << start.str() << std::setw( 12 ) << mBins[bin] << "  "
+               << std::string( size_t( ( mBins[bin] * 40 + largest - 1 ) / largest ), '#' ) << std::endl;
+        }
+    }
+
+    void* f = AnalyzerHelpers::StartFile( report_file );
+    AnalyzerHelpers::AppendToFile( (U8*)ss.str().c_str(), (U32)ss.str().length(), f );
+    AnalyzerHelpers::EndFile( f );
+}
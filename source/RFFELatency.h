@@ -0,0 +1,62 @@
+#ifndef RFFE_LATENCY
+#define RFFE_LATENCY
+
+#include <LogicPublicTypes.h>
+#include <iosfwd>
+#include "RFFEPacket.h"
+
+class AnalyzerChannelData;
+class RFFEAnalyzerSettings;
+
+// histogram bins of the latency in samples: exact below 8, then 8 per
+// power of two (within 12.5% of the value)
+#define RFFE_LATENCY_SUB_BINS   8
+#define RFFE_LATENCY_BINS       ( 62 * RFFE_LATENCY_SUB_BINS )
+
+// event edges kept behind the packet ends, for buses whose packets end in
+// a different order than their SSCs
+#define RFFE_LATENCY_EDGES      64
+
+// Command to event latency: from the end of an event packet to the next
+// edge of the event channel. The channel is walked forward as the packets
+// come, in the same pass as the bus, so the latency costs one edge step per
+// event transition and a histogram bin per packet.
+class RFFELatency
+{
+public:
+    RFFELatency();
+    ~RFFELatency();
+
+    void Start( const RFFEAnalyzerSettings* settings, U32 sample_rate_hz );
+    void Attach( AnalyzerChannelData* event, U64 from_sample );
+    U64  Measure( const RFFEPacket& packet );  // RFFEPacket::mEventDelay of the packet
+    void Finish( const char* report_file );
+
+protected: // functions
+    bool FindEdge( U64 after, U64* edge );
+    bool IsEventEdge( BitState state ) const;
+    static U32 GetBin( U64 samples );
+    static U64 GetBinStart( U32 bin );
+    U64  GetPercentile( double fraction ) const;
+    void Describe( std::ostream& os, U64 samples );
+
+protected: // vars
+    const RFFEAnalyzerSettings* mSettings;
+    AnalyzerChannelData* mEvent;
+    double mSampleRateHz;
+
+    // event edges walked so far, the newest RFFE_LATENCY_EDGES of them
+    U64 mEdgeSample[RFFE_LATENCY_EDGES];
+    U8  mEdgeState[RFFE_LATENCY_EDGES];
+    U64 mEdgeCount;
+    U64 mDroppedSample;     // last edge pushed out of the ring, 0 while none was
+
+    U64 mPackets;
+    U64 mMissed;            // event packets no edge followed
+    U64 mMin;
+    U64 mMax;
+    U64 mSum;
+    U64 mBins[RFFE_LATENCY_BINS];
+};
+
+#endif //RFFE_LATENCY
@@ -0,0 +1,72 @@
+#ifndef RFFE_PACKET
+#define RFFE_PACKET
+
+#include <LogicPublicTypes.h>
+
+// SCLK/SDATA pairs one analyzer decodes; the bus of a frame is kept in
+// the low bits of Frame::mFlags, which the SDK leaves to the analyzer, and
+// the slave address of its packet in the bits above
+#define RFFE_MAX_BUSES          4
+#define RFFE_FRAME_BUS_MASK     0x03
+#define RFFE_FRAME_SA_SHIFT     2
+#define RFFE_FRAME_SA( flags )  U8( ( ( flags ) >> RFFE_FRAME_SA_SHIFT ) & 0x0F )
+
+// Content of one RFFE packet as seen on the bus, independent of how the
+// analyzer draws it. Filled in by the simulation data generator (ground
+// truth) as well as by the decoder.
+struct RFFEPacket
+{
+    U64 mStartingSample;    // rising edge of SDATA in the SSC
+    U64 mEndingSample;      // end of the closing bus park
+    U8  mBus;               // SCLK/SDATA pair the packet was seen on
+    U8  mSlaveAddress;
+    U8  mCommand;           // lower 8 bits of the command frame
+    U8  mType;              // RFFEAnalyzerResults::RffeTypeFieldType
+    U8  mByteCount;         // number of payload bytes in mData
+    U16 mAddress;
+    U8  mData[16];
+    U8  mParityCount;       // number of parity bits in mParity
+    U32 mParity;            // parity bit of frame i in bit i, command frame first
+    U32 mParityErrors;      // bit i set when the parity of frame i is wrong
+    U32 mSclkFrequency;     // measured average SCLK frequency in Hz, 0 if not measured
+    U8  mDutyCycle;         // measured SCLK high time in percent of the period
+    U8  mTimingViolations;  // RFFETiming::Violation bits
+    U64 mEventDelay;        // samples from mEndingSample to the event edge, or RFFE_*EVENT* below
+};
+
+// RFFEPacket::mEventDelay of a packet not measured against the event
+// channel, and of one measured that no event edge followed
+#define RFFE_NO_EVENT_DELAY     U64( -1 )
+#define RFFE_EVENT_MISSED       U64( -2 )
+
+// longest packet: extended read of 16 bytes, 168 SCLK cycles
+#define RFFE_MAX_PACKET_BITS    176
+#define RFFE_MAX_PACKET_FRAMES  48
+
+// A frame of the packet being decoded, waiting to be committed
+struct RFFEPacketFrame
+{
+    U64 mStartingSample;
+    U64 mEndingSample;
+    U64 mData1;
+    U64 mData2;
+    U8  mType;
+    U8  mFlags;
+    U8  mFirstBit;          // bits of RFFEPacketTrace that get markers
+    U8  mBitCount;
+};
+
+// Bit timing and frames of the packet being decoded. Nothing goes to the
+// results before the packet is complete, so a packet can still be dropped.
+struct RFFEPacketTrace
+{
+    U32 mBitCount;
+    U64 mBitClk[RFFE_MAX_PACKET_BITS + 1];  // rising SCLK edge starting bit i
+    U64 mBitSample[RFFE_MAX_PACKET_BITS];   // falling SCLK edge SDATA is sampled at
+    U8  mBitMarker[RFFE_MAX_PACKET_BITS];   // AnalyzerResults::MarkerType drawn on SDATA
+    U8  mBitFlags[RFFE_MAX_PACKET_BITS];    // frame flags raised by this bit
+    U32 mFrameCount;
+    RFFEPacketFrame mFrames[RFFE_MAX_PACKET_FRAMES];
+};
+
+#endif //RFFE_PACKET
@@ -0,0 +1,75 @@
+#include "RFFEPacketRing.h"
+#include <string.h>
+
+RFFEPacketRing::RFFEPacketRing()
+:   mEntries( RFFE_PACKET_RING_SIZE ),
+    mHead( 0 ),
+    mTail( 0 ),
+    mClosed( false )
+{
+}
+
+RFFEPacketRing::~RFFEPacketRing()
+{
+}
+
+// only while neither thread is using the ring
+void RFFEPacketRing::Reset()
+{
+    mHead.store( 0 );
+    mTail.store( 0 );
+    mClosed.store( false );
+}
+
+bool RFFEPacketRing::TryPush( const RFFEPacket& packet, const RFFEPacketTrace& trace )
+{
+    U32 tail = mTail.load( std::memory_order_relaxed );
+
+    if ( tail - mHead.load( std::memory_order_acquire ) == RFFE_PACKET_RING_SIZE )
+    {
+        return false;
+    }
+
+    // copy the used part of the trace only, most packets are short
+    Entry& entry = mEntries[tail % RFFE_PACKET_RING_SIZE];
+    U32 bits = trace.mBitCount;
+
+    entry.mPacket = packet;
+    entry.mTrace.mBitCount   = bits;
+    entry.mTrace.mFrameCount = trace.mFrameCount;
+    memcpy( entry.mTrace.mBitClk, trace.mBitClk, ( bits + 1 ) * sizeof( trace.mBitClk[0] ) );
+    memcpy( entry.mTrace.mBitSample, trace.mBitSample, bits * sizeof( trace.mBitSample[0] ) );
+    memcpy( entry.mTrace.mBitMarker, trace.mBitMarker, bits * sizeof( trace.mBitMarker[0] ) );
+    memcpy( entry.mTrace.mBitFlags, trace.mBitFlags, bits * sizeof( trace.mBitFlags[0] ) );
+    memcpy( entry.mTrace.mFrames, trace.mFrames, trace.mFrameCount * sizeof( trace.mFrames[0] ) );
+
+    mTail.store( tail + 1, std::memory_order_release );
+    return true;
+}
+
+// no more packets will be pushed
+void RFFEPacketRing::Close()
+{
+    mClosed.store( true, std::memory_order_release );
+}
+
+const RFFEPacketRing::Entry* RFFEPacketRing::Front()
+{
+    U32 head = mHead.load( std::memory_order_relaxed );
+
+    if ( head == mTail.load( std::memory_order_acquire ) )
+    {
+        return NULL;
+    }
+    return &mEntries[head % RFFE_PACKET_RING_SIZE];
+}
+
+void RFFEPacketRing::Pop()
+{
+    mHead.store( mHead.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+}
+
+bool RFFEPacketRing::IsClosed() const
+{
+    return mClosed.load( std::memory_order_acquire );
+}
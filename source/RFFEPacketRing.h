@@ -0,0 +1,45 @@
+#ifndef RFFE_PACKET_RING
+#define RFFE_PACKET_RING
+
+#include <LogicPublicTypes.h>
+#include <atomic>
+#include <vector>
+#include "RFFEPacket.h"
+
+// decoded packets the extraction thread may run ahead of the result builder
+#define RFFE_PACKET_RING_SIZE   64
+
+// Single-producer/single-consumer queue of decoded packets between the bit
+// extraction thread and the thread building frames and markers. Neither
+// side takes a lock; each index is only written by its own side.
+class RFFEPacketRing
+{
+public:
+    struct Entry
+    {
+        RFFEPacket mPacket;
+        RFFEPacketTrace mTrace;
+    };
+
+    RFFEPacketRing();
+    ~RFFEPacketRing();
+
+    void Reset();
+
+    // producer side
+    bool TryPush( const RFFEPacket& packet, const RFFEPacketTrace& trace );
+    void Close();
+
+    // consumer side, Front() returns NULL when the ring is empty
+    const Entry* Front();
+    void Pop();
+    bool IsClosed() const;
+
+protected:
+    std::vector< Entry > mEntries;
+    std::atomic< U32 > mHead;       // next entry to pop, written by the consumer
+    std::atomic< U32 > mTail;       // next entry to push, written by the producer
+    std::atomic< bool > mClosed;
+};
+
+#endif //RFFE_PACKET_RING
@@ -0,0 +1,205 @@
+#include "RFFEPcapng.h"
+#include "RFFEAnalyzerResults.h"
+#include "RFFETiming.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+
+#define PCAPNG_SECTION_HEADER_BLOCK     0x0A0D0D0A
+#define PCAPNG_INTERFACE_BLOCK          0x00000001
+#define PCAPNG_ENHANCED_PACKET_BLOCK    0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC         0x1A2B3C4D
+
+#define PCAPNG_OPT_ENDOFOPT             0
+#define PCAPNG_OPT_COMMENT              1
+#define PCAPNG_SHB_USERAPPL             4
+#define PCAPNG_IF_NAME                  2
+#define PCAPNG_IF_TSRESOL               9
+
+// largest packet block: header, payload and a comment, with room to spare
+#define PCAPNG_MAX_PACKET_BLOCK         256
+
+// block fields go out little endian (the byte order magic says so), the
+// RFFE payload big endian
+static U8* Put16( U8* p, U16 value )
+{
+    p[0] = U8( value );
+    p[1] = U8( value >> 8 );
+    return p + 2;
+}
+
+static U8* Put32( U8* p, U32 value )
+{
+    p = Put16( p, U16( value ) );
+    return Put16( p, U16( value >> 16 ) );
+}
+
+static U8* PutBig16( U8* p, U16 value )
+{
+    p[0] = U8( value >> 8 );
+    p[1] = U8( value );
+    return p + 2;
+}
+
+static U8* PutBig32( U8* p, U32 value )
+{
+    p = PutBig16( p, U16( value >> 16 ) );
+    return PutBig16( p, U16( value ) );
+}
+
+static U8* PutOption( U8* p, U16 code, const void* value, U16 length )
+{
+    p = Put16( p, code );
+    p = Put16( p, length );
+    std::copy( (const U8*)value, (const U8*)value + length, p );
+    std::fill( p + length, p + ( ( length + 3 ) & ~3 ), U8( 0 ) );
+    return p + ( ( length + 3 ) & ~3 );
+}
+
+// fills in the total length at both ends of the block from start to p
+static U8* EndBlock( U8* start, U8* p )
+{
+    U32 length = U32( p - start ) + 4;
+    Put32( start + 4, length );
+    return Put32( p, length );
+}
+
+// section header and interface description, at the start of every file
+static std::string GetHeader()
+{
+    static const char application[] = "Saleae RFFE Analyzer";
+    static const char interface_name[] = "RFFE";
+    U8 tsresol = 9;     // 10^-9 s
+    U8 header[128];
+    U8* p = header;
+    U8* block = p;
+
+    p = Put32( p, PCAPNG_SECTION_HEADER_BLOCK );
+    p = Put32( p, 0 );
+    p = Put32( p, PCAPNG_BYTE_ORDER_MAGIC );
+    p = Put16( p, 1 );                  // version 1.0
+    p = Put16( p, 0 );
+    p = Put32( p, 0xFFFFFFFF );         // section length not given
+    p = Put32( p, 0xFFFFFFFF );
+    p = PutOption( p, PCAPNG_SHB_USERAPPL, application, sizeof( application ) - 1 );
+    p = PutOption( p, PCAPNG_OPT_ENDOFOPT, NULL, 0 );
+    p = EndBlock( block, p );
+
+    block = p;
+    p = Put32( p, PCAPNG_INTERFACE_BLOCK );
+    p = Put32( p, 0 );
+    p = Put16( p, RFFE_PCAPNG_LINKTYPE );
+    p = Put16( p, 0 );
+    p = Put32( p, 0 );                  // no snap length
+    p = PutOption( p, PCAPNG_IF_NAME, interface_name, sizeof( interface_name ) - 1 );
+    p = PutOption( p, PCAPNG_IF_TSRESOL, &tsresol, 1 );
+    p = PutOption( p, PCAPNG_OPT_ENDOFOPT, NULL, 0 );
+    p = EndBlock( block, p );
+
+    return std::string( (const char*)header, p - header );
+}
+
+RFFEPcapngWriter::RFFEPcapngWriter( const char* file, U64 chunk_bytes )
+:   mOut( file, chunk_bytes, true ),
+    mLength( 0 ),
+    mFirstPacket( 0 ),
+    mLastPacket( 0 ),
+    mFirstSample( 0 ),
+    mLastSample( 0 )
+{
+    U64 buffer_size = RFFE_PCAPNG_BUFFER_SIZE;
+
+    // several writes per chunk, so chunks come out close to their size
+    if ( chunk_bytes != 0 )
+    {
+        buffer_size = std::min< U64 >( buffer_size, chunk_bytes / 4 );
+    }
+    mBuffer.resize( size_t( std::max< U64 >( buffer_size, 4 * PCAPNG_MAX_PACKET_BLOCK ) ) );
+    mOut.SetHeader( GetHeader() );
+}
+
+void RFFEPcapngWriter::Add( U64 packet_id, const RFFEPacket& packet, const RFFEPacketExtras& extras, U64 timestamp_ns )
+{
+    if ( mLength + PCAPNG_MAX_PACKET_BLOCK > mBuffer.size() )
+    {
+        Flush();
+    }
+    if ( mLength == 0 )
+    {
+        mFirstPacket = packet_id;
+        mFirstSample = packet.mStartingSample;
+    }
+    mLastPacket = packet_id;
+    mLastSample = extras.mRepeats != 0 ? extras.mLastStart : packet.mStartingSample;
+
+    U8 flags = 0;
+    if ( extras.mHasAddress )
+        flags |= RFFE_PCAPNG_FLAG_ADDRESS;
+    if ( packet.mParityErrors != 0 )
+        flags |= RFFE_PCAPNG_FLAG_PARITY;
+    if ( packet.mTimingViolations & RFFETiming::ViolationSclkFrequency )
+        flags |= RFFE_PCAPNG_FLAG_SCLK;
+    if ( packet.mTimingViolations & RFFETiming::ViolationSetup )
+        flags |= RFFE_PCAPNG_FLAG_SETUP;
+    if ( packet.mTimingViolations & RFFETiming::ViolationHold )
+        flags |= RFFE_PCAPNG_FLAG_HOLD;
+    if ( extras.mErrorFrames != 0 )
+        flags |= RFFE_PCAPNG_FLAG_DECODE;
+    if ( extras.mRepeats != 0 )
+        flags |= RFFE_PCAPNG_FLAG_REPEATED;
+
+    U32 length = RFFE_PCAPNG_HEADER_SIZE + packet.mByteCount;
+    U8* block = &mBuffer[mLength];
+    U8* p = block;
+
+    p = Put32( p, PCAPNG_ENHANCED_PACKET_BLOCK );
+    p = Put32( p, 0 );
+    p = Put32( p, 0 );                  // interface
+    p = Put32( p, U32( timestamp_ns >> 32 ) );
+    p = Put32( p, U32( timestamp_ns ) );
+    p = Put32( p, length );             // captured
+    p = Put32( p, length );             // on the bus
+
+    U8* payload = p;
+    *p++ = RFFE_PCAPNG_VERSION;
+    *p++ = packet.mBus;
+    *p++ = packet.mSlaveAddress;
+    *p++ = packet.mCommand;
+    *p++ = packet.mType;
+    *p++ = flags;
+    p = PutBig16( p, extras.mHasAddress ? packet.mAddress : 0 );
+    *p++ = packet.mByteCount;
+    *p++ = packet.mParityCount;
+    p = PutBig32( p, packet.mParity );
+    p = PutBig32( p, packet.mParityErrors );
+    p = std::copy( packet.mData, packet.mData + packet.mByteCount, p );
+    while ( ( p - payload ) & 3 )
+        *p++ = 0;
+
+    if ( extras.mRepeats != 0 )
+    {
+        char comment[64];
+        int n = sprintf_s( comment, sizeof( comment ), "%u identical packets, last at sample %llu",
+                           1 + extras.mRepeats, (unsigned long long)extras.mLastStart );
+        p = PutOption( p, PCAPNG_OPT_COMMENT, comment, U16( n ) );
+        p = PutOption( p, PCAPNG_OPT_ENDOFOPT, NULL, 0 );
+    }
+    p = EndBlock( block, p );
+
+    mLength = U32( p - &mBuffer[0] );
+}
+
+void RFFEPcapngWriter::Finish( U64 trigger_sample, U32 sample_rate )
+{
+    Flush();
+    mOut.Finish( trigger_sample, sample_rate );
+}
+
+void RFFEPcapngWriter::Flush()
+{
+    if ( mLength != 0 )
+    {
+        mOut.Write( (const char*)&mBuffer[0], mLength, mFirstPacket, mLastPacket, mFirstSample, mLastSample );
+        mLength = 0;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef RFFE_PCAPNG
+#define RFFE_PCAPNG
+
+#include <LogicPublicTypes.h>
+#include <vector>
+#include "RFFEExportFile.h"
+#include "RFFEPacket.h"
+
+struct RFFEPacketExtras;
+
+// LINKTYPE_USER0, the first of the link types reserved for private use
+#define RFFE_PCAPNG_LINKTYPE        147
+#define RFFE_PCAPNG_VERSION         1
+#define RFFE_PCAPNG_BUFFER_SIZE     ( 1 << 20 )
+
+// payload of a packet block, multi-byte fields big endian:
+//  0  version (RFFE_PCAPNG_VERSION)
+//  1  bus
+//  2  slave address
+//  3  lower 8 bits of the command frame
+//  4  RFFEAnalyzerResults::RffeTypeFieldType
+//  5  RFFE_PCAPNG_FLAG_* bits
+//  6  register address (16 bits, 0 without one)
+//  8  byte count
+//  9  number of parity bits
+// 10  parity bits (32 bits, bit i for frame i, command frame first)
+// 14  parity error bits (32 bits, same order)
+// 18  payload bytes
+#define RFFE_PCAPNG_HEADER_SIZE     18
+
+#define RFFE_PCAPNG_FLAG_ADDRESS    0x01    // the packet has a register address
+#define RFFE_PCAPNG_FLAG_PARITY     0x02    // some parity bit is wrong
+#define RFFE_PCAPNG_FLAG_SCLK       0x04    // SCLK faster than the limit
+#define RFFE_PCAPNG_FLAG_SETUP      0x08    // SDATA setup below the limit
+#define RFFE_PCAPNG_FLAG_HOLD       0x10    // SDATA hold below the limit
+#define RFFE_PCAPNG_FLAG_DECODE     0x20    // the decoder lost track inside the packet
+#define RFFE_PCAPNG_FLAG_REPEATED   0x40    // identical packets collapsed after this one
+
+// Writes packets as a pcapng file with one interface of link type
+// RFFE_PCAPNG_LINKTYPE and nanosecond timestamps from the start of the
+// capture. Blocks are formatted into a buffer that goes to the file in
+// writes of RFFE_PCAPNG_BUFFER_SIZE (smaller for small chunks); every
+// chunk of a chunked export starts with its own section and interface.
+class RFFEPcapngWriter
+{
+public:
+    RFFEPcapngWriter( const char* file, U64 chunk_bytes );
+
+    void Add( U64 packet_id, const RFFEPacket& packet, const RFFEPacketExtras& extras, U64 timestamp_ns );
+    void Finish( U64 trigger_sample, U32 sample_rate );
+
+protected:
+    void Flush();
+
+    RFFEExportFile mOut;
+    std::vector< U8 > mBuffer;
+    U32 mLength;
+    U64 mFirstPacket;
+    U64 mLastPacket;
+    U64 mFirstSample;
+    U64 mLastSample;
+};
+
+#endif //RFFE_PCAPNG
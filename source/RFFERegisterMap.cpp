@@ -0,0 +1,587 @@
+#include "RFFERegisterMap.h"
+#include <AnalyzerHelpers.h>
+#include <ctype.h>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+
+// "*" or an empty text: the register exists at every slave address
+#define RFFE_ANY_SLAVE_ADDRESS  -1
+
+static std::string Trim( const std::string& text )
+{
+    size_t first = 0;
+    size_t last = text.size();
+
+    while ( first < last && isspace( (unsigned char)text[first] ) )
+        first++;
+    while ( last > first && isspace( (unsigned char)text[last - 1] ) )
+        last--;
+    if ( last - first >= 2 && text[first] == '"' && text[last - 1] == '"' )
+    {
+        first++;
+        last--;
+    }
+    return text.substr( first, last - first );
+}
+
+// a number in C notation (0x1C, 28) or "*" for all slave addresses
+static bool ParseNumber( const std::string& text, U32 max, bool any_allowed, S32* value )
+{
+    std::string trimmed = Trim( text );
+    char* end;
+
+    if ( any_allowed && ( trimmed.empty() || trimmed == "*" ) )
+    {
+        *value = RFFE_ANY_SLAVE_ADDRESS;
+        return true;
+    }
+    if ( trimmed.empty() || !isdigit( (unsigned char)trimmed[0] ) )
+        return false;
+    unsigned long number = strtoul( trimmed.c_str(), &end, 0 );
+    if ( *end != '\0' || number > max )
+        return false;
+    *value = S32( number );
+    return true;
+}
+
+static bool CopyName( const std::string& name, char* dest, U32 size )
+{
+    if ( name.empty() || name.size() >= size )
+        return false;
+    for ( size_t i = 0; i < name.size(); i++ )
+    {
+        // names go into CSV exports and bubbles as they are
+        if ( name[i] == ',' || name[i] == '"' || isspace( (unsigned char)name[i] ) )
+            return false;
+    }
+    memcpy( dest, name.c_str(), name.size() + 1 );
+    return true;
+}
+
+static bool AddField( RFFERegister* reg, const std::string& name, S32 msb, S32 lsb, std::string* error )
+{
+    if ( reg->mFieldCount == RFFE_MAX_REGISTER_FIELDS )
+    {
+        *error = "more than 8 fields";
+        return false;
+    }
+    if ( msb < lsb )
+    {
+        S32 bit = msb;
+        msb = lsb;
+        lsb = bit;
+    }
+
+    RFFERegisterField& field = reg->mFields[reg->mFieldCount++];
+    if ( !CopyName( name, field.mName, RFFE_FIELD_NAME_LENGTH ) )
+    {
+        *error = "bad field name \"" + name + "\"";
+        return false;
+    }
+    field.mMsb = U8( msb );
+    field.mLsb = U8( lsb );
+    return true;
+}
+
+// "MODE[6:4]" or "EN[7]"
+static bool ParseFieldSpec( RFFERegister* reg, const std::string& spec, std::string* error )
+{
+    size_t open = spec.find( '[' );
+    size_t colon = spec.find( ':', open );
+    size_t close = spec.find( ']', open );
+    S32 msb;
+    S32 lsb;
+
+    if ( open == std::string::npos || close != spec.size() - 1 )
+    {
+        *error = "expected NAME[msb:lsb] or NAME[bit] instead of \"" + spec + "\"";
+        return false;
+    }
+    if ( colon == std::string::npos || colon > close )
+        colon = close;
+    if ( !ParseNumber( spec.substr( open + 1, colon - open - 1 ), 7, false, &msb ) )
+    {
+        *error = "bad bit number in \"" + spec + "\"";
+        return false;
+    }
+    lsb = msb;
+    if ( colon != close && !ParseNumber( spec.substr( colon + 1, close - colon - 1 ), 7, false, &lsb ) )
+    {
+        *error = "bad bit number in \"" + spec + "\"";
+        return false;
+    }
+    return AddField( reg, Trim( spec.substr( 0, open ) ), msb, lsb, error );
+}
+
+// field specs separated by blanks or ';'
+static bool ParseFieldList( RFFERegister* reg, const std::string& list, std::string* error )
+{
+    size_t pos = 0;
+
+    while ( pos < list.size() )
+    {
+        if ( isspace( (unsigned char)list[pos] ) || list[pos] == ';' )
+        {
+            pos++;
+            continue;
+        }
+        size_t end = pos;
+        while ( end < list.size() && !isspace( (unsigned char)list[end] ) && list[end] != ';' )
+            end++;
+        if ( !ParseFieldSpec( reg, list.substr( pos, end - pos ), error ) )
+            return false;
+        pos = end;
+    }
+    return true;
+}
+
+static void InitRegister( RFFERegister* reg )
+{
+    memset( reg, 0, sizeof( *reg ) );
+}
+
+
+// Just enough JSON for a register map: an array of register objects, on its
+// own or as "registers" of the top level object. Unknown keys are skipped.
+class RFFEJsonReader
+{
+public:
+    RFFEJsonReader( const std::string& text )
+    :   mText( text ),
+        mPos( 0 )
+    {
+    }
+
+    U32 GetLine() const
+    {
+        U32 line = 1;
+        for ( size_t i = 0; i < mPos && i < mText.size(); i++ )
+        {
+            if ( mText[i] == '\n' )
+                line++;
+        }
+        return line;
+    }
+
+    char Peek()
+    {
+        while ( mPos < mText.size() && isspace( (unsigned char)mText[mPos] ) )
+            mPos++;
+        return mPos < mText.size() ? mText[mPos] : '\0';
+    }
+
+    bool Accept( char c )
+    {
+        if ( Peek() != c )
+            return false;
+        mPos++;
+        return true;
+    }
+
+    bool ReadString( std::string* text )
+    {
+        if ( !Accept( '"' ) )
+            return false;
+        text->clear();
+        while ( mPos < mText.size() && mText[mPos] != '"' )
+        {
+            if ( mText[mPos] == '\\' && mPos + 1 < mText.size() )
+                mPos++;
+            *text += mText[mPos++];
+        }
+        return Accept( '"' );
+    }
+
+    // a string, or the text of a number, true, false or null
+    bool ReadScalar( std::string* text )
+    {
+        if ( Peek() == '"' )
+            return ReadString( text );
+        size_t start = mPos;
+        while ( mPos < mText.size() && ( isalnum( (unsigned char)mText[mPos] ) ||
+                                         mText[mPos] == '-' || mText[mPos] == '+' || mText[mPos] == '.' ) )
+            mPos++;
+        *text = mText.substr( start, mPos - start );
+        return mPos != start;
+    }
+
+    bool Skip()
+    {
+        std::string text;
+
+        if ( Accept( '[' ) )
+        {
+            if ( Accept( ']' ) )
+                return true;
+            do
+            {
+                if ( !Skip() )
+                    return false;
+            } while ( Accept( ',' ) );
+            return Accept( ']' );
+        }
+        if ( Accept( '{' ) )
+        {
+            if ( Accept( '}' ) )
+                return true;
+            do
+            {
+                if ( !ReadString( &text ) || !Accept( ':' ) || !Skip() )
+                    return false;
+            } while ( Accept( ',' ) );
+            return Accept( '}' );
+        }
+        return ReadScalar( &text );
+    }
+
+protected:
+    const std::string& mText;
+    size_t mPos;
+};
+
+// { "name": "MODE", "msb": 6, "lsb": 4 } or "MODE[6:4]"
+static bool ReadJsonField( RFFEJsonReader& json, RFFERegister* reg, std::string* error )
+{
+    std::string key;
+    std::string value;
+    std::string name;
+    S32 msb = -1;
+    S32 lsb = -1;
+
+    if ( json.Peek() == '"' )
+    {
+        return json.ReadString( &value ) && ParseFieldSpec( reg, value, error );
+    }
+    if ( !json.Accept( '{' ) )
+    {
+        *error = "expected a field object or \"NAME[msb:lsb]\"";
+        return false;
+    }
+    if ( !json.Accept( '}' ) )
+    {
+        do
+        {
+            if ( !json.ReadString( &key ) || !json.Accept( ':' ) )
+            {
+                *error = "expected a key";
+                return false;
+            }
+            if ( key == "name" )
+            {
+                if ( !json.ReadScalar( &name ) )
+                    return false;
+            }
+            else if ( key == "msb" || key == "lsb" || key == "bit" )
+            {
+                S32 bit;
+                if ( !json.ReadScalar( &value ) || !ParseNumber( value, 7, false, &bit ) )
+                {
+                    *error = "bad bit number in field \"" + name + "\"";
+                    return false;
+                }
+                if ( key != "lsb" ) msb = bit;
+                if ( key != "msb" ) lsb = bit;
+            }
+            else if ( !json.Skip() )
+            {
+                return false;
+            }
+        } while ( json.Accept( ',' ) );
+        if ( !json.Accept( '}' ) )
+            return false;
+    }
+    if ( msb < 0 && lsb < 0 )
+    {
+        *error = "field \"" + name + "\" without bits";
+        return false;
+    }
+    return AddField( reg, name, msb < 0 ? lsb : msb, lsb < 0 ? msb : lsb, error );
+}
+
+
+RFFERegisterMap::RFFERegisterMap()
+{
+    Clear();
+}
+
+RFFERegisterMap::~RFFERegisterMap()
+{
+}
+
+void RFFERegisterMap::Clear()
+{
+    for ( U32 sa = 0; sa < 16; sa++ )
+    {
+        for ( U32 page = 0; page < 256; page++ )
+        {
+            mPageIndex[sa][page] = -1;
+        }
+    }
+    mEntries.clear();
+    mRegisters.clear();
+}
+
+bool RFFERegisterMap::Load( const char* file, std::string* error )
+{
+    std::ifstream in( file, std::ios::in | std::ios::binary );
+    std::stringstream text;
+    bool ok;
+
+    Clear();
+    if ( !in )
+    {
+        *error = "cannot open " + std::string( file );
+        return false;
+    }
+    text << in.rdbuf();
+
+    // JSON starts with an array or an object, anything else is taken as CSV
+    std::string content = text.str();
+    size_t first = content.find_first_not_of( " \t\r\n" );
+    if ( first != std::string::npos && ( content[first] == '[' || content[first] == '{' ) )
+        ok = LoadJson( content, error );
+    else
+        ok = LoadCsv( content, error );
+
+    if ( !ok )
+        Clear();
+    return ok;
+}
+
+// later definitions of a register replace earlier ones
+bool RFFERegisterMap::Add( S32 slave_address, U32 address, const RFFERegister& reg, std::string* error )
+{
+    if ( mRegisters.size() >= 0xFFFF )
+    {
+        *error = "more than 65535 registers";
+        return false;
+    }
+    mRegisters.push_back( reg );
+
+    for ( U32 sa = 0; sa < 16; sa++ )
+    {
+        if ( slave_address != RFFE_ANY_SLAVE_ADDRESS && U32( slave_address ) != sa )
+            continue;
+
+        S32& page = mPageIndex[sa][address >> 8];
+        if ( page < 0 )
+        {
+            page = S32( mEntries.size() >> 8 );
+            mEntries.resize( mEntries.size() + 256, 0 );
+        }
+        mEntries[( U32( page ) << 8 ) | ( address & 0xFF )] = U16( mRegisters.size() );
+    }
+    return true;
+}
+
+// SA, address, name, fields; "#" starts a comment, a first line that does
+// not start with a number is a header
+bool RFFERegisterMap::LoadCsv( const std::string& text, std::string* error )
+{
+    std::istringstream in( text );
+    std::string line;
+    U32 line_number = 0;
+    bool first = true;
+
+    while ( std::getline( in, line ) )
+    {
+        std::vector< std::string > cells;
+        std::string cell;
+        std::string problem;
+        RFFERegister reg;
+        S32 sa;
+        S32 address;
+
+        line_number++;
+        line = Trim( line.substr( 0, line.find( '#' ) ) );
+        if ( line.empty() )
+            continue;
+
+        std::istringstream columns( line );
+        while ( std::getline( columns, cell, ',' ) )
+        {
+            cells.push_back( Trim( cell ) );
+        }
+
+        bool numeric = ParseNumber( cells[0], 15, true, &sa );
+        if ( first && !numeric )
+        {
+            first = false;
+            continue;
+        }
+        first = false;
+
+        InitRegister( &reg );
+        if ( !numeric )
+            problem = "bad slave address \"" + cells[0] + "\"";
+        else if ( cells.size() < 3 )
+            problem = "expected SA, address, name[, fields]";
+        else if ( !ParseNumber( cells[1], 0xFFFF, false, &address ) )
+            problem = "bad register address \"" + cells[1] + "\"";
+        else if ( !CopyName( cells[2], reg.mName, RFFE_REGISTER_NAME_LENGTH ) )
+            problem = "bad register name \"" + cells[2] + "\"";
+
+        // fields may be in one column or spread over several
+        for ( size_t i = 3; i < cells.size() && problem.empty(); i++ )
+        {
+            ParseFieldList( &reg, cells[i], &problem );
+        }
+        if ( problem.empty() )
+            Add( sa, U32( address ), reg, &problem );
+
+        if ( !problem.empty() )
+        {
+            std::ostringstream message;
+            message << "line " << line_number << ": " << problem;
+            *error = message.str();
+            return false;
+        }
+    }
+    return true;
+}
+
+// [ { "sa": 5, "address": "0x1C", "name": "PA_CTRL",
+//     "fields": [ "EN[7]", { "name": "GAIN", "msb": 3, "lsb": 0 } ] }, ... ]
+bool RFFERegisterMap::LoadJson( const std::string& text, std::string* error )
+{
+    RFFEJsonReader json( text );
+    std::string key;
+    std::string value;
+    std::string problem;
+    bool found = false;
+
+    // { "registers": [ ... ] } holds the same array as a top level one
+    if ( json.Accept( '{' ) )
+    {
+        do
+        {
+            if ( !json.ReadString( &key ) || !json.Accept( ':' ) )
+                break;
+            if ( key == "registers" )
+            {
+                found = true;
+                break;
+            }
+            if ( !json.Skip() )
+                break;
+        } while ( json.Accept( ',' ) );
+        if ( !found && problem.empty() )
+            problem = "expected a \"registers\" array";
+    }
+
+    if ( problem.empty() && !json.Accept( '[' ) )
+        problem = "expected an array of registers";
+    if ( problem.empty() && !json.Accept( ']' ) )
+    {
+        do
+        {
+            RFFERegister reg;
+            S32 sa = RFFE_ANY_SLAVE_ADDRESS;
+            S32 address = -1;
+
+            InitRegister( &reg );
+            if ( !json.Accept( '{' ) )
+            {
+                problem = "expected a register object";
+                break;
+            }
+            do
+            {
+                if ( !json.ReadString( &key ) || !json.Accept( ':' ) )
+                {
+                    problem = "expected a key";
+                    break;
+                }
+                if ( key == "sa" || key == "usid" )
+                {
+                    if ( !json.ReadScalar( &value ) || !ParseNumber( value, 15, true, &sa ) )
+                        problem = "bad slave address \"" + value + "\"";
+                }
+                else if ( key == "address" )
+                {
+                    if ( !json.ReadScalar( &value ) || !ParseNumber( value, 0xFFFF, false, &address ) )
+                        problem = "bad register address \"" + value + "\"";
+                }
+                else if ( key == "name" )
+                {
+                    if ( !json.ReadScalar( &value ) || !CopyName( value, reg.mName, RFFE_REGISTER_NAME_LENGTH ) )
+                        problem = "bad register name \"" + value + "\"";
+                }
+                else if ( key == "fields" )
+                {
+                    if ( !json.Accept( '[' ) )
+                        problem = "expected an array of fields";
+                    else if ( !json.Accept( ']' ) )
+                    {
+                        do
+                        {
+                            if ( !ReadJsonField( json, &reg, &problem ) && problem.empty() )
+                                problem = "bad field";
+                        } while ( problem.empty() && json.Accept( ',' ) );
+                        if ( problem.empty() && !json.Accept( ']' ) )
+                            problem = "expected ] after the fields";
+                    }
+                }
+                else if ( !json.Skip() )
+                {
+                    problem = "bad value of \"" + key + "\"";
+                }
+            } while ( problem.empty() && json.Accept( ',' ) );
+
+            if ( problem.empty() && !json.Accept( '}' ) )
+                problem = "expected } after a register";
+            if ( problem.empty() && ( address < 0 || reg.mName[0] == '\0' ) )
+                problem = "register without address or name";
+            if ( problem.empty() )
+                Add( sa, U32( address ), reg, &problem );
+        } while ( problem.empty() && json.Accept( ',' ) );
+
+        if ( problem.empty() && !json.Accept( ']' ) )
+            problem = "expected ] after the registers";
+    }
+
+    if ( !problem.empty() )
+    {
+        std::ostringstream message;
+        message << "line " << json.GetLine() << ": " << problem;
+        *error = message.str();
+        return false;
+    }
+    return true;
+}
+
+static void Append( char* text, U32 size, U32* length, const char* part )
+{
+    while ( *part != '\0' && *length + 1 < size )
+    {
+        text[( *length )++] = *part++;
+    }
+    text[*length] = '\0';
+}
+
+// "PA_CTRL EN=1 GAIN=0xA", the field values in the display base
+U32 RFFERegisterMap::Describe( const RFFERegister& reg, U8 value, DisplayBase display_base, char* text, U32 size )
+{
+    U32 length = 0;
+    char number_str[16];
+
+    if ( size == 0 )
+        return 0;
+    text[0] = '\0';
+    Append( text, size, &length, reg.mName );
+    for ( U32 i = 0; i < reg.mFieldCount; i++ )
+    {
+        const RFFERegisterField& field = reg.mFields[i];
+        U32 bits = field.mMsb - field.mLsb + 1;
+        U32 field_value = ( value >> field.mLsb ) & ( ( 1 << bits ) - 1 );
+
+        AnalyzerHelpers::GetNumberString( field_value, bits == 1 ? Decimal : display_base, bits, number_str, 16 );
+        Append( text, size, &length, " " );
+        Append( text, size, &length, field.mName );
+        Append( text, size, &length, "=" );
+        Append( text, size, &length, number_str );
+    }
+    return length;
+}
@@ -0,0 +1,66 @@
+#ifndef RFFE_REGISTER_MAP
+#define RFFE_REGISTER_MAP
+
+#include <AnalyzerTypes.h>
+#include <LogicPublicTypes.h>
+#include <string>
+#include <vector>
+
+#define RFFE_REGISTER_NAME_LENGTH   40
+#define RFFE_FIELD_NAME_LENGTH      24
+#define RFFE_MAX_REGISTER_FIELDS    8
+
+// bits mMsb..mLsb of a register
+struct RFFERegisterField
+{
+    char mName[RFFE_FIELD_NAME_LENGTH];
+    U8   mMsb;
+    U8   mLsb;
+};
+
+struct RFFERegister
+{
+    char mName[RFFE_REGISTER_NAME_LENGTH];
+    U32  mFieldCount;
+    RFFERegisterField mFields[RFFE_MAX_REGISTER_FIELDS];
+};
+
+// Register names and bit fields of the devices on the bus, read from a CSV
+// or JSON file. Everything is allocated by Load(); Find() is two table
+// lookups and Describe() writes into the caller's buffer, so annotating
+// frames and exports allocates nothing.
+class RFFERegisterMap
+{
+public:
+    RFFERegisterMap();
+    ~RFFERegisterMap();
+
+    bool Load( const char* file, std::string* error );
+    void Clear();
+
+    bool IsEmpty() const                { return mRegisters.empty(); }
+
+    const RFFERegister* Find( U8 slave_address, U16 address ) const
+    {
+        S32 page = mPageIndex[slave_address & 0x0F][address >> 8];
+        if ( page < 0 )
+            return NULL;
+        U16 entry = mEntries[( U32( page ) << 8 ) | ( address & 0xFF )];
+        return entry == 0 ? NULL : &mRegisters[entry - 1];
+    }
+
+    static U32 Describe( const RFFERegister& reg, U8 value, DisplayBase display_base, char* text, U32 size );
+
+protected:
+    bool Add( S32 slave_address, U32 address, const RFFERegister& reg, std::string* error );
+    bool LoadCsv( const std::string& text, std::string* error );
+    bool LoadJson( const std::string& text, std::string* error );
+
+    // per SA and upper address byte, a page of 256 entries in mEntries
+    // (-1: no register there); an entry is 1 + the index into mRegisters
+    S32 mPageIndex[16][256];
+    std::vector< U16 > mEntries;
+    std::vector< RFFERegister > mRegisters;
+};
+
+#endif //RFFE_REGISTER_MAP
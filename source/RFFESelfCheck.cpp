@@ -0,0 +1,250 @@
+#include "RFFESelfCheck.h"
+#include "RFFESimulationDataGenerator.h"
+#include "RFFEAnalyzerResults.h"
+#include <AnalyzerHelpers.h>
+#include <iomanip>
+#include <sstream>
+
+RFFESelfCheck::RFFESelfCheck()
+:   mGenerator( NULL ),
+    mSampleScale( 1.0 ),
+    mFirstSample( 0 ),
+    mElapsed( 0 ),
+    mDecoded( 0 ),
+    mFiltered( 0 ),
+    mMatched( 0 ),
+    mMismatched( 0 ),
+    mMissed( 0 ),
+    mSpurious( 0 )
+{
+    for ( U32 bus = 0; bus < RFFE_MAX_BUSES; bus++ )
+    {
+        mExpectedValid[bus]     = false;
+        mLastDecodedSample[bus] = 0;
+    }
+}
+
+RFFESelfCheck::~RFFESelfCheck()
+{
+}
+
+void RFFESelfCheck::Start( RFFESimulationDataGenerator* generator, double sample_scale, U64 first_sample )
+{
+    mGenerator         = generator;
+    mSampleScale       = sample_scale;
+    mFirstSample       = first_sample;
+    mStartTime         = std::chrono::steady_clock::now();
+    mDecoded           = 0;
+    mFiltered          = 0;
+    mMatched           = 0;
+    mMismatched        = 0;
+    mMissed            = 0;
+    mSpurious          = 0;
+    mFirstMismatch.clear();
+    for ( U32 bus = 0; bus < RFFE_MAX_BUSES; bus++ )
+    {
+        mExpectedValid[bus]     = false;
+        mLastDecodedSample[bus] = 0;
+    }
+}
+
+bool RFFESelfCheck::NextGroundTruth( U8 bus )
+{
+    RFFEPacket& expected = mExpected[bus];
+    bool& valid = mExpectedValid[bus];
+
+    // packets before the decode range are not expected to be decoded
+    while ( !valid )
+    {
+        valid = mGenerator->PopGroundTruth( bus, &expected );
+        if ( valid )
+        {
+            expected.mStartingSample = U64( expected.mStartingSample * mSampleScale + 0.5 );
+            expected.mEndingSample   = U64( expected.mEndingSample * mSampleScale + 0.5 );
+            valid = ( expected.mStartingSample >= mFirstSample );
+        }
+        else
+        {
+            break;
+        }
+    }
+    return valid;
+}
+
+void RFFESelfCheck::Check( const RFFEPacket& decoded )
+{
+    mDecoded++;
+    Account( decoded, false );
+}
+
+// packets dropped by the SA/command type filter only carry their header
+void RFFESelfCheck::Skip( const RFFEPacket& filtered )
+{
+    mFiltered++;
+    Account( filtered, true );
+}
+
+void RFFESelfCheck::Account( const RFFEPacket& decoded, bool header_only )
+{
+    U64 slack = U64( mSampleScale ) + 1;
+    U8 bus = decoded.mBus;
+    const RFFEPacket& expected = mExpected[bus];
+    bool same;
+
+    mLastDecodedSample[bus] = decoded.mEndingSample;
+
+    // generated packets that ended before this one started were not decoded
+    while ( NextGroundTruth( bus ) && expected.mEndingSample < decoded.mStartingSample )
+    {
+        mMissed++;
+        mExpectedValid[bus] = false;
+    }
+
+    // decoded a packet where none was generated
+    if ( !mExpectedValid[bus] || decoded.mStartingSample + slack < expected.mStartingSample )
+    {
+        mSpurious++;
+        return;
+    }
+
+    if ( header_only )
+    {
+        same = expected.mSlaveAddress == decoded.mSlaveAddress &&
+               expected.mCommand      == decoded.mCommand;
+    }
+    else
+    {
+        // the closing bus park has to end where it was generated as well,
+        // the decoder cannot know how long a reserved command is
+        same = Compare( expected, decoded ) &&
+               ( decoded.mType == RFFEAnalyzerResults::RffeTypeReserved ||
+                 ( decoded.mEndingSample + slack >= expected.mEndingSample &&
+                   decoded.mEndingSample <= expected.mEndingSample + slack ) );
+    }
+
+    if ( same &&
+         decoded.mStartingSample <= expected.mStartingSample + slack )
+    {
+        mMatched++;
+    }
+    else
+    {
+        if ( mMismatched == 0 )
+        {
+            std::stringstream ss;
+
+            ss << "packet " << ( mDecoded + mFiltered - 1 ) << std::endl;
+            ss << "  expected: ";
+            Describe( ss, expected );
+            ss << std::endl << "  decoded:  ";
+            Describe( ss, decoded );
+            ss << ( header_only ? " (filtered)" : "" ) << std::endl;
+            mFirstMismatch = ss.str();
+        }
+        mMismatched++;
+    }
+    mExpectedValid[bus] = false;
+}
+
+bool RFFESelfCheck::Compare( const RFFEPacket& expected, const RFFEPacket& decoded )
+{
+    if ( expected.mSlaveAddress != decoded.mSlaveAddress ||
+         expected.mCommand      != decoded.mCommand ||
+         expected.mType         != decoded.mType ||
+         expected.mAddress      != decoded.mAddress ||
+         expected.mByteCount    != decoded.mByteCount ||
+         expected.mParityCount  != decoded.mParityCount ||
+         expected.mParity       != decoded.mParity ||
+         expected.mParityErrors != decoded.mParityErrors )
+    {
+        return false;
+    }
+
+    for ( U32 i = 0; i < expected.mByteCount; i++ )
+    {
+        if ( expected.mData[i] != decoded.mData[i] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RFFESelfCheck::Describe( std::ostream& os, const RFFEPacket& packet )
+{
+    os << std::hex << std::uppercase << std::setfill( '0' );
+    os << "bus " << std::dec << U32( packet.mBus );
+    os << " @" << std::dec << packet.mStartingSample << "-" << packet.mEndingSample << std::hex;
+    os << " SA:0x" << U32( packet.mSlaveAddress );
+    os << " CMD:0x" << std::setw( 2 ) << U32( packet.mCommand );
+    os << " A:0x" << std::setw( 4 ) << packet.mAddress;
+    os << " D:";
+    for ( U32 i = 0; i < packet.mByteCount; i++ )
+    {
+        os << std::setw( 2 ) << U32( packet.mData[i] );
+    }
+    os << " P:0x" << packet.mParity << std::dec << "/" << U32( packet.mParityCount );
+}
+
+void RFFESelfCheck::Finish( const char* report_file )
+{
+    mElapsed = std::chrono::duration< double >( std::chrono::steady_clock::now() - mStartTime ).count();
+
+    // the capture ends somewhere in the generated data, only count what it covered
+    for ( U8 bus = 0; bus < RFFE_MAX_BUSES; bus++ )
+    {
+        while ( NextGroundTruth( bus ) && mExpected[bus].mStartingSample < mLastDecodedSample[bus] )
+        {
+            mMissed++;
+            mExpectedValid[bus] = false;
+        }
+    }
+
+    if ( report_file == NULL || report_file[0] == '\0' )
+    {
+        return;
+    }
+
+    std::string report = GetReport();
+    void* f = AnalyzerHelpers::StartFile( report_file );
+    AnalyzerHelpers::AppendToFile( (U8*)report.c_str(), (U32)report.length(), f );
+    AnalyzerHelpers::EndFile( f );
+}
+
+bool RFFESelfCheck::HasPassed() const
+{
+    return ( mMismatched + mMissed + mSpurious ) == 0 && ( mDecoded + mFiltered ) != 0;
+}
+
+U64 RFFESelfCheck::GetPacketCount() const
+{
+    return mDecoded + mFiltered;
+}
+
+double RFFESelfCheck::GetSecondsPerMillionPackets() const
+{
+    return mDecoded != 0 ? mElapsed * 1000000.0 / double( mDecoded ) : 0.0;
+}
+
+std::string RFFESelfCheck::GetReport() const
+{
+    std::stringstream ss;
+
+    ss << "RFFE round-trip self-check: " << ( HasPassed() ? "PASS" : "FAIL" ) << std::endl;
+    ss << "decoded packets:    " << mDecoded << std::endl;
+    ss << "filtered packets:   " << mFiltered << std::endl;
+    ss << "matched:            " << mMatched << std::endl;
+    ss << "mismatched:         " << mMismatched << std::endl;
+    ss << "missed:             " << mMissed << std::endl;
+    ss << "spurious:           " << mSpurious << std::endl;
+    ss << "decode time [s]:    " << mElapsed << std::endl;
+    if ( mDecoded != 0 )
+    {
+        ss << "s per 1M packets:   " << GetSecondsPerMillionPackets() << std::endl;
+    }
+    if ( !mFirstMismatch.empty() )
+    {
+        ss << "first mismatch at " << mFirstMismatch;
+    }
+    return ss.str();
+}
@@ -0,0 +1,57 @@
+#ifndef RFFE_SELF_CHECK
+#define RFFE_SELF_CHECK
+
+#include <LogicPublicTypes.h>
+#include <chrono>
+#include <string>
+#include "RFFEPacket.h"
+
+class RFFESimulationDataGenerator;
+
+// Round-trip check of the decoder: every decoded packet is compared with
+// the packet the simulation data generator encoded at that position on the
+// same bus.
+class RFFESelfCheck
+{
+public:
+    RFFESelfCheck();
+    ~RFFESelfCheck();
+
+    void Start( RFFESimulationDataGenerator* generator, double sample_scale, U64 first_sample );
+    void Check( const RFFEPacket& decoded );
+    void Skip( const RFFEPacket& filtered );
+    void Finish( const char* report_file );
+
+    // valid after Finish
+    bool HasPassed() const;
+    U64 GetPacketCount() const;             // decoded and filtered
+    double GetSecondsPerMillionPackets() const;
+    std::string GetReport() const;
+
+protected: // functions
+    bool NextGroundTruth( U8 bus );
+    void Account( const RFFEPacket& decoded, bool header_only );
+    bool Compare( const RFFEPacket& expected, const RFFEPacket& decoded );
+    static void Describe( std::ostream& os, const RFFEPacket& packet );
+
+protected: // vars
+    RFFESimulationDataGenerator* mGenerator;
+    double mSampleScale;
+    U64 mFirstSample;
+    std::chrono::steady_clock::time_point mStartTime;
+    double mElapsed;        // Start to Finish, in seconds
+
+    RFFEPacket mExpected[RFFE_MAX_BUSES];
+    bool mExpectedValid[RFFE_MAX_BUSES];
+    U64 mLastDecodedSample[RFFE_MAX_BUSES];
+
+    U64 mDecoded;
+    U64 mFiltered;
+    U64 mMatched;
+    U64 mMismatched;
+    U64 mMissed;
+    U64 mSpurious;
+    std::string mFirstMismatch;
+};
+
+#endif //RFFE_SELF_CHECK
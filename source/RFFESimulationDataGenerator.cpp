@@ -18,26 +18,55 @@ void RFFESimulationDataGenerator::Initialize( U32 simulation_sample_rate,
 	mSimulationSampleRateHz = simulation_sample_rate;
 	mSettings = settings;
 
-    mClockGenerator.Init( simulation_sample_rate / 10, simulation_sample_rate );
-
-    if( settings->mSclkChannel != UNDEFINED_CHANNEL )
-		mSclk = mRffeSimulationChannels.Add( settings->mSclkChannel,
-                                              mSimulationSampleRateHz,
-                                              BIT_LOW );
-	else
-		mSclk = NULL;
-
-    if( settings->mSdataChannel != UNDEFINED_CHANNEL )
-		mSdata = mRffeSimulationChannels.Add( settings->mSdataChannel,
-                                              mSimulationSampleRateHz,
-                                              BIT_LOW );
-	else
-		mSdata = NULL;
+    // the bus SCLK if known, with at least two samples per half period
+    U32 sclk_hz = settings->mBusSclkKHz * 1000;
+    if ( sclk_hz == 0 || sclk_hz > simulation_sample_rate / 4 )
+    {
+        sclk_hz = simulation_sample_rate / 10;
+    }
 
-    //insert 10 bit-periods of idle
-	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 10.0 ) );
+    for ( U8 bus = 0; bus < RFFE_MAX_BUSES; bus++ )
+    {
+        SimulationBus& b = mBuses[bus];
+        Channel sclk = settings->GetSclkChannel( bus );
+        Channel sdata = settings->GetSdataChannel( bus );
+
+        b.mClockGenerator.Init( sclk_hz, simulation_sample_rate );
+        b.mRandomState = 0x52464645 ^ ( bus * 0x9E3779B9 );
+
+        if( sclk != UNDEFINED_CHANNEL )
+            b.mSclk = mRffeSimulationChannels.Add( sclk,
+                                                   mSimulationSampleRateHz,
+                                                   BIT_LOW );
+        else
+            b.mSclk = NULL;
+
+        if( sdata != UNDEFINED_CHANNEL )
+            b.mSdata = mRffeSimulationChannels.Add( sdata,
+                                                    mSimulationSampleRateHz,
+                                                    BIT_LOW );
+        else
+            b.mSdata = NULL;
+
+        //insert 10 bit-periods of idle, further buses start a little later
+        if ( b.mSclk != NULL && b.mSdata != NULL )
+        {
+            SelectBus( bus );
+            Advance( mClockGenerator->AdvanceByHalfPeriod( 10.0 + 7.0 * bus ) );
+        }
+    }
+    SelectBus( 0 );
 
 	mParityCounter = 0;
+	mHalfSpeedRead = false;
+	mClockScale = 1.0;
+
+	mRecordGroundTruth = ( settings->mSimulationMode == RFFEAnalyzerSettings::SimulationRandomized );
+	std::lock_guard< std::mutex > lock( mGroundTruthMutex );
+    for ( U32 bus = 0; bus < RFFE_MAX_BUSES; bus++ )
+    {
+        mGroundTruth[bus].clear();
+    }
 }
 
 U32 RFFESimulationDataGenerator::GenerateSimulationData( U64 largest_sample_requested, 
@@ -48,20 +77,45 @@ U32 RFFESimulationDataGenerator::GenerateSimulationData( U64 largest_sample_requ
                                                                                            sample_rate,
                                                                                            mSimulationSampleRateHz );
 
-	while( mSclk->GetCurrentSampleNumber() < adjusted_largest_sample_requested )
-	{
-		CreateRffeTransaction();
-        
-		mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 80.0 ) );
+    for ( U8 bus = 0; bus < RFFE_MAX_BUSES; bus++ )
+    {
+        if ( mBuses[bus].mSclk == NULL || mBuses[bus].mSdata == NULL )
+        {
+            continue;
+        }
+        SelectBus( bus );
+
+        while( mSclk->GetCurrentSampleNumber() < adjusted_largest_sample_requested )
+        {
+            CreateRffeTransaction();
+
+            Advance( mClockGenerator->AdvanceByHalfPeriod( 80.0 ) );
+        }
     }
 
 	*simulation_channels = mRffeSimulationChannels.GetArray();
 	return mRffeSimulationChannels.GetCount();
 }
 
+void RFFESimulationDataGenerator::SelectBus( U8 bus )
+{
+    mBusId          = bus;
+    mBus            = &mBuses[bus];
+    mClockGenerator = &mBus->mClockGenerator;
+    mSclk           = mBus->mSclk;
+    mSdata          = mBus->mSdata;
+}
+
+// advances the channels of the current bus only
+void RFFESimulationDataGenerator::Advance( U32 samples )
+{
+    mSclk->Advance( samples );
+    mSdata->Advance( samples );
+}
+
 void RFFESimulationDataGenerator::CreateRffeTransaction()
 {
-    U8 cmd;
+    U8 data[16];
     U8 cmd_frames[] = 
     {
         0x00, 0x01, 0x07, 0x0F,      // Extended write type  [OK]
@@ -77,74 +131,211 @@ void RFFESimulationDataGenerator::CreateRffeTransaction()
     {
         0x5, //0x7, 0x8, 0x2
     };
+
+    if ( mSettings->mSimulationMode == RFFEAnalyzerSettings::SimulationRandomized )
+    {
+        CreateRandomRffeTransaction();
+        return;
+    }
+
+    // payload counts down to 1, single byte payloads are 0x12
+    for( U32 i = 0 ; i < 16 ; i++ )
+    {
+        data[i] = U8( 16 - i );
+    }
     
     for( U32 adr=0 ; adr < sizeof(sa_addrs)/sizeof(sa_addrs[0]) ; adr++ )
     {
         for ( U32 cmd_idx=0 ; cmd_idx < sizeof(cmd_frames)/sizeof(cmd_frames[0]) ; cmd_idx++ )
         {
-            CreateStart();
-            CreateSlaveAddress( sa_addrs[adr] );
-            cmd = cmd_frames[cmd_idx];
-            CreateCommandFrame( cmd );
+            U8 cmd = cmd_frames[cmd_idx];
+            U32 count = RFFEUtil::byteCount( cmd ) + 1;
+            U8 single = 0x12;
 
-            switch ( RFFEUtil::decodeRFFECmdFrame( cmd ) )
+            switch ( RFFEUtil::decodeRFFECmdFrame( cmd, false ) )
             {
             case RFFEAnalyzerResults::RffeTypeExtWrite:
-                CreateAddressFrame( 0x65 );
-                for( U32 i = RFFEUtil::byteCount( cmd ) + 1 ; i != 0; i-- )
-                {
-                    CreateDataFrame( i );
-                }
-                CreateBusPark();
-                break;
-            case RFFEAnalyzerResults::RffeTypeReserved:
-                CreateBusPark();
+                CreateRffePacket( sa_addrs[adr], cmd, 0x65, &data[16 - count] );
                 break;
             case RFFEAnalyzerResults::RffeTypeExtRead:
-                CreateAddressFrame( 0x4B );
-                CreateBusPark();
-                for( U32 i = RFFEUtil::byteCount( cmd ) + 1 ; i != 0; i-- )
-                {
-                    CreateDataFrame( i );
-                }
-                CreateBusPark();
+                CreateRffePacket( sa_addrs[adr], cmd, 0x4B, &data[16 - count] );
                 break;
             case RFFEAnalyzerResults::RffeTypeExtLongWrite:
-                CreateAddressFrame( 0x5A );
-                CreateAddressFrame( 0x94 );
-                for( U32 i = RFFEUtil::byteCount( cmd ) + 1; i != 0; i-- )
-                {
-                    CreateDataFrame( i );
-                }
-                CreateBusPark();
+                CreateRffePacket( sa_addrs[adr], cmd, 0x5A94, &data[16 - count] );
                 break;
             case RFFEAnalyzerResults::RffeTypeExtLongRead:
-                CreateAddressFrame( 0x12 );
-                CreateAddressFrame( 0x34 );
-                CreateBusPark();
-                for( U32 i = RFFEUtil::byteCount( cmd ) + 1; i != 0; i-- )
-                {
-                    CreateDataFrame( i );
-                }
-                CreateBusPark();
+                CreateRffePacket( sa_addrs[adr], cmd, 0x1234, &data[16 - count] );
                 break;
             case RFFEAnalyzerResults::RffeTypeNormalWrite:
-                CreateDataFrame( 0x12 );
-                CreateBusPark();
-                break;
             case RFFEAnalyzerResults::RffeTypeNormalRead:
-                CreateBusPark();
-                CreateDataFrame( 0x12 );
-                CreateBusPark();
+                CreateRffePacket( sa_addrs[adr], cmd, 0, &single );
                 break;
+            case RFFEAnalyzerResults::RffeTypeReserved:
             case RFFEAnalyzerResults::RffeTypeShortWrite:
-                CreateBusPark();
+            case RFFEAnalyzerResults::RffeTypeMaskedWrite:
+                CreateRffePacket( sa_addrs[adr], cmd, 0, NULL );
                 break;
             }
         }
+
+        // v2.x: mask 0xF0, data 0x5A
+        if ( mSettings->mProtocolVersion == RFFEAnalyzerSettings::ProtocolV2 )
+        {
+            U8 masked[] = { 0xF0, 0x5A };
+            CreateRffePacket( sa_addrs[adr], RFFE_CMD_MASKED_WRITE, 0x1C, masked );
+        }
+    }
+}
+
+void RFFESimulationDataGenerator::CreateRandomRffeTransaction()
+{
+    U8 data[16];
+
+    for( U32 n = 0 ; n < 32 ; n++ )
+    {
+        for( U32 i = 0 ; i < 16 ; i++ )
+        {
+            data[i] = U8( Random( 256 ) );
+        }
+
+        mHalfSpeedRead = ( Random( 4 ) == 0 );
+        CreateRffePacket( U8( Random( 16 ) ), U8( Random( 256 ) ), U16( Random( 0x10000 ) ), data );
+        mHalfSpeedRead = false;
+
+        // random idle time between packets, at least the SSC lead-in
+        Advance( mClockGenerator->AdvanceByHalfPeriod( double( Random( 16 ) ) ) );
     }
 }
 
+void RFFESimulationDataGenerator::CreateRffePacket( U8 sa, U8 cmd, U16 address, const U8* data )
+{
+    RFFEAnalyzerResults::RffeTypeFieldType type =
+        RFFEUtil::decodeRFFECmdFrame( cmd, mSettings->mProtocolVersion == RFFEAnalyzerSettings::ProtocolV2 );
+    U32 count = RFFEUtil::byteCount( cmd ) + 1;
+
+    mPacket.mBus          = mBusId;
+    mPacket.mSlaveAddress = sa & 0x0F;
+    mPacket.mCommand      = cmd;
+    mPacket.mType         = U8( type );
+    mPacket.mByteCount    = 0;
+    mPacket.mAddress      = 0;
+    mPacket.mParityCount  = 0;
+    mPacket.mParity       = 0;
+    mPacket.mParityErrors = 0;
+
+    CreateStart();
+    CreateSlaveAddress( sa );
+    CreateCommandFrame( cmd );
+
+    switch ( type )
+    {
+    case RFFEAnalyzerResults::RffeTypeExtWrite:
+        CreateAddressFrame( U8( address ) );
+        for( U32 i = 0 ; i < count ; i++ )
+        {
+            CreateDataFrame( data[i] );
+        }
+        CreateBusPark();
+        break;
+    case RFFEAnalyzerResults::RffeTypeReserved:
+        CreateBusPark();
+        break;
+    case RFFEAnalyzerResults::RffeTypeMaskedWrite:
+        CreateAddressFrame( U8( address ) );
+        CreateDataFrame( data[0] );     // mask
+        CreateDataFrame( data[1] );
+        CreateBusPark();
+        break;
+    case RFFEAnalyzerResults::RffeTypeExtRead:
+        CreateAddressFrame( U8( address ) );
+        CreateBusPark();
+        mClockScale = mHalfSpeedRead ? 2.0 : 1.0;
+        for( U32 i = 0 ; i < count ; i++ )
+        {
+            CreateDataFrame( data[i] );
+        }
+        CreateBusPark();
+        break;
+    case RFFEAnalyzerResults::RffeTypeExtLongWrite:
+        CreateAddressFrame( U8( address >> 8 ) );
+        CreateAddressFrame( U8( address ) );
+        for( U32 i = 0 ; i < count ; i++ )
+        {
+            CreateDataFrame( data[i] );
+        }
+        CreateBusPark();
+        break;
+    case RFFEAnalyzerResults::RffeTypeExtLongRead:
+        CreateAddressFrame( U8( address >> 8 ) );
+        CreateAddressFrame( U8( address ) );
+        CreateBusPark();
+        mClockScale = mHalfSpeedRead ? 2.0 : 1.0;
+        for( U32 i = 0 ; i < count ; i++ )
+        {
+            CreateDataFrame( data[i] );
+        }
+        CreateBusPark();
+        break;
+    case RFFEAnalyzerResults::RffeTypeNormalWrite:
+        mPacket.mAddress = cmd & 0x1F;
+        CreateDataFrame( data[0] );
+        CreateBusPark();
+        break;
+    case RFFEAnalyzerResults::RffeTypeNormalRead:
+        mPacket.mAddress = cmd & 0x1F;
+        CreateBusPark();
+        mClockScale = mHalfSpeedRead ? 2.0 : 1.0;
+        CreateDataFrame( data[0] );
+        CreateBusPark();
+        break;
+    case RFFEAnalyzerResults::RffeTypeShortWrite:
+        mPacket.mData[mPacket.mByteCount++] = cmd & 0x7F;
+        CreateBusPark();
+        break;
+    }
+
+    mClockScale = 1.0;
+
+    if ( mRecordGroundTruth )
+    {
+        mPacket.mEndingSample = mSdata->GetCurrentSampleNumber();
+
+        std::lock_guard< std::mutex > lock( mGroundTruthMutex );
+        mGroundTruth[mBusId].push_back( mPacket );
+    }
+}
+
+bool RFFESimulationDataGenerator::IsRecordingGroundTruth()
+{
+    return mRecordGroundTruth;
+}
+
+bool RFFESimulationDataGenerator::PopGroundTruth( U8 bus, RFFEPacket* packet )
+{
+    std::lock_guard< std::mutex > lock( mGroundTruthMutex );
+
+    if ( mGroundTruth[bus].empty() )
+    {
+        return false;
+    }
+
+    *packet = mGroundTruth[bus].front();
+    mGroundTruth[bus].pop_front();
+    return true;
+}
+
+U32 RFFESimulationDataGenerator::Random( U32 range )
+{
+    // xorshift32, fixed seed so a failing self-check can be reproduced
+    U32& state = mBus->mRandomState;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state % range;
+}
+
 void RFFESimulationDataGenerator::CreateStart()
 {
     if ( mSclk->GetCurrentBitState() == BIT_HIGH )
@@ -157,14 +348,15 @@ void RFFESimulationDataGenerator::CreateStart()
 		mSdata->Transition();
     }
 
-	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 2.0 ) );
+	Advance( mClockGenerator->AdvanceByHalfPeriod( 2.0 ) );
 
     // sdata pulse for 1-clock cycle
+    mPacket.mStartingSample = mSdata->GetCurrentSampleNumber();
     mSdata->Transition();
-	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 2.0 ) );
+	Advance( mClockGenerator->AdvanceByHalfPeriod( 2.0 ) );
     mSdata->Transition();
     // sdata and sclk state low for 1-clock cycle
-	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 2.0 ) );
+	Advance( mClockGenerator->AdvanceByHalfPeriod( 2.0 ) );
 
     mParityCounter = 0;
 }
@@ -177,17 +369,17 @@ void RFFESimulationDataGenerator::CreateSlaveAddress(U8 addr )
 	for( U32 i=0; i< 4; i++ )
 	{
 		mSclk->Transition();
-		mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( .5 ) );
+		Advance( mClockGenerator->AdvanceByHalfPeriod( .5 ) );
 
 		mSdata->TransitionIfNeeded( adr_bits.GetNextBit() );
 
         if( mSdata->GetCurrentBitState() == BIT_HIGH ) 
             mParityCounter++;
 
-		mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( .5 ) );
+		Advance( mClockGenerator->AdvanceByHalfPeriod( .5 ) );
 		mSclk->Transition();
 
-    	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 1.0 ) );
+    	Advance( mClockGenerator->AdvanceByHalfPeriod( 1.0 ) );
 	}
 }
 
@@ -199,7 +391,7 @@ void RFFESimulationDataGenerator::CreateByte(U8 cmd)
 	for( U32 i=0; i< 8; i++ )
 	{
 		mSclk->Transition();
-		mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( .5 ) );
+		Advance( mClockGenerator->AdvanceByHalfPeriod( .5 * mClockScale ) );
 
         bit = cmd_bits.GetNextBit();
 		mSdata->TransitionIfNeeded( bit );
@@ -207,55 +399,58 @@ void RFFESimulationDataGenerator::CreateByte(U8 cmd)
         if( bit == BIT_HIGH ) 
             mParityCounter++;
 
-		mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( .5 ) );
+		Advance( mClockGenerator->AdvanceByHalfPeriod( .5 * mClockScale ) );
 		mSclk->Transition();
 
-    	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 1.0 ) );
+    	Advance( mClockGenerator->AdvanceByHalfPeriod( 1.0 * mClockScale ) );
 	}
 }
 
 void RFFESimulationDataGenerator::CreateParity()
 {
 	mSclk->Transition();
-	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( .5 ) );
+	Advance( mClockGenerator->AdvanceByHalfPeriod( .5 * mClockScale ) );
 
     if( AnalyzerHelpers::IsEven(mParityCounter) )
     {
 		mSdata->TransitionIfNeeded( BIT_HIGH );
+        mPacket.mParity |= ( 1 << mPacket.mParityCount );
     }
     else
     {
 		mSdata->TransitionIfNeeded( BIT_LOW );
     }
+    mPacket.mParityCount++;
 
-	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( .5 ) );
+	Advance( mClockGenerator->AdvanceByHalfPeriod( .5 * mClockScale ) );
 	mSclk->Transition();
 
-    mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 1.0 ) );
+    Advance( mClockGenerator->AdvanceByHalfPeriod( 1.0 * mClockScale ) );
 }
 
 void RFFESimulationDataGenerator::CreateBusPark()
 {
 	mSclk->Transition();
-	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( .5 ) );
+	Advance( mClockGenerator->AdvanceByHalfPeriod( .5 * mClockScale ) );
 
 	mSdata->TransitionIfNeeded( BIT_LOW );
 
-	mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( .5 ) );
+	Advance( mClockGenerator->AdvanceByHalfPeriod( .5 * mClockScale ) );
 	mSclk->Transition();
 
-    mRffeSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 1.0 ) );
+    Advance( mClockGenerator->AdvanceByHalfPeriod( 1.0 * mClockScale ) );
 }
 
 void RFFESimulationDataGenerator::CreateCommandFrame( U8 cmd )
 {
-    mParityCounter = 0;
+    // command frame parity covers the slave address as well
     CreateByte( cmd );
     CreateParity();
 }
 
 void RFFESimulationDataGenerator::CreateAddressFrame( U8 addr )
 {
+    mPacket.mAddress = U16( ( mPacket.mAddress << 8 ) | addr );
     mParityCounter = 0;
     CreateByte( addr );
     CreateParity();
@@ -263,6 +458,7 @@ void RFFESimulationDataGenerator::CreateAddressFrame( U8 addr )
 
 void RFFESimulationDataGenerator::CreateDataFrame( U8 data )
 {
+    mPacket.mData[mPacket.mByteCount++] = data;
     mParityCounter = 0;
     CreateByte( data );
     CreateParity();
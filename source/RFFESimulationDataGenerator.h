@@ -4,7 +4,10 @@
 #include <AnalyzerHelpers.h>
 #include <SimulationChannelDescriptor.h>
 #include <string>
+#include <deque>
+#include <mutex>
 #include "RFFEAnalyzerResults.h"
+#include "RFFEPacket.h"
 
 class RFFEAnalyzerSettings;
 
@@ -20,12 +23,20 @@ public:
                                 U32 sample_rate,
                                 SimulationChannelDescriptor** simulation_channels );
 
+    // ground truth of the randomized simulation, consumed by the self-check
+    bool IsRecordingGroundTruth();
+    bool PopGroundTruth( U8 bus, RFFEPacket* packet );
+
 protected:
 	RFFEAnalyzerSettings* mSettings;
 	U32 mSimulationSampleRateHz;
 
 protected: // RFFE specific functions
+    void SelectBus( U8 bus );
+    void Advance( U32 samples );
 	void CreateRffeTransaction();
+    void CreateRandomRffeTransaction();
+    void CreateRffePacket( U8 sa, U8 cmd, U16 address, const U8* data );
 	void CreateStart();
     void CreateSlaveAddress(U8 addr);
     void CreateCommandFrame(U8 cmd);
@@ -36,12 +47,33 @@ protected: // RFFE specific functions
     void CreateAddressFrame( U8 addr );
 
 protected: //RFFE specific vars
-	ClockGenerator mClockGenerator;
+    // every bus runs on its own clock and random sequence
+    struct SimulationBus
+    {
+        ClockGenerator mClockGenerator;
+        SimulationChannelDescriptor* mSclk;
+        SimulationChannelDescriptor* mSdata;
+        U32 mRandomState;
+    };
+
 	SimulationChannelDescriptorGroup mRffeSimulationChannels;
+    SimulationBus mBuses[RFFE_MAX_BUSES];
+    U8 mBusId;
+    SimulationBus* mBus;
+	ClockGenerator* mClockGenerator;
 	SimulationChannelDescriptor* mSclk;
 	SimulationChannelDescriptor* mSdata;
 
 private:
     U32 mParityCounter;
+    bool mHalfSpeedRead;    // next read packet returns its data at half speed
+    double mClockScale;     // half periods per nominal half period
+
+    bool mRecordGroundTruth;
+    RFFEPacket mPacket;
+    std::deque< RFFEPacket > mGroundTruth[RFFE_MAX_BUSES];
+    std::mutex mGroundTruthMutex;
+
+    U32 Random( U32 range );
 };
 #endif //RFFE_SIMULATION_DATA_GENERATOR
\ No newline at end of file
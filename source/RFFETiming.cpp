@@ -0,0 +1,240 @@
+#include "RFFETiming.h"
+#include "RFFEAnalyzerSettings.h"
+#include "RFFEAnalyzerResults.h"
+#include <AnalyzerHelpers.h>
+#include <algorithm>
+#include <sstream>
+
+void RFFETiming::Statistic::Reset()
+{
+    mMin   = 0.0;
+    mMax   = 0.0;
+    mSum   = 0.0;
+    mCount = 0;
+}
+
+void RFFETiming::Statistic::Add( double value )
+{
+    if ( mCount == 0 || value < mMin )
+        mMin = value;
+    if ( mCount == 0 || value > mMax )
+        mMax = value;
+    mSum += value;
+    mCount++;
+}
+
+RFFETiming::RFFETiming()
+:   mSampleRateHz( 0.0 ),
+    mMaxSclkHz( 0.0 ),
+    mMaxReadSclkHz( 0.0 ),
+    mBusSclkHz( 0.0 ),
+    mMinSetupSamples( 0.0 ),
+    mMinHoldSamples( 0.0 ),
+    mPeriodSum( 0 ),
+    mHighSum( 0 ),
+    mBits( 0 ),
+    mViolations( 0 ),
+    mPackets( 0 )
+{
+}
+
+RFFETiming::~RFFETiming()
+{
+}
+
+void RFFETiming::Start( const RFFEAnalyzerSettings* settings, U32 sample_rate_hz )
+{
+    mSampleRateHz    = double( sample_rate_hz );
+    mMaxSclkHz       = settings->mMaxSclkKHz * 1000.0;
+    mMaxReadSclkHz   = settings->mMaxReadSclkKHz * 1000.0;
+    mBusSclkHz       = settings->GetBusSclkHz();
+    mMinSetupSamples = settings->mMinSetupNs * mSampleRateHz / 1e9;
+    mMinHoldSamples  = settings->mMinHoldNs * mSampleRateHz / 1e9;
+
+    mSclkFrequency.Reset();
+    mDutyCycle.Reset();
+    mSetup.Reset();
+    mHold.Reset();
+    mPackets = 0;
+    for ( U32 i = 0; i < 3; i++ )
+    {
+        mViolatingPackets[i] = 0;
+    }
+    StartPacket();
+}
+
+void RFFETiming::SetBusSclkHz( U32 sclk_hz )
+{
+    mBusSclkHz = sclk_hz;
+}
+
+void RFFETiming::StartPacket()
+{
+    mPeriodSum  = 0;
+    mHighSum    = 0;
+    mBits       = 0;
+    mViolations = 0;
+}
+
+// one sampled bit: SCLK rises, falls (SDATA sampled) and rises again.
+// setup_edge is the last SDATA transition before the falling edge and
+// hold_edge the first one after it, RFFE_NO_EDGE when there was none.
+U8 RFFETiming::AddBit( U64 rising, U64 falling, U64 next_rising, U64 setup_edge, U64 hold_edge )
+{
+    U8 violations = 0;
+    U64 high = falling - rising;
+
+    mPeriodSum += next_rising - rising;
+    mHighSum   += high;
+    mBits++;
+
+    if ( setup_edge != RFFE_NO_EDGE )
+    {
+        double setup = double( falling - setup_edge );
+        mSetup.Add( setup );
+        if ( setup < mMinSetupSamples )
+            violations |= ViolationSetup;
+    }
+
+    // a transition after the next falling edge belongs to the next bit
+    if ( hold_edge != RFFE_NO_EDGE && hold_edge < next_rising + high )
+    {
+        double hold = double( hold_edge - falling );
+        mHold.Add( hold );
+        if ( hold < mMinHoldSamples )
+            violations |= ViolationHold;
+    }
+
+    mViolations |= violations;
+    return violations;
+}
+
+void RFFETiming::EndPacket( RFFEPacket& packet )
+{
+    double frequency;
+    double limit;
+
+    if ( mBits == 0 || mPeriodSum == 0 )
+    {
+        packet.mSclkFrequency    = 0;
+        packet.mDutyCycle        = 0;
+        packet.mTimingViolations = 0;
+        return;
+    }
+
+    // reads may be limited to half speed
+    frequency = mSampleRateHz * mBits / double( mPeriodSum );
+    switch ( packet.mType )
+    {
+    case RFFEAnalyzerResults::RffeTypeExtRead:
+    case RFFEAnalyzerResults::RffeTypeExtLongRead:
+    case RFFEAnalyzerResults::RffeTypeNormalRead:
+        limit = mMaxReadSclkHz;
+        break;
+    default:
+        limit = mMaxSclkHz;
+        break;
+    }
+    if ( limit == 0.0 )
+    {
+        limit = mBusSclkHz * RFFE_TIMING_BUS_SCLK_TOLERANCE;
+    }
+    if ( limit > 0.0 && frequency > limit )
+    {
+        mViolations |= ViolationSclkFrequency;
+    }
+
+    packet.mSclkFrequency    = U32( frequency + 0.5 );
+    packet.mDutyCycle        = U8( ( 100 * mHighSum + mPeriodSum / 2 ) / mPeriodSum );
+    packet.mTimingViolations = mViolations;
+
+    mSclkFrequency.Add( frequency );
+    mDutyCycle.Add( 100.0 * mHighSum / double( mPeriodSum ) );
+    mPackets++;
+    for ( U32 i = 0; i < 3; i++ )
+    {
+        if ( mViolations & ( 1 << i ) )
+            mViolatingPackets[i]++;
+    }
+}
+
+void RFFETiming::Describe( std::ostream& os, const char* name, const Statistic& stat, const char* unit, double scale )
+{
+    os << name;
+    if ( stat.mCount == 0 )
+    {
+        os << "not measured" << std::endl;
+        return;
+    }
+    os << "min " << stat.mMin * scale
+       << "  avg " << stat.mSum / stat.mCount * scale
+       << "  max " << stat.mMax * scale
+       << " " << unit << "  (" << stat.mCount << ")" << std::endl;
+}
+
+void RFFETiming::Finish( const char* report_file, U32 detected_sclk_hz )
+{
+    std::stringstream ss;
+    double ns_per_sample = 1e9 / mSampleRateHz;
+
+    if ( report_file == NULL || report_file[0] == '\0' )
+    {
+        return;
+    }
+
+    ss << "RFFE SCLK/SDATA timing" << std::endl;
+    ss << "sample rate:        " << mSampleRateHz / 1e6 << " MHz" << std::endl;
+    ss << "detected SCLK:      " << detected_sclk_hz / 1e6 << " MHz" << std::endl;
+    ss << "packets:            " << mPackets << std::endl;
+    Describe( ss, "SCLK frequency:     ", mSclkFrequency, "MHz", 1e-6 );
+    Describe( ss, "SCLK duty cycle:    ", mDutyCycle, "%", 1.0 );
+    Describe( ss, "SDATA setup:        ", mSetup, "ns", ns_per_sample );
+    Describe( ss, "SDATA hold:         ", mHold, "ns", ns_per_sample );
+    ss << "SCLK too fast:      " << mViolatingPackets[0] << " packets" << std::endl;
+    ss << "setup violations:   " << mViolatingPackets[1] << " packets" << std::endl;
+    ss << "hold violations:    " << mViolatingPackets[2] << " packets" << std::endl;
+
+    void* f = AnalyzerHelpers::StartFile( report_file );
+    AnalyzerHelpers::AppendToFile( (U8*)ss.str().c_str(), (U32)ss.str().length(), f );
+    AnalyzerHelpers::EndFile( f );
+}
+
+RFFESclkDetector::RFFESclkDetector()
+{
+    Reset();
+}
+
+void RFFESclkDetector::Reset()
+{
+    mCount   = 0;
+    mPackets = 0;
+    mSclkHz  = 0;
+    mDone    = false;
+}
+
+void RFFESclkDetector::AddBit( U64 high, U64 low )
+{
+    if ( mCount + 2 <= RFFE_SCLK_DETECT_HALF_PERIODS )
+    {
+        mHalfPeriods[mCount++] = high;
+        mHalfPeriods[mCount++] = low;
+    }
+}
+
+bool RFFESclkDetector::EndPacket( U32 sample_rate_hz )
+{
+    if ( ++mPackets < RFFE_SCLK_DETECT_PACKETS && mCount < RFFE_SCLK_DETECT_HALF_PERIODS )
+    {
+        return false;
+    }
+
+    // the median ignores half speed reads and the odd stretched cycle
+    U64* median = mHalfPeriods + mCount / 2;
+    std::nth_element( mHalfPeriods, median, mHalfPeriods + mCount );
+    if ( mCount != 0 && *median != 0 )
+    {
+        mSclkHz = U32( ( sample_rate_hz + *median ) / ( 2 * *median ) );
+    }
+    mDone = true;
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef RFFE_TIMING
+#define RFFE_TIMING
+
+#include <LogicPublicTypes.h>
+#include <iosfwd>
+#include "RFFEPacket.h"
+
+class RFFEAnalyzerSettings;
+
+// setup/hold edge argument of RFFETiming::AddBit when SDATA did not toggle
+#define RFFE_NO_EDGE    U64( -1 )
+
+// SCLK frequency, duty cycle and SDATA setup/hold margins, measured from the
+// edges the decoder visits while sampling a packet. Limits come from the
+// settings; packets and bits breaking them are flagged.
+
+// SCLK limit over the bus SCLK when a "Max SCLK" setting is 0
+#define RFFE_TIMING_BUS_SCLK_TOLERANCE  1.1
+class RFFETiming
+{
+public:
+    enum Violation
+    {
+        ViolationSclkFrequency = 0x01,
+        ViolationSetup         = 0x02,
+        ViolationHold          = 0x04,
+    };
+
+    RFFETiming();
+    ~RFFETiming();
+
+    void Start( const RFFEAnalyzerSettings* settings, U32 sample_rate_hz );
+    void SetBusSclkHz( U32 sclk_hz );     // configured or detected, 0: not known
+    void StartPacket();
+    U8   AddBit( U64 rising, U64 falling, U64 next_rising, U64 setup_edge, U64 hold_edge );
+    void EndPacket( RFFEPacket& packet );
+    void Finish( const char* report_file, U32 detected_sclk_hz );
+
+protected: // types
+    // min/avg/max of a measured quantity
+    struct Statistic
+    {
+        void Reset();
+        void Add( double value );
+
+        double mMin;
+        double mMax;
+        double mSum;
+        U64 mCount;
+    };
+
+protected: // functions
+    void Describe( std::ostream& os, const char* name, const Statistic& stat, const char* unit, double scale );
+
+protected: // vars
+    double mSampleRateHz;
+    double mMaxSclkHz;
+    double mMaxReadSclkHz;
+    double mBusSclkHz;
+    double mMinSetupSamples;
+    double mMinHoldSamples;
+
+    // packet being decoded
+    U64 mPeriodSum;
+    U64 mHighSum;
+    U32 mBits;
+    U8  mViolations;
+
+    Statistic mSclkFrequency;
+    Statistic mDutyCycle;
+    Statistic mSetup;
+    Statistic mHold;
+    U64 mPackets;
+    U64 mViolatingPackets[3];
+};
+
+// half periods collected for the SCLK rate estimate
+#define RFFE_SCLK_DETECT_PACKETS        8
+#define RFFE_SCLK_DETECT_HALF_PERIODS   256
+
+// Estimates the bus SCLK frequency from the median half period of the
+// first packets' bits. Fed by the decoder as it goes, so it costs no pass
+// over the channel data of its own.
+class RFFESclkDetector
+{
+public:
+    RFFESclkDetector();
+
+    void Reset();
+    void Skip() { mDone = true; }           // the rate is known already
+    bool IsDone() const { return mDone; }
+    void AddBit( U64 high, U64 low );
+    bool EndPacket( U32 sample_rate_hz );  // true once the estimate is ready
+    U32  GetSclkHz() const { return mSclkHz; }
+
+protected:
+    U64 mHalfPeriods[RFFE_SCLK_DETECT_HALF_PERIODS];
+    U32 mCount;
+    U32 mPackets;
+    U32 mSclkHz;
+    bool mDone;
+};
+
+#endif //RFFE_TIMING
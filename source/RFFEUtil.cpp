@@ -1,11 +1,17 @@
 #include "RFFEUtil.h"
 
-RFFEAnalyzerResults::RffeTypeFieldType  RFFEUtil::decodeRFFECmdFrame(U8 cmd)
+// v2 selects the RFFE v2.x command set, which gives some of the commands
+// v1.0 reserves a meaning
+RFFEAnalyzerResults::RffeTypeFieldType  RFFEUtil::decodeRFFECmdFrame(U8 cmd, bool v2)
 {
     if ( cmd  < 0x10 )
     {
         return RFFEAnalyzerResults::RffeTypeExtWrite;
     }
+    else if ( v2 && cmd == RFFE_CMD_MASKED_WRITE )
+    {
+        return RFFEAnalyzerResults::RffeTypeMaskedWrite;
+    }
     else if ( (cmd >= 0x10) && (cmd < 0x20) )
     {
         return RFFEAnalyzerResults::RffeTypeReserved;
@@ -40,3 +46,43 @@ U8 RFFEUtil::byteCount(U8 cmd)
 {
     return (cmd < 0x30) ? (cmd & 0x0F) : (cmd & 0x07);
 }
+
+// SCLK cycles following the command frame, from its parity bit up to but
+// excluding the closing bus park; lets a filtered packet be skipped by
+// counting clock edges instead of sampling SDATA
+U32 RFFEUtil::bitCount(U8 cmd, bool v2)
+{
+    U32 data = 9 * ( byteCount( cmd ) + 1 );
+
+    switch ( decodeRFFECmdFrame( cmd, v2 ) )
+    {
+    case RFFEAnalyzerResults::RffeTypeExtWrite:
+        return 1 + 9 + data;
+    case RFFEAnalyzerResults::RffeTypeExtRead:
+        return 1 + 9 + 1 + data;
+    case RFFEAnalyzerResults::RffeTypeExtLongWrite:
+        return 1 + 18 + data;
+    case RFFEAnalyzerResults::RffeTypeExtLongRead:
+        return 1 + 18 + 1 + data;
+    case RFFEAnalyzerResults::RffeTypeNormalWrite:
+        return 1 + 9;
+    case RFFEAnalyzerResults::RffeTypeNormalRead:
+        return 1 + 1 + 9;
+    case RFFEAnalyzerResults::RffeTypeMaskedWrite:
+        return 1 + 27;
+    default:
+        return 1;
+    }
+}
+
+// RFFE frames use odd parity: frame bits plus parity bit hold an odd number of ones
+bool RFFEUtil::isParityOk(U64 frame, U8 parity)
+{
+    U32 ones = parity & 1;
+
+    for ( ; frame != 0; frame &= frame - 1 )
+    {
+        ones++;
+    }
+    return ( ones & 1 ) == 1;
+}
@@ -5,11 +5,16 @@
 #include <AnalyzerTypes.h>
 #include "RFFEAnalyzerResults.h"
 
+// RFFE v2.x command frames in the range v1.0 reserves (0x10-0x1F)
+#define RFFE_CMD_MASKED_WRITE   0x19
+
 class RFFEUtil
 {
 public:
-    static RFFEAnalyzerResults::RffeTypeFieldType decodeRFFECmdFrame(U8 cmd);
+    static RFFEAnalyzerResults::RffeTypeFieldType decodeRFFECmdFrame(U8 cmd, bool v2);
     static U8 byteCount(U8 cmd);
+    static U32 bitCount(U8 cmd, bool v2);
+    static bool isParityOk(U64 frame, U8 parity);
 };
 
 #endif //RFFE_UTIL